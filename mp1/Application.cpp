@@ -35,6 +35,10 @@ int main(int argc, char *argv[]) {
 	Application *app = new Application(argv[1]);
 	// Call the run function
 	app->run();
+	// The most memory the run held at once, in kB
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	cout << "Peak RSS: " << usage.ru_maxrss << " kB" << endl;
 	// When done delete the application object
 	delete(app);
 
@@ -47,8 +51,10 @@ int main(int argc, char *argv[]) {
 Application::Application(char *infile) {
 	int i;
 	par = new Params();
-	srand (time(NULL));
 	par->setparams(infile);
+	// Running again with `SEED: <seed>` in the test file repeats this run.
+	cout << "Seed: " << par->SEED << endl;
+	rng = new Random(par->SEED, RANDOM_WORKLOAD, 0);
 	log = new Log(par);
 	en = new EmulNet(par);
 	mp1 = (MP1Node **) malloc(par->EN_GPSZ * sizeof(MP1Node *));
@@ -79,6 +85,7 @@ Application::~Application() {
 		delete mp1[i];
 	}
 	free(mp1);
+	delete rng;
 	delete par;
 }
 
@@ -93,10 +100,9 @@ int Application::run()
 	int timeWhenAllNodesHaveJoined = 0;
 	// boolean indicating if all nodes have joined
 	bool allNodesJoined = false;
-	srand(time(NULL));
 
 	// As time runs along
-	for( par->globaltime = 0; par->globaltime < TOTAL_RUNNING_TIME; ++par->globaltime ) {
+	for( par->globaltime = 0; par->globaltime < par->TOTAL_RUNNING_TIME; ++par->globaltime ) {
 		// Run the membership protocol
 		mp1Run();
 		// Fail some nodes
@@ -183,14 +189,14 @@ void Application::fail() {
 	}
 
 	if( par->SINGLE_FAILURE && par->getcurrtime() == 100 ) {
-		removed = (rand() % par->EN_GPSZ);
+		removed = (int)rng->below(par->EN_GPSZ);
 		#ifdef DEBUGLOG
 		log->LOG(&mp1[removed]->getMemberNode()->addr, "Node failed at time=%d", par->getcurrtime());
 		#endif
 		mp1[removed]->getMemberNode()->bFailed = true;
 	}
 	else if( par->getcurrtime() == 100 ) {
-		removed = rand() % par->EN_GPSZ/2;
+		removed = (int)rng->below(par->EN_GPSZ/2);
 		for ( i = removed; i < removed + par->EN_GPSZ/2; i++ ) {
 			#ifdef DEBUGLOG
 			log->LOG(&mp1[i]->getMemberNode()->addr, "Node failed at time = %d", par->getcurrtime());
@@ -18,13 +18,12 @@
 /**
  * global variables
  */
-int nodeCount = 0;
+long nodeCount = 0;
 
 /*
  * Macros
  */
 #define ARGS_COUNT 2
-#define TOTAL_RUNNING_TIME 700
 
 /**
  * CLASS NAME: Application
@@ -40,6 +39,8 @@ private:
     Log *log;
 	MP1Node **mp1;
 	Params *par;
+	// Draws the nodes to fail.
+	Random *rng;
 public:
 	Application(char *);
 	virtual ~Application();
@@ -0,0 +1,239 @@
+/**********************************
+ * FILE NAME: Bench.cpp
+ *
+ * DESCRIPTION: Benchmarks for the hot paths of the membership protocol.
+ *              Build with `make bench` and run `./Bench`.
+ **********************************/
+
+#include "stdincludes.h"
+#include "Params.h"
+#include "Member.h"
+#include "EmulNet.h"
+#include "Log.h"
+#include "MP1Node.h"
+#include "Queue.h"
+#include <chrono>
+#include <new>
+
+/**
+ * Heap allocations so far. The Bench target links with --wrap for malloc,
+ * calloc and realloc, so every allocation of our objects goes through the
+ * wrappers below, and operator new is replaced to allocate with malloc.
+ */
+static unsigned long allocations = 0;
+
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size) {
+	allocations++;
+	return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+	allocations++;
+	return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size) {
+	allocations++;
+	return __real_realloc(ptr, size);
+}
+}
+
+void *operator new(size_t size) {
+	void *ptr = malloc(size ? size : 1);
+	if ( ptr == NULL ) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void operator delete(void *ptr) noexcept {
+	free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+	free(ptr);
+}
+
+/**
+ * CLASS NAME: Stopwatch
+ *
+ * DESCRIPTION: Time and allocations spent between start() and stop(),
+ *              summed over every such interval, printed per operation.
+ */
+class Stopwatch {
+private:
+	std::chrono::nanoseconds time;
+	unsigned long allocs;
+	std::chrono::steady_clock::time_point started;
+	unsigned long allocsStarted;
+public:
+	Stopwatch(): time(0), allocs(0), allocsStarted(0) {}
+	void start() {
+		allocsStarted = allocations;
+		started = std::chrono::steady_clock::now();
+	}
+	void stop() {
+		time += std::chrono::steady_clock::now() - started;
+		allocs += allocations - allocsStarted;
+	}
+	void print(const string &name, long ops) {
+		printf("%-44s %10ld %12.1f %12.2f\n", name.c_str(), ops,
+		       (double)time.count() / ops, (double)allocs / ops);
+	}
+};
+
+/**
+ * FUNCTION NAME: createParams
+ *
+ * DESCRIPTION: Parameters of a benchmark run, without a test file
+ */
+Params *createParams(int numNodes) {
+	Params *par = new Params();
+	par->MAX_NNB = numNodes;
+	par->setNodeCount(numNodes);
+	par->MSG_DROP_PROB = 0;
+	par->dropmsg = 0;
+	par->SEED = 0;
+	par->globaltime = 0;
+	return par;
+}
+
+/**
+ * FUNCTION NAME: benchSendRecv
+ *
+ * DESCRIPTION: Measures ENsend and ENrecv on their own, with `numNodes`
+ *              nodes each sending 10 `payloadSize` byte messages to random
+ *              peers per tick.
+ */
+void benchSendRecv(int numNodes, int payloadSize) {
+	const int ticks = 20;
+	const int msgsPerNode = 10;
+	Params *par = createParams(numNodes);
+	EmulNet *en = new EmulNet(par);
+	vector<Address> addrs(numNodes);
+	for ( int i = 0; i < numNodes; i++ ) {
+		en->ENinit(&addrs[i], par->PORTNUM);
+	}
+
+	vector<char> payload(payloadSize, 'x');
+	queue<q_elt> received;
+	Stopwatch send;
+	Stopwatch recv;
+	long sent = 0;
+	long delivered = 0;
+	for ( par->globaltime = 0; par->globaltime < ticks; par->globaltime++ ) {
+		send.start();
+		for ( int i = 0; i < numNodes; i++ ) {
+			for ( int m = 0; m < msgsPerNode; m++ ) {
+				en->ENsend(&addrs[i], &addrs[rand() % numNodes], payload.data(),
+				           payloadSize);
+			}
+		}
+		send.stop();
+		sent += numNodes * msgsPerNode;
+
+		recv.start();
+		for ( int i = 0; i < numNodes; i++ ) {
+			en->ENrecv(&addrs[i], MP1Node::enqueueWrapper, NULL, 1, &received);
+			while ( !received.empty() ) {
+				free(received.front().elt);
+				received.pop();
+				delivered++;
+			}
+		}
+		recv.stop();
+	}
+
+	string size = " " + to_string(numNodes) + " nodes " +
+	              to_string(payloadSize) + " B";
+	send.print("EmulNet::ENsend" + size, sent);
+	recv.print("EmulNet::ENrecv per msg" + size, delivered);
+	delete en;
+	delete par;
+}
+
+/**
+ * FUNCTION NAME: benchGossip
+ *
+ * DESCRIPTION: Measures building a GossipMessage of `numNodes` members and
+ *              handling it at a node that knows all of them, as
+ *              MP1Node::handleGossipMessage does for every gossip received
+ *              (through recvCallBack, the only way in).
+ */
+void benchGossip(int numNodes, Log *log) {
+	const long rounds = 200;
+	Params *par = createParams(numNodes + 1);
+	EmulNet *en = new EmulNet(par);
+	Member *member = new Member();
+	Address addr;
+	en->ENinit(&addr, par->PORTNUM);
+	MP1Node *node = new MP1Node(member, par, en, log, &addr);
+	node->nodeStart(NULL, par->PORTNUM);
+
+	Address senderAddr;
+	en->ENinit(&senderAddr, par->PORTNUM);
+	vector<MemberListEntry> memberList;
+	for ( int id = 1; id <= numNodes; id++ ) {
+		memberList.push_back(MemberListEntry(id, 0, 1, 0));
+	}
+	string suffix = " " + to_string(numNodes) + " members";
+
+	Stopwatch build;
+	build.start();
+	for ( long r = 0; r < rounds; r++ ) {
+		GossipMessage msg(&senderAddr, memberList);
+	}
+	build.stop();
+	build.print("GossipMessage build" + suffix, rounds);
+
+	// Learn every member once, then every round brings new heartbeats.
+	GossipMessage first(&senderAddr, memberList);
+	node->recvCallBack(NULL, first.getMessage(), first.getMessageSize());
+	Stopwatch handle;
+	for ( long r = 0; r < rounds; r++ ) {
+		for ( size_t i = 0; i < memberList.size(); i++ ) {
+			memberList[i].setheartbeat(r + 2);
+		}
+		GossipMessage msg(&senderAddr, memberList);
+		handle.start();
+		node->recvCallBack(NULL, msg.getMessage(), msg.getMessageSize());
+		handle.stop();
+	}
+	handle.print("MP1Node::handleGossipMessage" + suffix, rounds);
+	delete node;
+	delete member;
+	delete en;
+	delete par;
+}
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: Runs every benchmark over a few cluster sizes
+ **********************************/
+int main() {
+	srand(0);
+	// The protocol logs to dbg.log as it does in a run (DEBUGLOG).
+	Params *logPar = createParams(1);
+	Log *log = new Log(logPar);
+
+	printf("Hot paths, each on its own\n");
+	printf("%-44s %10s %12s %12s\n", "operation", "ops", "ns/op", "allocs/op");
+	int nodeCounts[] = {10, 100, 1000};
+	for ( int numNodes : nodeCounts ) {
+		benchSendRecv(numNodes, 64);
+	}
+	int memberCounts[] = {10, 100, 250};
+	for ( int numNodes : memberCounts ) {
+		benchGossip(numNodes, log);
+	}
+
+	delete log;
+	delete logPar;
+	return SUCCESS;
+}
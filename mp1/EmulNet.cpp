@@ -14,17 +14,10 @@
 EmulNet::EmulNet(Params *p)
 {
 	//trace.funcEntry("EmulNet::EmulNet");
-	int i,j;
 	par = p;
 	emulnet.setNextId(1);
 	emulnet.settCurrBuffSize(0);
 	enInited=0;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			sent_msgs[i][j] = 0;
-			recv_msgs[i][j] = 0;
-		}
-	}
 	//trace.funcExit("EmulNet::EmulNet", SUCCESS);
 }
 
@@ -32,32 +25,22 @@ EmulNet::EmulNet(Params *p)
  * Copy constructor
  */
 EmulNet::EmulNet(EmulNet &anotherEmulNet) {
-	int i, j;
 	this->par = anotherEmulNet.par;
 	this->enInited = anotherEmulNet.enInited;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			this->sent_msgs[i][j] = anotherEmulNet.sent_msgs[i][j];
-			this->recv_msgs[i][j] = anotherEmulNet.recv_msgs[i][j];
-		}
-	}
+	this->msgCounts = anotherEmulNet.msgCounts;
 	this->emulnet = anotherEmulNet.emulnet;
+	this->rngs = anotherEmulNet.rngs;
 }
 
 /**
  * Assignment operator overloading
  */
 EmulNet& EmulNet::operator =(EmulNet &anotherEmulNet) {
-	int i, j;
 	this->par = anotherEmulNet.par;
 	this->enInited = anotherEmulNet.enInited;
-	for ( i = 0; i < MAX_NODES; i++ ) {
-		for ( j = 0; j < MAX_TIME; j++ ) {
-			this->sent_msgs[i][j] = anotherEmulNet.sent_msgs[i][j];
-			this->recv_msgs[i][j] = anotherEmulNet.recv_msgs[i][j];
-		}
-	}
+	this->msgCounts = anotherEmulNet.msgCounts;
 	this->emulnet = anotherEmulNet.emulnet;
+	this->rngs = anotherEmulNet.rngs;
 	return *this;
 }
 
@@ -92,9 +75,11 @@ void *EmulNet::ENinit(Address *myaddr, short port) {
 int EmulNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size) {
 	en_msg *em;
 	static char temp[2048];
-	int sendmsg = rand() % 100;
+	int src = *(int *)(myaddr->addr);
+	int dst = *(int *)(toaddr->addr);
 
-	if( (emulnet.currbuffsize >= ENBUFFSIZE) || (size + (int)sizeof(en_msg) >= par->MAX_MSG_SIZE) || (par->dropmsg && sendmsg < (int) (par->MSG_DROP_PROB * 100)) ) {
+	// A destination that is not a node id would index outside the mailboxes.
+	if( (dst <= 0 || dst > par->EN_GPSZ) || (emulnet.currbuffsize >= par->EN_BUFFSIZE) || (size + (int)sizeof(en_msg) >= par->MAX_MSG_SIZE) || (par->dropmsg && (int)rngOf(src).below(100) < (int) (par->MSG_DROP_PROB * 100)) ) {
 		return 0;
 	}
 
@@ -105,15 +90,12 @@ int EmulNet::ENsend(Address *myaddr, Address *toaddr, char *data, int size) {
 	memcpy(&(em->to.addr), &(toaddr->addr), sizeof(em->from.addr));
 	memcpy(em + 1, data, size);
 
-	emulnet.buff[emulnet.currbuffsize++] = em;
+	emulnet.mailbox(dst).push_back(em);
+	emulnet.currbuffsize++;
 
-	int src = *(int *)(myaddr->addr);
 	int time = par->getcurrtime();
 
-	assert(src <= MAX_NODES);
-	assert(time < MAX_TIME);
-
-	sent_msgs[src][time]++;
+	msgCounts.countSent(src, time, size);
 
 	#ifdef DEBUGLOG
 		sprintf(temp, "Sending 4+%d B msg type %d to %d.%d.%d.%d:%d ", size-4, *(int *)data, toaddr->addr[0], toaddr->addr[1], toaddr->addr[2], toaddr->addr[3], *(short *)&toaddr->addr[4]);
@@ -148,36 +130,34 @@ int EmulNet::ENsend(Address *myaddr, Address *toaddr, string data) {
  */
 int EmulNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct timeval *t, int times, void *queue){
 	// times is always assumed to be 1
-	int i;
+	size_t i;
 	char* tmp;
 	int sz;
 	en_msg *emsg;
+	int dst = *(int *)(myaddr->addr);
 
-	for( i = emulnet.currbuffsize - 1; i >= 0; i-- ) {
-		emsg = emulnet.buff[i];
-
-    // If the to address of the message matches the address of the node.
-		if ( 0 == strcmp(emsg->to.addr, myaddr->addr) ) {
-			sz = emsg->size;
-			tmp = (char *) malloc(sz * sizeof(char));
-			memcpy(tmp, (char *)(emsg+1), sz);
-
-			emulnet.buff[i] = emulnet.buff[emulnet.currbuffsize-1];
-			emulnet.currbuffsize--;
+	if ( dst < 0 || dst >= (int)emulnet.mailboxes.size() ) {
+		return 0;
+	}
 
-			(*enq)(queue, (char *)tmp, sz);
+	// Messages are delivered in the order they were sent.
+	vector<en_msg *> &mailbox = emulnet.mailboxes[dst];
+	int time = par->getcurrtime();
 
-			free(emsg);
+	for( i = 0; i < mailbox.size(); i++ ) {
+		emsg = mailbox[i];
+		sz = emsg->size;
+		tmp = (char *) malloc(sz * sizeof(char));
+		memcpy(tmp, (char *)(emsg+1), sz);
 
-			int dst = *(int *)(myaddr->addr);
-			int time = par->getcurrtime();
+		(*enq)(queue, (char *)tmp, sz);
 
-			assert(dst <= MAX_NODES);
-			assert(time < MAX_TIME);
+		free(emsg);
 
-			recv_msgs[dst][time]++;
-		}
+		msgCounts.countRecv(dst, time, sz);
 	}
+	emulnet.currbuffsize -= mailbox.size();
+	mailbox.clear();
 
 	return 0;
 }
@@ -190,37 +170,63 @@ int EmulNet::ENrecv(Address *myaddr, int (* enq)(void *, char *, int), struct ti
 int EmulNet::ENcleanup() {
 	emulnet.nextid=0;
 	int i, j;
+	int sent, recv;
 	int sent_total, recv_total;
+	size_t sent_bytes, recv_bytes;
 
 	FILE* file = fopen("msgcount.log", "w+");
 
-	while(emulnet.currbuffsize > 0) {
-		free(emulnet.buff[--emulnet.currbuffsize]);
+	for ( i = 0; i < (int)emulnet.mailboxes.size(); i++ ) {
+		for ( j = 0; j < (int)emulnet.mailboxes[i].size(); j++ ) {
+			free(emulnet.mailboxes[i][j]);
+		}
+		emulnet.mailboxes[i].clear();
 	}
+	emulnet.currbuffsize = 0;
 
 	for ( i = 1; i <= par->EN_GPSZ; i++ ) {
 		fprintf(file, "node %3d ", i);
 		sent_total = 0;
 		recv_total = 0;
+		sent_bytes = 0;
+		recv_bytes = 0;
 
 		for (j = 0; j < par->getcurrtime(); j++) {
 
-			sent_total += sent_msgs[i][j];
-			recv_total += recv_msgs[i][j];
+			sent = msgCounts.getSent(i, j);
+			recv = msgCounts.getRecv(i, j);
+			sent_total += sent;
+			recv_total += recv;
+			sent_bytes += msgCounts.getSentBytes(i, j);
+			recv_bytes += msgCounts.getRecvBytes(i, j);
 			if (i != 67) {
-				fprintf(file, " (%4d, %4d)", sent_msgs[i][j], recv_msgs[i][j]);
+				fprintf(file, " (%4d, %4d)", sent, recv);
 				if (j % 10 == 9) {
 					fprintf(file, "\n         ");
 				}
 			}
 			else {
-				fprintf(file, "special %4d %4d %4d\n", j, sent_msgs[i][j], recv_msgs[i][j]);
+				fprintf(file, "special %4d %4d %4d\n", j, sent, recv);
 			}
 		}
 		fprintf(file, "\n");
-		fprintf(file, "node %3d sent_total %6u  recv_total %6u\n\n", i, sent_total, recv_total);
+		fprintf(file, "node %3d sent_total %6u  recv_total %6u\n", i, sent_total, recv_total);
+		fprintf(file, "node %3d sent_bytes %8zu  recv_bytes %8zu\n\n", i, sent_bytes, recv_bytes);
 	}
 
 	fclose(file);
 	return 0;
 }
+
+/**
+ * FUNCTION NAME: rngOf
+ *
+ * DESCRIPTION: Returns the random stream of sender id `id`, creating the
+ *              streams up to it on first use
+ */
+Random &EmulNet::rngOf(int id) {
+	while ( id >= (int)rngs.size() ) {
+		rngs.push_back(Random(par->SEED, RANDOM_NETWORK, rngs.size()));
+	}
+	return rngs[id];
+}
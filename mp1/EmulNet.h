@@ -7,13 +7,10 @@
 #ifndef _EMULNET_H_
 #define _EMULNET_H_
 
-#define MAX_NODES 1000
-#define MAX_TIME 3600
-#define ENBUFFSIZE 30000
-
 #include "stdincludes.h"
 #include "Params.h"
 #include "Member.h"
+#include "Random.h"
 
 using namespace std;
 
@@ -31,13 +28,17 @@ typedef struct en_msg {
 
 /**
  * Class Name: EM
+ *
+ * In-flight messages are kept in a mailbox per destination node, indexed by
+ * the node id in the first 4 bytes of the address. A receive therefore only
+ * touches the messages addressed to the receiving node.
  */
 class EM {
 public:
 	int nextid;
 	int currbuffsize;
 	int firsteltindex;
-	en_msg* buff[ENBUFFSIZE];
+	vector<vector<en_msg *> > mailboxes;
 
 	EM() {}
 
@@ -46,11 +47,7 @@ public:
 		this->nextid = anotherEM.getNextId();
 		this->currbuffsize = anotherEM.getCurrBuffSize();
 		this->firsteltindex = anotherEM.getFirstEltIndex();
-		int i = this->currbuffsize;
-		while (i > 0) {
-			this->buff[i] = anotherEM.buff[i];
-			i--;
-		}
+		this->mailboxes = anotherEM.mailboxes;
 		return *this;
 	}
 
@@ -78,9 +75,90 @@ public:
 		this->firsteltindex = firsteltindex;
 	}
 
+	// returns the mailbox of node id, creating it if needed
+	vector<en_msg *>& mailbox(int id) {
+		if ( id >= (int)mailboxes.size() ) {
+			mailboxes.resize(id + 1);
+		}
+		return mailboxes[id];
+	}
+
 	virtual ~EM() {}
 };
 
+/**
+ * Class Name: MsgCounters
+ *
+ * Number of messages and bytes sent and received by each node in each tick,
+ * the bytes being the payload of the messages. A node only
+ * stores the ticks up to the last one it sent or received in, so the memory
+ * used follows the nodes and ticks of the run instead of a fixed maximum.
+ */
+class MsgCounters {
+public:
+	struct Count {
+		int sent;
+		int recv;
+		size_t sentBytes;
+		size_t recvBytes;
+	};
+
+	void countSent(int node, int time, int size) {
+		Count &c = at(node, time);
+		c.sent++;
+		c.sentBytes += size;
+	}
+
+	void countRecv(int node, int time, int size) {
+		Count &c = at(node, time);
+		c.recv++;
+		c.recvBytes += size;
+	}
+
+	int getSent(int node, int time) const {
+		const Count *c = find(node, time);
+		return c ? c->sent : 0;
+	}
+
+	int getRecv(int node, int time) const {
+		const Count *c = find(node, time);
+		return c ? c->recv : 0;
+	}
+
+	size_t getSentBytes(int node, int time) const {
+		const Count *c = find(node, time);
+		return c ? c->sentBytes : 0;
+	}
+
+	size_t getRecvBytes(int node, int time) const {
+		const Count *c = find(node, time);
+		return c ? c->recvBytes : 0;
+	}
+
+private:
+	// counts[node][time]
+	vector<vector<Count> > counts;
+
+	Count &at(int node, int time) {
+		assert(node >= 0 && time >= 0);
+		if ( node >= (int)counts.size() ) {
+			counts.resize(node + 1);
+		}
+		vector<Count> &ticks = counts[node];
+		if ( time >= (int)ticks.size() ) {
+			ticks.resize(time + 1, Count());
+		}
+		return ticks[time];
+	}
+
+	const Count *find(int node, int time) const {
+		if ( node < 0 || node >= (int)counts.size() || time < 0 || time >= (int)counts[node].size() ) {
+			return NULL;
+		}
+		return &counts[node][time];
+	}
+};
+
 /**
  * CLASS NAME: EmulNet
  *
@@ -90,10 +168,13 @@ class EmulNet
 {
 private:
 	Params* par;
-	int sent_msgs[MAX_NODES + 1][MAX_TIME];
-	int recv_msgs[MAX_NODES + 1][MAX_TIME];
+	MsgCounters msgCounts;
 	int enInited;
 	EM emulnet;
+	// Random stream of every sender id, for message drops.
+	vector<Random> rngs;
+
+	Random &rngOf(int id);
 public:
  	EmulNet(Params *p);
  	EmulNet(EmulNet &anotherEmulNet);
@@ -6,7 +6,6 @@
  **********************************/
 
 #include "MP1Node.h"
-#include <random>
 
 /*
  * Note: You can change/add any functions in MP1Node.{h,cpp}
@@ -151,7 +150,8 @@ short AddressHandler::portFromAddress(Address *addr)
  * You can add new members to the class if you think it
  * is necessary for your logic to work
  */
-MP1Node::MP1Node(Member *member, Params *params, EmulNet *emul, Log *log, Address *address) {
+MP1Node::MP1Node(Member *member, Params *params, EmulNet *emul, Log *log, Address *address):
+	rng(params->SEED, RANDOM_MEMBERSHIP, *(int *)address->addr) {
 	for( int i = 0; i < 6; i++ ) {
 		NULLADDR[i] = 0;
 	}
@@ -580,9 +580,7 @@ std::vector<MemberListEntry> MP1Node::getActiveNodes() {
 void MP1Node::sendGossip(std::vector<MemberListEntry>& activeNodes,
                          GossipMessage& gossipMsg)
 {
-	std::random_device rd;
-	std::mt19937 g(rd());
-	std::shuffle(activeNodes.begin(), activeNodes.end(), g);
+	std::shuffle(activeNodes.begin(), activeNodes.end(), rng);
 	int neighborsInGossip = (int)(gossipProp * activeNodes.size());
 
   char* msg = gossipMsg.getMessage();
@@ -119,6 +119,8 @@ private:
   double gossipProp;
   std::unordered_map<std::string, size_t> memTableIdx;
   std::string addrStr;
+  // Picks the gossip targets.
+  Random rng;
 
   void logEvent(const char* eventMsg, Address* addr);
   void logMsg(const char* msg);
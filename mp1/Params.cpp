@@ -26,19 +26,66 @@ void Params::setparams(char *config_file) {
 
 	//printf("Parameters of the test case: %d %d %d %lf\n", MAX_NNB, SINGLE_FAILURE, DROP_MSG, MSG_DROP_PROB);
 
-	EN_GPSZ = MAX_NNB;
+	setNodeCount(MAX_NNB);
 	STEP_RATE=.25;
-	MAX_MSG_SIZE = 4000;
+	TOTAL_RUNNING_TIME = DEFAULT_RUNNING_TIME;
+	// Runs differ unless the test file fixes the seed.
+	SEED = (unsigned long)time(NULL);
+
+	// Any remaining lines are optional `KEY: value` settings.
+	char key[64];
+	char value[256];
+	while ( fscanf(fp, " %63[^:]: %255s", key, value) == 2 ) {
+		setOptionalParam(key, value);
+	}
+
 	globaltime = 0;
 	dropmsg = 0;
 	allNodesJoined = 0;
-	for ( unsigned int i = 0; i < EN_GPSZ; i++ ) {
+	for ( int i = 0; i < EN_GPSZ; i++ ) {
 		allNodesJoined += i;
 	}
 	fclose(fp);
 	return;
 }
 
+/**
+ * FUNCTION NAME: setNodeCount
+ *
+ * DESCRIPTION: Sets the number of peers to `numNodes`, along with the
+ * 				defaults that grow with it.
+ */
+void Params::setNodeCount(int numNodes) {
+	EN_GPSZ = numNodes;
+	MAX_MSG_SIZE = max(DEFAULT_MSG_SIZE, MSG_BYTES_PER_NODE * EN_GPSZ);
+	EN_BUFFSIZE = max((long)DEFAULT_EN_BUFFSIZE,
+	                  (long)EN_BUFFSIZE_PER_NODE * EN_GPSZ);
+}
+
+/**
+ * FUNCTION NAME: setOptionalParam
+ *
+ * DESCRIPTION: Sets the optional parameter key from its string value.
+ * 				Unknown keys are reported and ignored.
+ */
+void Params::setOptionalParam(const char *key, const char *value) {
+	if ( 0 == strcmp(key, "SEED") ) {
+		SEED = strtoul(value, NULL, 10);
+	}
+	else if ( 0 == strcmp(key, "TOTAL_RUNNING_TIME") ) {
+		TOTAL_RUNNING_TIME = atoi(value);
+	}
+	else if ( 0 == strcmp(key, "EN_BUFFSIZE") ) {
+		EN_BUFFSIZE = atol(value);
+	}
+	else if ( 0 == strcmp(key, "MAX_MSG_SIZE") ) {
+		MAX_MSG_SIZE = atoi(value);
+	}
+	else {
+		cout << "Ignoring unknown parameter " << key << endl;
+	}
+}
+
 /**
  * FUNCTION NAME: getcurrtime
  *
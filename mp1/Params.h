@@ -13,6 +13,17 @@
 
 enum testTYPE { CREATE_TEST, READ_TEST, UPDATE_TEST, DELETE_TEST };
 
+/*
+ * Defaults of the optional parameters. Larger runs get MSG_BYTES_PER_NODE
+ * bytes of message per node, so a gossip message can list every node, and
+ * EN_BUFFSIZE_PER_NODE messages in flight per node.
+ */
+#define DEFAULT_RUNNING_TIME 700
+#define DEFAULT_EN_BUFFSIZE 30000
+#define EN_BUFFSIZE_PER_NODE 30
+#define DEFAULT_MSG_SIZE 4000
+#define MSG_BYTES_PER_NODE 32
+
 /**
  * CLASS NAME: Params
  *
@@ -23,16 +34,21 @@ public:
 	int MAX_NNB;                // max number of neighbors
 	int SINGLE_FAILURE;			// single/multi failure
 	double MSG_DROP_PROB;		// message drop probability
+	unsigned long SEED;			// seed of every Random stream
 	double STEP_RATE;		    // dictates the rate of insertion
 	int EN_GPSZ;			    // actual number of peers
 	int MAX_MSG_SIZE;
 	int DROP_MSG;
+	int TOTAL_RUNNING_TIME;		// ticks in the run
+	long EN_BUFFSIZE;			// max messages in flight
 	int dropmsg;
 	int globaltime;
-	int allNodesJoined;
+	long allNodesJoined;
 	short PORTNUM;
 	Params();
 	void setparams(char *);
+	void setNodeCount(int numNodes);
+	void setOptionalParam(const char *key, const char *value);
 	int getcurrtime();
 };
 
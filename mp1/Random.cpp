@@ -0,0 +1,36 @@
+/**********************************
+ * FILE NAME: Random.cpp
+ *
+ * DESCRIPTION: Definition of the seeded random number streams
+ **********************************/
+
+#include "Random.h"
+
+namespace {
+
+// Moves `x` along the splitmix64 sequence and returns its next output.
+uint64_t splitmix64(uint64_t& x)
+{
+	uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+}  // namespace
+
+/**
+ * Constructor
+ */
+Random::Random(uint64_t seed, RandomDomain domain, uint64_t index)
+{
+	// Every input goes through a full splitmix64 round before the next is
+	// added, so streams whose names differ in a single bit are unrelated.
+	uint64_t x = seed;
+	x = splitmix64(x) + (uint64_t)domain;
+	x = splitmix64(x) + index;
+	for (int i = 0; i < 4; i++)
+	{
+		s[i] = splitmix64(x);
+	}
+}
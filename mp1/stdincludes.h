@@ -28,6 +28,7 @@
 #include <fcntl.h>
 #include <execinfo.h>
 #include <signal.h>
+#include <sys/resource.h>
 #include <iostream>
 #include <vector>
 #include <map>
@@ -5,6 +5,8 @@
  **********************************/
 
 #include "Application.h"
+#include "Sweep.h"
+#include <chrono>
 
 /**********************************
  * FUNCTION NAME: main
@@ -13,70 +15,159 @@
  **********************************/
 int main(int argc, char *argv[]) {
   std::string usageString =
-	  "Incorrect Usage. Correct form: ./Application <test_file> [--debug]";
-
-	if (argc < 2 || argc > 3)
-	{
-		std::cout << usageString << std::endl;
-		return FAILURE;
-	}
+	  "Incorrect Usage. Correct form: ./Application <test_file>... [--debug] [--jobs <n>]";
 
 	bool debugMode = false;
-	if (argc == 3)
+	int jobs = std::max((int)std::thread::hardware_concurrency(), 1);
+	std::vector<std::string> testFiles;
+	for (int i = 1; i < argc; i++)
 	{
-		if (strcmp(argv[2], "--debug") == 0)
+		if (strcmp(argv[i], "--debug") == 0)
 		{
 			debugMode = true;
 		}
+		else if (strcmp(argv[i], "--jobs") == 0 && i + 1 < argc)
+		{
+			jobs = atoi(argv[++i]);
+		}
+		else if (argv[i][0] != '-')
+		{
+			testFiles.push_back(argv[i]);
+		}
 		else
 		{
-			std::cout << usageString << std::endl;
-			return FAILURE;
+			testFiles.clear();
+			break;
 		}
 	}
+	if (testFiles.empty())
+	{
+		std::cout << usageString << std::endl;
+		return FAILURE;
+	}
+
+	// Several test files run side by side, see Sweep.
+	if (testFiles.size() > 1)
+	{
+		return Sweep(testFiles, debugMode, jobs).run(std::cout);
+	}
 
 	// Create a new application object and run it.
-	std::unique_ptr<Application> app = std::make_unique<Application>(
-		argv[1], debugMode);
-	app->run();
+	try
+	{
+		std::unique_ptr<Application> app = std::make_unique<Application>(
+			testFiles[0].c_str(), debugMode);
+		app->run();
+	}
+	catch (const std::exception& e)
+	{
+		std::cout << e.what() << std::endl;
+		return FAILURE;
+	}
+
+	// The most memory the run held at once, in kB
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	std::cout << "Peak RSS: " << usage.ru_maxrss << " kB" << std::endl;
 
 	return SUCCESS;
 }
 
-size_t Application::nodeCount = 0;
 const char Application::alphanum[] =
 "0123456789"
 "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
 "abcdefghijklmnopqrstuvwxyz";
 
 /**
- * Constructor of the Application class
+ * Constructor of the Application class. The run prints to `out` and writes
+ * its logs to the directory `outputDir`, "" for the working directory.
  */
-Application::Application(char *inputFile, bool debugMode) {
+Application::Application(const char *inputFile, bool debugMode,
+                         std::ostream &out, const std::string &outputDir)
+	: out(out), nodeCount(0), startTime(0), timeWhenAllNodesHaveJoined(0),
+	  allNodesJoined(false), kvStore(false)
+{
 	int i;
 	par = std::make_shared<Params>();
-	srand (time(NULL));
 	par->setparams(inputFile);
+	par->outputDir = outputDir;
+	// Running again with `SEED: <seed>` in the test file repeats this run.
+	out << "Seed: " << par->SEED << std::endl;
+	rng = std::make_unique<Random>(par->SEED, RANDOM_WORKLOAD, 0);
+	firstNode = par->FIRST_NODE_ID - 1;
+	lastNode = firstNode + par->LOCAL_NODES;
+	checkHostedNodes();
+	if ((!par->CHECKPOINT_FILE.empty() || !par->RESUME_FILE.empty()) &&
+	    (par->TRANSPORT != TRANSPORT_EMULNET || par->COALESCE))
+	{
+		// Other transports hold messages the process cannot see.
+		throw std::runtime_error(
+			"CHECKPOINT_FILE and RESUME_FILE need TRANSPORT: EMULNET without COALESCE");
+	}
 	log = std::make_shared<Log>(par, debugMode);
-	en = std::make_shared<EmulNet>(par);
-	en1 = std::make_shared<EmulNet>(par);
+	en = createNetwork();
+	// Nodes release every message they handle, so the message bodies can be
+	// handed over without a copy.
+	en->setDeliveryMode(HANDOFF);
+	if (par->THREADS > 1 && par->TRANSPORT != TRANSPORT_EMULNET)
+	{
+		out << "THREADS needs TRANSPORT: EMULNET, running on one thread"
+		          << std::endl;
+	}
+	else if (par->THREADS > 1)
+	{
+		workers = std::make_unique<WorkerPool>(par->THREADS);
+		// Three lanes per worker, see processPhase.
+		en->setLanes(3 * par->THREADS);
+		log->setLanes(3 * par->THREADS);
+	}
+	if (par->TRANSPORT == TRANSPORT_EMULNET)
+	{
+		// The emulated network knows when every message arrives, so the nodes
+		// only need visiting when a message or one of their timers is due.
+		events = std::make_unique<EventQueue>(par->NUM_PEERS);
+	}
+	if (par->testType == WORKLOAD_TEST)
+	{
+		workload = std::make_unique<Workload>(*par);
+	}
+	runStart = -1;
+	if (!par->CAPTURE_FILE.empty())
+	{
+		// Both channels record to the same trace, see Replay.cpp.
+		en->setCapture(std::make_shared<TraceWriter>(
+			par->outputPath(par->CAPTURE_FILE)));
+	}
 	mp1 = std::vector<std::unique_ptr<MP1Node>>(par->NUM_PEERS);
 	mp2 = std::vector<std::unique_ptr<MP2Node>>(par->NUM_PEERS);
+	nodes = std::make_unique<NodeTable>(par->NUM_PEERS, par->STEP_RATE);
 
 	/*
-	 * Init all nodes
+	 * Init all nodes hosted by this process
 	 */
-	for( i = 0; i < par->NUM_PEERS; i++ ) {
+	for( i = firstNode; i < lastNode; i++ ) {
 		std::shared_ptr<Member> memberNode = std::make_shared<Member>();
 		memberNode->inited = false;
 		Address addressOfMemberNode = en->ENinit();
+		// Both protocols of the node share its address and network; their
+		// messages are kept apart by channel.
 		mp1[i] = std::make_unique<MP1Node>(
 			memberNode, *par, en, log, addressOfMemberNode);
 		mp2[i] = std::make_unique<MP2Node>(
-			memberNode, *par, en1, log, addressOfMemberNode);
+			memberNode, *par, en, log, addressOfMemberNode);
+		nodes->sync(i, *memberNode);
+		if (events)
+		{
+			events->schedule(nodes->startTime(i), i);
+		}
 		log->logDebug(&(mp1[i]->getMemberNode()->addr), "APP");
 		log->logDebug(&(mp2[i]->getMemberNode()->addr), "APP MP2");
 	}
+
+	if (!par->RESUME_FILE.empty())
+	{
+		loadCheckpoint();
+	}
 }
 
 /**
@@ -84,6 +175,69 @@ Application::Application(char *inputFile, bool debugMode) {
  */
 Application::~Application() {}
 
+/**
+ * FUNCTION NAME: checkHostedNodes
+ *
+ * DESCRIPTION: Checks that the nodes Params::FIRST_NODE_ID and LOCAL_NODES
+ *              give this process can run apart from the others.
+ *
+ * A process hosting only some of the nodes reaches the others through a
+ * transport shared between processes. The tests and workload issue their
+ * client calls from the process hosting node id 1, through its own nodes;
+ * the read and update tests also fail replicas, which may be in another
+ * process, so they need every node in one process.
+ */
+void Application::checkHostedNodes() {
+	if (firstNode < 0 || lastNode <= firstNode || lastNode > par->NUM_PEERS)
+	{
+		throw std::runtime_error(
+			"FIRST_NODE_ID and LOCAL_NODES name nodes outside of NODES");
+	}
+	if (hostsEveryNode())
+	{
+		return;
+	}
+	if (par->TRANSPORT == TRANSPORT_EMULNET)
+	{
+		throw std::runtime_error(
+			"FIRST_NODE_ID and LOCAL_NODES need TRANSPORT: UDP or SHM");
+	}
+	if (par->testType == READ_TEST || par->testType == UPDATE_TEST)
+	{
+		throw std::runtime_error(
+			"The READ and UPDATE tests fail nodes and need every node in one process");
+	}
+}
+
+/**
+ * FUNCTION NAME: hostsEveryNode
+ *
+ * DESCRIPTION: Whether every node of the run is in this process
+ */
+bool Application::hostsEveryNode() const {
+	return firstNode == 0 && lastNode == par->NUM_PEERS;
+}
+
+/**
+ * FUNCTION NAME: createNetwork
+ *
+ * DESCRIPTION: Creates the network selected by Params::TRANSPORT
+ */
+std::shared_ptr<EmulNet> Application::createNetwork()
+{
+	if (par->TRANSPORT == TRANSPORT_UDP)
+	{
+		return std::make_shared<UdpNet>(par, par->UDP_BASE_PORT,
+		                                par->FIRST_NODE_ID);
+	}
+	if (par->TRANSPORT == TRANSPORT_SHM)
+	{
+		return std::make_shared<ShmNet>(par, par->SHM_PREFIX,
+		                                par->FIRST_NODE_ID);
+	}
+	return std::make_shared<EmulNet>(par);
+}
+
 /**
  * FUNCTION NAME: run
  *
@@ -92,36 +246,87 @@ Application::~Application() {}
 int Application::run()
 {
 	int i;
-	int timeWhenAllNodesHaveJoined = 0;
-	// boolean indicating if all nodes have joined
-	bool allNodesJoined = false;
-	srand(time(NULL));
-
-	// As time runs along
-	for(par->globaltime = 0;
-      par->globaltime < Config::totalRunningTime;
-      ++par->globaltime)
+	int next;
+	std::chrono::steady_clock::time_point wallStart =
+		std::chrono::steady_clock::now();
+
+	// As time runs along, skipping the ticks in which nothing is due
+	for(par->globaltime = startTime;
+      par->globaltime < par->TOTAL_RUNNING_TIME;
+      par->globaltime = next)
   {
-		// Run the membership protocol
-		mp1Run();
+		wakeNodes();
+		if (workers)
+		{
+			recvPhase();
+		}
+		else
+		{
+			// Run the membership protocol
+			mp1Run();
+		}
 
 		// Wait for all nodes to join
-		if (par->allNodesJoined == Application::nodeCount && !allNodesJoined) {
+		if (par->allNodesJoined == nodeCount && !allNodesJoined) {
 			timeWhenAllNodesHaveJoined = par->getcurrtime();
 			allNodesJoined = true;
 		}
 		// We wait for a certain buffer period to allow all nodes to join.
-		if ( par->getcurrtime() > timeWhenAllNodesHaveJoined + 50 ) {
+		bool kvStoreBefore = kvStore;
+		kvStore = par->getcurrtime() > timeWhenAllNodesHaveJoined + 50;
+		if (kvStore && !kvStoreBefore)
+		{
+			// Every node builds its ring now.
+			wakeAllNodes();
+		}
+		if (workers)
+		{
+			processPhase(kvStore);
+		}
+		else if (kvStore) {
 			// Call the KV store functionalities
 			mp2Run();
 		}
+
+		// Recycle the network buffers delivered during this tick
+		en->ENtick();
+		scheduleWakeUps();
+
+		next = nextTick(kvStore, timeWhenAllNodesHaveJoined + 51);
+		// The last tick run by CHECKPOINT_TIME saves the state between it
+		// and the next.
+		if (!par->CHECKPOINT_FILE.empty() &&
+		    par->getcurrtime() <= par->CHECKPOINT_TIME &&
+		    par->CHECKPOINT_TIME < next)
+		{
+			saveCheckpoint(next);
+		}
+
+		// Processes sharing a cluster keep their ticks roughly in step.
+		if (par->TICK_USEC > 0)
+		{
+			std::this_thread::sleep_until(wallStart + std::chrono::microseconds(
+				(long long)(next - startTime) * par->TICK_USEC));
+		}
+	}
+
+	if (workload && runStart < 0)
+	{
+		reportLatencies("Load", par->insertTime);
+	}
+	else if (workload)
+	{
+		reportLatencies("Run", runStart);
+	}
+	else
+	{
+		reportLatencies("Test", par->insertTime);
 	}
 
 	// Clean up
 	en->ENcleanup();
-	en1->ENcleanup();
 
-	for(i=0;i<=par->NUM_PEERS-1;i++) {
+	for(i=firstNode;i<=lastNode-1;i++) {
 		 mp1[i]->finishUpThisNode();
 	}
 
@@ -134,45 +339,45 @@ int Application::run()
  * DESCRIPTION:	This function performs all the membership protocol functionalities
  */
 void Application::mp1Run() {
-	int i;
-
-	// For all the nodes in the system
-	for( i = 0; i <= par->NUM_PEERS-1; i++) {
+	// For all the nodes awake in this tick
+	for (int i : awake) {
 
 		/*
-		 * Receive messages from the network and queue them in the membership protocol queue
+		 * Receive messages from the network and queue them in the membership
+		 * protocol and KV store queues
 		 */
-		if(par->getcurrtime() > (int)(par->STEP_RATE*i) &&
-		   !(mp1[i]->getMemberNode()->failed) )
+		if (nodes->isRunning(i, par->getcurrtime()))
 		{
-			// Receive messages from the network and queue them
-			mp1[i]->recvLoop();
+			// Receive the messages of both channels in one pass
+			std::vector<q_elt> *inboxes[NUM_CHANNELS] = {
+				&mp1[i]->getInbox(), &mp2[i]->getInbox()};
+			en->ENrecvAll(nodes->address(i), inboxes);
 		}
 	}
 
-	// For all the nodes in the system
-	for(i = par->NUM_PEERS - 1; i >= 0; i--) {
+	// For all the nodes awake in this tick
+	for (auto it = awake.rbegin(); it != awake.rend(); it++) {
+		int i = *it;
 
 		/*
 		 * Introduce nodes into the distributed system
 		 */
-		if( par->getcurrtime() == (int)(par->STEP_RATE*i) ) {
+		if( par->getcurrtime() == nodes->startTime(i) ) {
 			// introduce the ith node into the system at time STEPRATE*i
 			mp1[i]->nodeStart(JOINADDR, par->PORTNUM);
-			std::cout << i;
-			std::cout << "-th introduced node is assigned with the address: ";
-			std::cout << mp1[i]->getMemberNode()->addr.getAddress() << std::endl;
-			Application::nodeCount += i;
+			nodes->sync(i, *mp1[i]->getMemberNode());
+			printIntroduction(i);
+			nodeCount += i;
 		}
 
 		/*
 		 * Handle all the messages in your queue and send heartbeats
 		 */
-		else if (par->getcurrtime() > (int)(par->STEP_RATE*i) &&
-		         !(mp1[i]->getMemberNode()->failed))
+		else if (nodes->isRunning(i, par->getcurrtime()))
 		{
 			// handle messages and send heartbeats
 			mp1[i]->nodeLoop();
+			nodes->sync(i, *mp1[i]->getMemberNode());
 			if ((i == 0) && (par->globaltime % 500 == 0))
 			{
 				log->unconditionalLog(
@@ -191,43 +396,54 @@ void Application::mp1Run() {
  * 				2) CRUD operations
  */
 void Application::mp2Run() {
-	int i;
-
-	// For all the nodes in the system
-	for (i = 0; i <= par->NUM_PEERS-1; i++)
+	// For all the nodes awake in this tick
+	for (int i : awake)
 	{
 		/*
-		 * 1) Update the ring
-		 * 2) Receive messages from the network and queue them in the KV store queue
+		 * Update the ring. The KV store messages were already queued by
+		 * mp1Run.
 		 */
-		if (par->getcurrtime() > (int)(par->STEP_RATE*i) &&
-		    !mp2[i]->getMemberNode()->failed)
+		if (nodes->isRunning(i, par->getcurrtime()) && nodes->isJoined(i))
 		{
-			if ( mp2[i]->getMemberNode()->inited && mp2[i]->getMemberNode()->inGroup)
-			{
-				// Step 1
-				mp2[i]->updateRing();
-			}
-			// Step 2
-			mp2[i]->recvLoop();
+			mp2[i]->updateRing();
 		}
 	}
 
 	/**
 	 * Handle messages from the queue and update the DHT
 	 */
-	for (i = par->NUM_PEERS-1; i >= 0; i--) {
-		if (par->getcurrtime() > (int)(par->STEP_RATE*i) &&
-		    !mp2[i]->getMemberNode()->failed)
+	for (auto it = awake.rbegin(); it != awake.rend(); it++) {
+		int i = *it;
+		if (nodes->isRunning(i, par->getcurrtime()))
 		{
 			mp2[i]->checkMessages();
 		}
 	}
 
+	kvTestRun();
+}
+
+/**
+ * FUNCTION NAME: kvTestRun
+ *
+ * DESCRIPTION: Inserts the test key value pairs and runs the CRUD tests
+ */
+void Application::kvTestRun() {
+	if (firstNode != 0)
+	{
+		// The process hosting node id 1 runs the tests, see checkHostedNodes.
+		return;
+	}
+	if (workload)
+	{
+		workloadRun();
+		return;
+	}
+
 	/**
 	 * Insert a set of test key value pairs into the system
 	 */
-	if (par->getcurrtime() == Config::insertTime)
+	if (par->getcurrtime() == par->insertTime)
   {
 		insertTestKVPairs();
 	}
@@ -235,7 +451,7 @@ void Application::mp2Run() {
 	/**
 	 * Test CRUD operations
 	 */
-	if (par->getcurrtime() >= Config::testTime)
+	if (par->getcurrtime() >= par->testTime)
 	{
 		/**************
 		 * CREATE TEST
@@ -246,10 +462,10 @@ void Application::mp2Run() {
      * the log
 		 *
 		 */
-		if (par->getcurrtime() == Config::testTime && CREATE_TEST == par->testType)
+		if (par->getcurrtime() == par->testTime && CREATE_TEST == par->testType)
 		{
-			std::cout << std::endl << "Doing create test at time: ";
-			std::cout << par->getcurrtime() << std::endl;
+			out << std::endl << "Doing create test at time: ";
+			out << par->getcurrtime() << std::endl;
 		} // End of create test
 
 		/***************
@@ -262,7 +478,7 @@ void Application::mp2Run() {
 		 * TEST 2: Delete a non-existent key. Check for a DELETE FAIL message in the lgo
 		 *
 		 */
-		else if (par->getcurrtime() == Config::testTime && DELETE_TEST == par->testType)
+		else if (par->getcurrtime() == par->testTime && DELETE_TEST == par->testType)
 		{
 			deleteTest();
 		} // End of delete test
@@ -298,7 +514,7 @@ void Application::mp2Run() {
 		 * TEST 5: Read a non-existent key. Check for a READ FAIL message in the log
 		 *
 		 */
-		else if (par->getcurrtime() >= Config::testTime && READ_TEST == par->testType)
+		else if (par->getcurrtime() >= par->testTime && READ_TEST == par->testType)
 		{
 			readTest();
 		} // end of read test
@@ -334,12 +550,389 @@ void Application::mp2Run() {
 		 * TEST 5: Update a non-existent key. Check for a UPDATE FAIL message in the log
 		 *
 		 */
-		else if (par->getcurrtime() >= Config::testTime && UPDATE_TEST == par->testType)
+		else if (par->getcurrtime() >= par->testTime && UPDATE_TEST == par->testType)
 		{
 			updateTest();
 		} // End of update test
 
-	} // end of if (par->getcurrtime == Config::testTime)
+	} // end of if (par->getcurrtime == par->testTime)
+}
+
+/**
+ * FUNCTION NAME: recvPhase
+ *
+ * DESCRIPTION: First half of a parallel tick. Every worker receives the
+ *              messages of its share of the nodes, as the first loop of
+ *              mp1Run does, and the deliveries are then merged. Also counts
+ *              the nodes introduced in this tick, since the join check in
+ *              run() needs them before processPhase.
+ */
+void Application::recvPhase() {
+	en->ENdeliverDue();
+	workers->run([this](int worker)
+	{
+		WorkerPool::setLane(worker);
+		for (int k = firstNodeOf(worker); k < firstNodeOf(worker + 1); k++)
+		{
+			int i = awake[k];
+			if (nodes->isRunning(i, par->getcurrtime()))
+			{
+				std::vector<q_elt> *inboxes[NUM_CHANNELS] = {
+					&mp1[i]->getInbox(), &mp2[i]->getInbox()};
+				en->ENrecvAll(nodes->address(i), inboxes);
+			}
+		}
+	});
+	en->mergeLanes();
+
+	for (auto it = awake.rbegin(); it != awake.rend(); it++)
+	{
+		if (par->getcurrtime() == nodes->startTime(*it))
+		{
+			nodeCount += *it;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: processPhase
+ *
+ * DESCRIPTION: Second half of a parallel tick. Every worker runs the rest of
+ *              mp1Run for its share of the nodes and, if `kvStore`, the node
+ *              steps of mp2Run. The sends and log lines are then merged and
+ *              the tests run on this thread.
+ *
+ * A worker uses one lane per step, numbered so that merging the lanes in
+ * order gives the order of a serial tick: the node loops (nodes in
+ * decreasing order), then updateRing (increasing), then checkMessages
+ * (decreasing). A run therefore does not depend on THREADS.
+ */
+void Application::processPhase(bool kvStore) {
+	int numWorkers = workers->size();
+	workers->run([this, numWorkers, kvStore](int worker)
+	{
+		int first = firstNodeOf(worker);
+		int last = firstNodeOf(worker + 1);
+
+		WorkerPool::setLane(numWorkers - 1 - worker);
+		for (int k = last - 1; k >= first; k--)
+		{
+			int i = awake[k];
+			if (par->getcurrtime() == nodes->startTime(i))
+			{
+				mp1[i]->nodeStart(JOINADDR, par->PORTNUM);
+				nodes->sync(i, *mp1[i]->getMemberNode());
+			}
+			else if (nodes->isRunning(i, par->getcurrtime()))
+			{
+				mp1[i]->nodeLoop();
+				nodes->sync(i, *mp1[i]->getMemberNode());
+				if ((i == 0) && (par->globaltime % 500 == 0))
+				{
+					log->unconditionalLog(
+						&mp1[i]->getMemberNode()->addr, "@@time=%d", par->getcurrtime());
+				}
+			}
+		}
+		if (!kvStore)
+		{
+			return;
+		}
+
+		WorkerPool::setLane(numWorkers + worker);
+		for (int k = first; k < last; k++)
+		{
+			int i = awake[k];
+			if (nodes->isRunning(i, par->getcurrtime()) && nodes->isJoined(i))
+			{
+				mp2[i]->updateRing();
+			}
+		}
+
+		WorkerPool::setLane(3 * numWorkers - 1 - worker);
+		for (int k = last - 1; k >= first; k--)
+		{
+			int i = awake[k];
+			if (nodes->isRunning(i, par->getcurrtime()))
+			{
+				mp2[i]->checkMessages();
+			}
+		}
+	});
+
+	for (auto it = awake.rbegin(); it != awake.rend(); it++)
+	{
+		if (par->getcurrtime() == nodes->startTime(*it))
+		{
+			printIntroduction(*it);
+		}
+	}
+	en->mergeLanes();
+	log->mergeLanes();
+
+	if (kvStore)
+	{
+		kvTestRun();
+	}
+}
+
+/**
+ * FUNCTION NAME: firstNodeOf
+ *
+ * DESCRIPTION: Index in `awake` of the first node of the share of worker
+ *              `worker`. The share ends where the share of the next worker
+ *              starts.
+ */
+int Application::firstNodeOf(int worker) const {
+	return (int)((long long)worker * awake.size() / workers->size());
+}
+
+/**
+ * FUNCTION NAME: printIntroduction
+ *
+ * DESCRIPTION: Prints the address assigned to node i when it is introduced
+ */
+void Application::printIntroduction(int i) {
+	out << i;
+	out << "-th introduced node is assigned with the address: ";
+	out << mp1[i]->getMemberNode()->addr.getAddress() << std::endl;
+}
+
+/**
+ * FUNCTION NAME: failNode
+ *
+ * DESCRIPTION: Fails node i: it stops receiving and running its protocols
+ */
+void Application::failNode(int i) {
+	mp1[i]->getMemberNode()->failed = true;
+	nodes->sync(i, *mp1[i]->getMemberNode());
+}
+
+/**
+ * FUNCTION NAME: wakeNodes
+ *
+ * DESCRIPTION: Fills `awake` with the nodes to visit in this tick: those a
+ *              wake-up is due for, those with messages to receive and those
+ *              introduced. Without an event queue, every node.
+ */
+void Application::wakeNodes() {
+	if (!events)
+	{
+		wakeAllNodes();
+		return;
+	}
+
+	awake.clear();
+	en->ENdeliverDue();
+	events->popDue(par->getcurrtime(), awake);
+	// The network names the nodes by address id, which ENinit handed out
+	// from 1 in the order of the nodes.
+	size_t firstArrival = awake.size();
+	en->ENtakeArrivals(awake);
+	for (size_t k = firstArrival; k < awake.size(); k++)
+	{
+		awake[k]--;
+	}
+	std::sort(awake.begin(), awake.end());
+	awake.erase(std::unique(awake.begin(), awake.end()), awake.end());
+}
+
+/**
+ * FUNCTION NAME: wakeAllNodes
+ *
+ * DESCRIPTION: Visits every node in this tick. A node with nothing to do
+ *              only spends the visit finding that out.
+ */
+void Application::wakeAllNodes() {
+	awake.clear();
+	for (int i = firstNode; i < lastNode; i++)
+	{
+		awake.push_back(i);
+	}
+}
+
+/**
+ * FUNCTION NAME: scheduleWakeUps
+ *
+ * DESCRIPTION: Schedules the next timer of every node visited or called by
+ *              the tests in this tick. Only these can have new timers.
+ */
+void Application::scheduleWakeUps() {
+	if (!events)
+	{
+		return;
+	}
+	for (int i : awake)
+	{
+		scheduleWakeUp(i);
+	}
+	for (int i : clientNodes)
+	{
+		scheduleWakeUp(i);
+	}
+	clientNodes.clear();
+}
+
+/**
+ * FUNCTION NAME: scheduleWakeUp
+ *
+ * DESCRIPTION: Schedules the next timer of node i, if it has one
+ */
+void Application::scheduleWakeUp(int i) {
+	if (nodes->isFailed(i))
+	{
+		return;
+	}
+	int now = par->getcurrtime();
+	int wakeTime = std::min(mp1[i]->nextWakeTime(), mp2[i]->nextWakeTime());
+	if (i == 0)
+	{
+		// Node 0 logs the time every 500 ticks, see mp1Run.
+		wakeTime = std::min(wakeTime, (now / 500 + 1) * 500);
+	}
+	if (wakeTime != INT_MAX)
+	{
+		events->schedule(std::max(wakeTime, now + 1), i);
+	}
+}
+
+/**
+ * FUNCTION NAME: nextTick
+ *
+ * DESCRIPTION: Returns the tick run() moves to after the current one: the
+ *              next one without an event queue, else the first one in which
+ *              a node wakes up, a message arrives, the KV store starts at
+ *              `kvStoreStart` or, once it runs (`kvStore`), the tests run.
+ */
+int Application::nextTick(bool kvStore, int kvStoreStart) {
+	int now = par->getcurrtime();
+	if (!events)
+	{
+		return now + 1;
+	}
+
+	int next = std::min(events->nextTime(), en->ENnextDelivery());
+	if (!kvStore)
+	{
+		next = std::min(next, kvStoreStart);
+	}
+	else if (now < par->insertTime)
+	{
+		next = std::min(next, par->insertTime);
+	}
+	else if (now + 1 < par->testTime && !(workload && workload->loading()))
+	{
+		next = std::min(next, par->testTime);
+	}
+	else
+	{
+		// The read and update tests have steps spread over the ticks after
+		// Params::testTime, and a workload issues operations in every tick.
+		next = now + 1;
+	}
+	return std::max(now + 1, std::min(next, par->TOTAL_RUNNING_TIME));
+}
+
+/**
+ * FUNCTION NAME: saveCheckpoint
+ *
+ * DESCRIPTION: Writes the state of the run at the end of the current tick
+ *              to Params::CHECKPOINT_FILE: the progress of run(), the tests
+ *              or workload, the wake-ups, every node and the network. A run
+ *              resuming from it starts at tick `resumeTime`.
+ */
+void Application::saveCheckpoint(int resumeTime) {
+	CheckpointWriter w(par->outputPath(par->CHECKPOINT_FILE));
+	w.section("APPL");
+	w.write(par->NUM_PEERS);
+	w.write(resumeTime);
+	w.write(nodeCount);
+	w.write(timeWhenAllNodesHaveJoined);
+	w.write(allNodesJoined);
+	w.write(kvStore);
+	w.write(testKVPairs.size());
+	for (const auto& pair : testKVPairs)
+	{
+		w.writeString(pair.first);
+		w.writeString(pair.second);
+	}
+	w.write(*rng);
+	w.write(runStart);
+	events->save(w);
+	w.write((bool)workload);
+	if (workload)
+	{
+		workload->save(w);
+	}
+	// Both protocols of a node share its Member.
+	for (int i = 0; i < par->NUM_PEERS; i++)
+	{
+		mp1[i]->getMemberNode()->save(w);
+		mp1[i]->save(w);
+		mp2[i]->save(w);
+	}
+	en->save(w);
+	w.close();
+
+	out << "Saved a checkpoint at time " << par->getcurrtime() << " to ";
+	out << par->CHECKPOINT_FILE << std::endl;
+}
+
+/**
+ * FUNCTION NAME: loadCheckpoint
+ *
+ * DESCRIPTION: Replaces the state of the freshly built run with that of
+ *              Params::RESUME_FILE, so that it goes on from where the run
+ *              that saved it was. The test file of this run still gives the
+ *              parameters: it has to start as many nodes, and may change
+ *              the rest, such as the drops or the workload mix, to fork
+ *              runs off one warmed-up cluster. A workload in the checkpoint
+ *              is skipped unless this run is a CRUD_TEST: WORKLOAD too.
+ */
+void Application::loadCheckpoint() {
+	CheckpointReader r(par->RESUME_FILE);
+	r.section("APPL");
+	if (r.read<int>() != par->NUM_PEERS)
+	{
+		throw std::runtime_error(
+			par->RESUME_FILE + " holds a run of another number of NODES");
+	}
+	r.read(startTime);
+	r.read(nodeCount);
+	r.read(timeWhenAllNodesHaveJoined);
+	r.read(allNodesJoined);
+	r.read(kvStore);
+	testKVPairs.clear();
+	for (size_t count = r.read<size_t>(); count > 0; count--)
+	{
+		std::string key = r.readString();
+		testKVPairs[key] = r.readString();
+	}
+	r.read(*rng);
+	r.read(runStart);
+	events->load(r);
+	if (r.read<bool>())
+	{
+		if (workload)
+		{
+			workload->load(r);
+		}
+		else
+		{
+			Workload(*par).load(r);
+		}
+	}
+	for (int i = 0; i < par->NUM_PEERS; i++)
+	{
+		mp1[i]->getMemberNode()->load(r);
+		mp1[i]->load(r);
+		mp2[i]->load(r);
+		nodes->sync(i, *mp1[i]->getMemberNode());
+	}
+	en->load(r);
+
+	out << "Resuming at time " << startTime << " from " << par->RESUME_FILE;
+	out << std::endl;
 }
 
 /**
@@ -365,8 +958,11 @@ int Application::findARandomNodeThatIsAlive() {
 	int number;
 	do
 	{
-		number = (rand()%par->NUM_PEERS);
-	} while (mp2[number]->getMemberNode()->failed);
+		number = firstNode + (int)rng->below(lastNode - firstNode);
+	} while (nodes->isFailed(number));
+	// The tests call the node as a client, which may give it a transaction
+	// to time out.
+	clientNodes.push_back(number);
 	return number;
 }
 
@@ -376,7 +972,6 @@ int Application::findARandomNodeThatIsAlive() {
  * DESCRIPTION: Init Config::numInserts test KV pairs in the map
  */
 void Application::initTestKVPairs() {
-	srand(time(NULL));
 	int i;
 	string key;
 	key.clear();
@@ -386,9 +981,9 @@ void Application::initTestKVPairs() {
 	{
 		for (i = 0; i < Config::keyLength; i++)
 		{
-			key.push_back(Application::alphanum[(rand()%alphanumLen)]);
+			key.push_back(Application::alphanum[rng->below(alphanumLen)]);
 		}
-		string value = "value" + to_string((rand() % Config::numInserts));
+		string value = "value" + to_string(rng->below(Config::numInserts));
 		testKVPairs[key] = value;
 		key.clear();
 	}
@@ -423,9 +1018,9 @@ void Application::insertTestKVPairs() {
 		mp2[number]->clientCreate(it->first, it->second);
 	}
 
-	std::cout << std::endl;
-	std::cout << "Sent " <<testKVPairs.size();
-	std::cout << " create messages to the ring" << std::endl;
+	out << std::endl;
+	out << "Sent " <<testKVPairs.size();
+	out << " create messages to the ring" << std::endl;
 }
 
 /**
@@ -438,9 +1033,9 @@ void Application::deleteTest() {
 	/**
 	 * Test 1: Delete half the KV pairs
 	 */
-	std::cout << std::endl;
-	std::cout << "Deleting " << testKVPairs.size()/2;
-	std::cout << " valid keys.... ... .. . ." << std::endl;
+	out << std::endl;
+	out << "Deleting " << testKVPairs.size()/2;
+	out << " valid keys.... ... .. . ." << std::endl;
 	map<string, string>::iterator it = testKVPairs.begin();
 	for (int i = 0; i < testKVPairs.size()/2; i++) {
     // Skip past the first node which is the coordinator.
@@ -462,8 +1057,8 @@ void Application::deleteTest() {
 	/**
 	 * Test 2: Delete a non-existent key
 	 */
-	std::cout << std::endl;
-	std::cout << "Deleting an invalid key.... ... .. . ." << std::endl;
+	out << std::endl;
+	out << "Deleting an invalid key.... ... .. . ." << std::endl;
 	string invalidKey = "invalidKey";
 	// Step 2.a. Find a node that is alive
 	number = findARandomNodeThatIsAlive();
@@ -491,7 +1086,7 @@ void Application::readTest() {
 	int replicaIdToFail = TERTIARY;
 	int nodeToFail;
 	bool failedOneNode = false;
-	int targetTime = Config::testTime;
+	int targetTime = par->testTime;
 
 	/**
  	 * Test 1: Test if value of a single read operation is read correctly in quorum number of nodes
@@ -502,7 +1097,7 @@ void Application::readTest() {
 		number = findARandomNodeThatIsAlive();
 
 		// Step 1.b Do a read operation
-		std::cout << std::endl << "Reading a valid key.... ... .. . ." << std::endl;
+		out << std::endl << "Reading a valid key.... ... .. . ." << std::endl;
 		log->unconditionalLog(&mp2[number]->getMemberNode()->addr,
 		                      "READ OPERATION KEY: %s VALUE: %s at time: %d",
 						              it->first.c_str(),
@@ -528,14 +1123,12 @@ void Application::readTest() {
 		// if less than quorum replicas are found then exit
 		if (replicas.size() < (Config::numReplicas-1))
 		{
-			std::cout << std::endl;
-			std::cout << "Could not find at least quorum replicas for this key. ";
-			std::cout << "Exiting!!! size of replicas vector: ";
-			std::cout << replicas.size() << std::endl;
 			log->unconditionalLog(&mp2[number]->getMemberNode()->addr,
 			                      "Could not find at least quorum replicas for this key. Exiting!!! size of replicas vector: %d",
 							              replicas.size());
-			exit(1);
+			throw std::runtime_error(
+				"Could not find at least quorum replicas for this key, found " +
+				std::to_string(replicas.size()));
 		}
 
 		// Step 2.c Fail a replica
@@ -544,7 +1137,7 @@ void Application::readTest() {
 			if (mp2[i]->getMemberNode()->addr.getAddress() ==
 			    replicas.at(replicaIdToFail).getAddress()->getAddress())
 			{
-				if (!mp2[i]->getMemberNode()->failed)
+				if (!nodes->isFailed(i))
 				{
 					nodeToFail = i;
 					failedOneNode = true;
@@ -569,23 +1162,21 @@ void Application::readTest() {
 			log->unconditionalLog(&mp2[nodeToFail]->getMemberNode()->addr,
 			                      "Node failed at time=%d",
 							              par->getcurrtime());
-			mp2[nodeToFail]->getMemberNode()->failed = true;
-			mp1[nodeToFail]->getMemberNode()->failed = true;
-			std::cout << std::endl << "Failed a replica node" << std::endl;
+			failNode(nodeToFail);
+			out << std::endl << "Failed a replica node" << std::endl;
 		}
 		else
 		{
 			// The code can never reach here
 			log->unconditionalLog(
 				&mp2[number]->getMemberNode()->addr, "Could not fail a node");
-			std::cout << "Could not fail a node. Exiting!!!" << std::endl;
-			exit(1);
+			throw std::runtime_error("Could not fail a node");
 		}
 
 		number = findARandomNodeThatIsAlive();
 
 		// Step 2.d Issue a read
-		std::cout << std::endl << "Reading a valid key.... ... .. . ." << std::endl;
+		out << std::endl << "Reading a valid key.... ... .. . ." << std::endl;
 		log->unconditionalLog(&mp2[number]->getMemberNode()->addr,
 		                      "READ OPERATION KEY: %s VALUE: %s at time: %d",
 						              it->first.c_str(),
@@ -631,7 +1222,7 @@ void Application::readTest() {
 						if (mp2[i]->getMemberNode()->addr.getAddress() ==
 						    replicas.at(replicaIdToFail).getAddress()->getAddress())
 						{
-							if (!mp2[i]->getMemberNode()->failed)
+							if (!nodes->isFailed(i))
 							{
 								nodesToFail.emplace_back(i);
 								replicaIdToFail--;
@@ -654,11 +1245,9 @@ void Application::readTest() {
 			else
 			{
 				// If the code reaches here. Test your stabilization protocol
-				std::cout << std::endl;
-				std::cout << "Not enough replicas to fail two nodes. ";
-				std::cout << "Number of replicas of this key: " <<replicas.size();
-				std::cout << ". Exiting test case !!" << std::endl;
-				exit(1);
+				throw std::runtime_error(
+					"Not enough replicas to fail two nodes, found " +
+					std::to_string(replicas.size()));
 			}
 			if (count == 2)
 			{
@@ -668,9 +1257,8 @@ void Application::readTest() {
 					log->unconditionalLog(&mp2[nodesToFail.at(i)]->getMemberNode()->addr,
 					                      "Node failed at time=%d",
 									              par->getcurrtime());
-					mp2[nodesToFail.at(i)]->getMemberNode()->failed = true;
-					mp1[nodesToFail.at(i)]->getMemberNode()->failed = true;
-					std::cout << std::endl << "Failed a replica node" << std::endl;
+					failNode(nodesToFail.at(i));
+					out << std::endl << "Failed a replica node" << std::endl;
 				}
 			}
 			else
@@ -678,15 +1266,14 @@ void Application::readTest() {
 				// The code can never reach here
 				log->unconditionalLog(&mp2[number]->getMemberNode()->addr,
 				                      "Could not fail two nodes");
-				std::cout << "Could not fail two nodes. Exiting!!!";
-				exit(1);
+				throw std::runtime_error("Could not fail two nodes");
 			}
 
 			number = findARandomNodeThatIsAlive();
 
 			// Step 3.c Issue a read
-			std::cout << std::endl;
-			std::cout << "Reading a valid key.... ... .. . ." << std::endl;
+			out << std::endl;
+			out << "Reading a valid key.... ... .. . ." << std::endl;
 			log->unconditionalLog(&mp2[number]->getMemberNode()->addr,
 			                      "READ OPERATION KEY: %s VALUE: %s at time: %d",
 							              it->first.c_str(),
@@ -706,8 +1293,8 @@ void Application::readTest() {
 		{
 			number = findARandomNodeThatIsAlive();
 			// Step 3.e Issue a read
-			std::cout << std::endl;
-			std::cout << "Reading a valid key.... ... .. . ." << std::endl;
+			out << std::endl;
+			out << "Reading a valid key.... ... .. . ." << std::endl;
 			log->unconditionalLog(&mp2[number]->getMemberNode()->addr,
 			                      "READ OPERATION KEY: %s VALUE: %s at time: %d",
 							              it->first.c_str(),
@@ -734,7 +1321,7 @@ void Application::readTest() {
 		replicas = mp2[number]->findNodes(it->first);
 		for ( int i = 0; i < par->NUM_PEERS; i++ )
 		{
-			if (!mp2[i]->getMemberNode()->failed)
+			if (!nodes->isFailed(i))
 			{
 				std::string memberAddr = mp2[i]->getMemberNode()->addr.getAddress();
 				if (memberAddr != replicas.at(PRIMARY).getAddress()->getAddress() &&
@@ -745,10 +1332,9 @@ void Application::readTest() {
 					log->unconditionalLog(&mp2[i]->getMemberNode()->addr,
 					                      "Node failed at time=%d",
 									              par->getcurrtime());
-					mp2[i]->getMemberNode()->failed = true;
-					mp1[i]->getMemberNode()->failed = true;
+					failNode(i);
 					failedOneNode = true;
-					std::cout << std::endl << "Failed a non-replica node" << std::endl;
+					out << std::endl << "Failed a non-replica node" << std::endl;
 					break;
 				}
 			}
@@ -757,14 +1343,13 @@ void Application::readTest() {
 			// The code can never reach here
 			log->unconditionalLog(&mp2[number]->getMemberNode()->addr,
 			                      "Could not fail a node(non-replica)");
-			std::cout << "Could not fail a node(non-replica). Exiting!!!" << std::endl;
-			exit(1);
+			throw std::runtime_error("Could not fail a node(non-replica)");
 		}
 
 		number = findARandomNodeThatIsAlive();
 
 		// Step 4.d Issue a read operation
-		std::cout << endl << "Reading a valid key.... ... .. . ." << std::endl;
+		out << endl << "Reading a valid key.... ... .. . ." << std::endl;
 		log->unconditionalLog(&mp2[number]->getMemberNode()->addr,
 		                      "READ OPERATION KEY: %s VALUE: %s at time: %d",
 						              it->first.c_str(),
@@ -787,8 +1372,8 @@ void Application::readTest() {
 		number = findARandomNodeThatIsAlive();
 
 		// Step 5.b Issue a read operation
-		std::cout << std::endl;
-		std::cout << "Reading an invalid key.... ... .. . ." << std::endl;
+		out << std::endl;
+		out << "Reading an invalid key.... ... .. . ." << std::endl;
 		log->unconditionalLog(&mp2[number]->getMemberNode()->addr,
 		                      "READ OPERATION KEY: %s at time: %d",
 						              invalidKey.c_str(),
@@ -799,6 +1384,139 @@ void Application::readTest() {
 	/** end of test 5 **/
 }
 
+/**
+ * FUNCTION NAME: workloadRun
+ *
+ * DESCRIPTION: Issues the operations of the workload arriving in this tick,
+ *              each to a random node alive. The records are loaded from
+ *              Params::insertTime, the operations run from Params::testTime
+ *              or once the load is over, whichever is later.
+ */
+void Application::workloadRun() {
+	int now = par->getcurrtime();
+	if (now < par->insertTime || workload->done())
+	{
+		return;
+	}
+
+	WorkloadOp op;
+	int arrivals = workload->arrivals();
+	for (int k = 0; k < arrivals; k++)
+	{
+		if (!workload->loading() && now < par->testTime)
+		{
+			break;
+		}
+		if (!workload->loading() && runStart < 0)
+		{
+			// Whatever completed so far belongs to the load.
+			reportLatencies("Load", par->insertTime);
+			runStart = now;
+		}
+		bool wasLoading = workload->loading();
+		if (!workload->next(op))
+		{
+			break;
+		}
+
+		int number = findARandomNodeThatIsAlive();
+		switch (op.type)
+		{
+		case WORKLOAD_READ:
+			mp2[number]->clientRead(op.key);
+			break;
+		case WORKLOAD_UPDATE:
+			mp2[number]->clientUpdate(op.key, op.value);
+			break;
+		case WORKLOAD_INSERT:
+			mp2[number]->clientCreate(op.key, op.value);
+			break;
+		case WORKLOAD_DELETE:
+		default:
+			mp2[number]->clientDelete(op.key);
+			break;
+		}
+
+		if (wasLoading && !workload->loading())
+		{
+			out << std::endl << "Loaded " << par->WORKLOAD_RECORDS;
+			out << " records at time: " << now << std::endl;
+		}
+		if (workload->done())
+		{
+			out << std::endl << "Sent " << par->WORKLOAD_OPERATIONS;
+			out << " operations by time " << now << ": ";
+			out << workload->getIssued(WORKLOAD_READ) << " reads, ";
+			out << workload->getIssued(WORKLOAD_UPDATE) << " updates, ";
+			out << workload->getIssued(WORKLOAD_INSERT) << " inserts, ";
+			out << workload->getIssued(WORKLOAD_DELETE) << " deletes";
+			out << std::endl;
+			break;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: reportLatencies
+ *
+ * DESCRIPTION: Prints the outcomes of the client calls since `startTime`,
+ *              gathered from every coordinator, and starts them over: by
+ *              type, the number that succeeded and failed and the latency
+ *              percentiles, in ticks from the call to the quorum, of those
+ *              that succeeded; overall, the same and the calls that succeeded
+ *              per tick.
+ */
+void Application::reportLatencies(const char *phase, int startTime) {
+	static const char *typeNames[CoordinatorStats::numTypes] = {
+		"CREATE", "READ", "UPDATE", "DELETE"};
+
+	CoordinatorStats total;
+	for (int i = firstNode; i < lastNode; i++)
+	{
+		total.merge(mp2[i]->getStats());
+		mp2[i]->getStats().clear();
+	}
+
+	LatencyHistogram all;
+	long failed = 0;
+	for (int type = 0; type < CoordinatorStats::numTypes; type++)
+	{
+		all.merge(total.succeeded[type]);
+		failed += total.failed[type];
+	}
+	long succeeded = all.count();
+	int ticks = std::max(total.lastOutcome - startTime + 1, 1);
+	out << std::endl << phase << " phase from time " << startTime;
+	out << ": " << succeeded << " calls succeeded, " << failed;
+	out << " failed, " << (double)succeeded / ticks;
+	out << " per tick";
+	if (succeeded > 0)
+	{
+		out << ", latency p50 " << all.percentile(0.5);
+		out << " p99 " << all.percentile(0.99);
+		out << " p999 " << all.percentile(0.999) << " ticks";
+	}
+	out << std::endl;
+
+	for (int type = 0; type < CoordinatorStats::numTypes; type++)
+	{
+		const LatencyHistogram& latency = total.succeeded[type];
+		if (latency.count() == 0 && total.failed[type] == 0)
+		{
+			continue;
+		}
+		out << "  " << typeNames[type] << ": " << latency.count();
+		out << " succeeded, " << total.failed[type] << " failed";
+		if (latency.count() > 0)
+		{
+			out << ", latency p50 " << latency.percentile(0.5);
+			out << " p99 " << latency.percentile(0.99);
+			out << " p999 " << latency.percentile(0.999) << " ticks";
+		}
+		out << std::endl;
+	}
+}
+
 /**
  * FUNCTION NAME: updateTest
  *
@@ -819,15 +1537,15 @@ void Application::updateTest() {
 	/**
 	 * Test 1: Test if value is updated correctly in quorum number of nodes
 	 */
-	int targetTime = Config::testTime;
+	int targetTime = par->testTime;
 	if (par->getcurrtime() == targetTime)
 	{
 		// Step 1.a. Find a node that is alive
 		number = findARandomNodeThatIsAlive();
 
 		// Step 1.b Do a update operation
-		std::cout << std::endl;
-		std::cout << "Updating a valid key.... ... .. . ." << std::endl;
+		out << std::endl;
+		out << "Updating a valid key.... ... .. . ." << std::endl;
 		log->unconditionalLog(&mp2[number]->getMemberNode()->addr,
 		                      "UPDATE OPERATION KEY: %s VALUE: %s at time: %d",
 						              it->first.c_str(),
@@ -856,11 +1574,9 @@ void Application::updateTest() {
 			log->unconditionalLog(&mp2[number]->getMemberNode()->addr,
 			                      "Could not find at least quorum replicas for this key. Exiting!!! size of replicas vector: %d",
 							              replicas.size());
-			std::cout << std::endl;
-			std::cout << "Could not find at least quorum replicas for this key. ";
-			std::cout << "Exiting!!! size of replicas vector: ";
-			std::cout << replicas.size() << std::endl;
-			exit(1);
+			throw std::runtime_error(
+				"Could not find at least quorum replicas for this key, found " +
+				std::to_string(replicas.size()));
 		}
 
 		// Step 2.c Fail a replica
@@ -869,7 +1585,7 @@ void Application::updateTest() {
 			if (mp2[i]->getMemberNode()->addr.getAddress() ==
 			    replicas.at(replicaIdToFail).getAddress()->getAddress())
 			{
-				if (!mp2[i]->getMemberNode()->failed)
+				if (!nodes->isFailed(i))
 				{
 					nodeToFail = i;
 					failedOneNode = true;
@@ -894,24 +1610,22 @@ void Application::updateTest() {
 			log->unconditionalLog(&mp2[nodeToFail]->getMemberNode()->addr,
 			                      "Node failed at time=%d",
 							              par->getcurrtime());
-			mp2[nodeToFail]->getMemberNode()->failed = true;
-			mp1[nodeToFail]->getMemberNode()->failed = true;
-			std::cout << std::endl << "Failed a replica node" << std::endl;
+			failNode(nodeToFail);
+			out << std::endl << "Failed a replica node" << std::endl;
 		}
 		else
 		{
 			// The code can never reach here
 			log->unconditionalLog(
 				&mp2[number]->getMemberNode()->addr, "Could not fail a node");
-			std::cout << "Could not fail a node. Exiting!!!" << std::endl;
-			exit(1);
+			throw std::runtime_error("Could not fail a node");
 		}
 
 		number = findARandomNodeThatIsAlive();
 
 		// Step 2.d Issue a update
-		std::cout << std::endl;
-		std::cout << "Updating a valid key.... ... .. . ." << std::endl;
+		out << std::endl;
+		out << "Updating a valid key.... ... .. . ." << std::endl;
 		log->unconditionalLog(&mp2[number]->getMemberNode()->addr,
 		                      "UPDATE OPERATION KEY: %s VALUE: %s at time: %d",
 						              it->first.c_str(),
@@ -955,7 +1669,7 @@ void Application::updateTest() {
 						if (mp2[i]->getMemberNode()->addr.getAddress() ==
 						    replicas.at(replicaIdToFail).getAddress()->getAddress())
 						{
-							if (!mp2[i]->getMemberNode()->failed)
+							if (!nodes->isFailed(i))
 							{
 								nodesToFail.emplace_back(i);
 								replicaIdToFail--;
@@ -977,9 +1691,9 @@ void Application::updateTest() {
 			else
 			{
 				// If the code reaches here. Test your stabilization protocol
-				std::cout << std::endl;
-				std::cout << "Not enough replicas to fail two nodes. ";
-				std::cout << "Exiting test case !! " << std::endl;
+				out << std::endl;
+				out << "Not enough replicas to fail two nodes. ";
+				out << "Exiting test case !! " << std::endl;
 			}
 			if (count == 2)
 			{
@@ -989,9 +1703,8 @@ void Application::updateTest() {
 					log->unconditionalLog(&mp2[nodesToFail.at(i)]->getMemberNode()->addr,
 					                      "Node failed at time=%d",
 									              par->getcurrtime());
-					mp2[nodesToFail.at(i)]->getMemberNode()->failed = true;
-					mp1[nodesToFail.at(i)]->getMemberNode()->failed = true;
-					std::cout << std::endl << "Failed a replica node" << std::endl;
+					failNode(nodesToFail.at(i));
+					out << std::endl << "Failed a replica node" << std::endl;
 				}
 			}
 			else
@@ -999,15 +1712,14 @@ void Application::updateTest() {
 				// The code can never reach here
 				log->unconditionalLog(&mp2[number]->getMemberNode()->addr,
 				                      "Could not fail two nodes");
-				std::cout << "Could not fail two nodes. Exiting!!!" << std::endl;
-				exit(1);
+				throw std::runtime_error("Could not fail two nodes");
 			}
 
 			number = findARandomNodeThatIsAlive();
 
 			// Step 3.c Issue an update
-			std::cout << std::endl;
-			std::cout << "Updating a valid key.... ... .. . ." << std::endl;
+			out << std::endl;
+			out << "Updating a valid key.... ... .. . ." << std::endl;
 			log->unconditionalLog(&mp2[number]->getMemberNode()->addr,
 			                      "UPDATE OPERATION KEY: %s VALUE: %s at time: %d",
 							              it->first.c_str(),
@@ -1027,8 +1739,8 @@ void Application::updateTest() {
 		{
 			number = findARandomNodeThatIsAlive();
 			// Step 3.e Issue a update
-			std::cout << std::endl;
-			std::cout << "Updating a valid key.... ... .. . ." << std::endl;
+			out << std::endl;
+			out << "Updating a valid key.... ... .. . ." << std::endl;
 			log->unconditionalLog(&mp2[number]->getMemberNode()->addr,
 			                      "UPDATE OPERATION KEY: %s VALUE: %s at time: %d",
 							              it->first.c_str(),
@@ -1055,7 +1767,7 @@ void Application::updateTest() {
 		replicas = mp2[number]->findNodes(it->first);
 		for (int i = 0; i < par->NUM_PEERS; i++)
 		{
-			if (!mp2[i]->getMemberNode()->failed)
+			if (!nodes->isFailed(i))
 			{
 				std::string memberAddr = mp2[i]->getMemberNode()->addr.getAddress();
 				if (memberAddr != replicas.at(PRIMARY).getAddress()->getAddress() &&
@@ -1066,10 +1778,9 @@ void Application::updateTest() {
 					log->unconditionalLog(&mp2[i]->getMemberNode()->addr,
 					                      "Node failed at time=%d",
 									              par->getcurrtime());
-					mp2[i]->getMemberNode()->failed = true;
-					mp1[i]->getMemberNode()->failed = true;
+					failNode(i);
 					failedOneNode = true;
-					std::cout << std::endl << "Failed a non-replica node" << std::endl;
+					out << std::endl << "Failed a non-replica node" << std::endl;
 					break;
 				}
 			}
@@ -1080,16 +1791,14 @@ void Application::updateTest() {
 			// The code can never reach here
 			log->unconditionalLog(&mp2[number]->getMemberNode()->addr,
 			                      "Could not fail a node(non-replica)");
-			std::cout << "Could not fail a node(non-replica). Exiting!!!";
-			std::cout << std::endl;
-			exit(1);
+			throw std::runtime_error("Could not fail a node(non-replica)");
 		}
 
 		number = findARandomNodeThatIsAlive();
 
 		// Step 4.d Issue a update operation
-		std::cout << std::endl;
-		std::cout << "Updating a valid key.... ... .. . ." << std::endl;
+		out << std::endl;
+		out << "Updating a valid key.... ... .. . ." << std::endl;
 		log->unconditionalLog(&mp2[number]->getMemberNode()->addr,
 		                      "UPDATE OPERATION KEY: %s VALUE: %s at time: %d",
 						              it->first.c_str(),
@@ -1113,8 +1822,8 @@ void Application::updateTest() {
 		number = findARandomNodeThatIsAlive();
 
 		// Step 5.b Issue a read operation
-		std::cout << std::endl;
-		std::cout << "Updating a valid key.... ... .. . ." << std::endl;
+		out << std::endl;
+		out << "Updating a valid key.... ... .. . ." << std::endl;
 		log->unconditionalLog(&mp2[number]->getMemberNode()->addr,
 		                      "UPDATE OPERATION KEY: %s VALUE: %s at time: %d",
 						              invalidKey.c_str(),
@@ -15,9 +15,16 @@
 #include "Params.h"
 #include "Member.h"
 #include "EmulNet.h"
+#include "UdpNet.h"
+#include "ShmNet.h"
 #include "Queue.h"
 #include "MP2Node.h"
 #include "Node.h"
+#include "Random.h"
+#include "WorkerPool.h"
+#include "EventQueue.h"
+#include "Workload.h"
+#include "NodeTable.h"
 
 /**
  * CLASS NAME: Application
@@ -26,32 +33,85 @@
  */
 class Application{
 private:
-  static size_t nodeCount;
 	static const char alphanum[];
 
+	// Where the run prints its progress and results
+	std::ostream &out;
+	// Nodes started so far, whose introduction Params::allNodesJoined awaits
+	size_t nodeCount;
+
 	// Address for introduction to the group
 	// Coordinator Node
 	char JOINADDR[30];
 	std::shared_ptr<EmulNet> en;
-	std::shared_ptr<EmulNet> en1;
   std::shared_ptr<Log> log;
 	std::vector<std::unique_ptr<MP1Node>> mp1;
 	std::vector<std::unique_ptr<MP2Node>> mp2;
+	// Start tick, address, failed and joined of every node, see NodeTable
+	std::unique_ptr<NodeTable> nodes;
+	// Nodes hosted by this process, from firstNode up to lastNode excluded.
+	// The others run in other processes (Params::FIRST_NODE_ID and
+	// LOCAL_NODES), and their entries of mp1 and mp2 stay null.
+	int firstNode;
+	int lastNode;
 	std::shared_ptr<Params> par;
 	std::map<string, string> testKVPairs;
+	// Draws the test keys, values and the nodes to fail.
+	std::unique_ptr<Random> rng;
+	// Runs the ticks when Params::THREADS is above one.
+	std::unique_ptr<WorkerPool> workers;
+	// Timed wake-ups of the nodes. Null unless TRANSPORT is EMULNET: the
+	// other transports cannot tell when a message will arrive, so every node
+	// is visited in every tick.
+	std::unique_ptr<EventQueue> events;
+	// Nodes visited in the current tick, in increasing order
+	std::vector<int> awake;
+	// Nodes the tests issued client calls to in the current tick
+	std::vector<int> clientNodes;
+	// Operations of a WORKLOAD_TEST run, null for the CRUD tests
+	std::unique_ptr<Workload> workload;
+	// Tick the run phase of the workload started, -1 while it loads
+	int runStart;
+	// Tick run() starts at, later than 0 when resuming from a checkpoint
+	int startTime;
+	// Progress of run(), kept here so that a checkpoint holds it
+	int timeWhenAllNodesHaveJoined;
+	bool allNodesJoined;
+	bool kvStore;
+
+	void checkHostedNodes();
+	bool hostsEveryNode() const;
+	std::shared_ptr<EmulNet> createNetwork();
+	int firstNodeOf(int worker) const;
+	void printIntroduction(int i);
+	void failNode(int i);
+	void wakeNodes();
+	void wakeAllNodes();
+	void scheduleWakeUps();
+	void scheduleWakeUp(int i);
+	int nextTick(bool kvStore, int kvStoreStart);
+	void saveCheckpoint(int resumeTime);
+	void loadCheckpoint();
 public:
-	Application(char* inputFile, bool debugMode);
+	Application(const char *inputFile, bool debugMode,
+	            std::ostream &out = std::cout,
+	            const std::string &outputDir = "");
 	virtual ~Application();
 	Address getjoinaddr();
 	void initTestKVPairs();
 	int run();
 	void mp1Run();
 	void mp2Run();
+	void kvTestRun();
+	void recvPhase();
+	void processPhase(bool kvStore);
 	void insertTestKVPairs();
 	int findARandomNodeThatIsAlive();
 	void deleteTest();
 	void readTest();
 	void updateTest();
+	void workloadRun();
+	void reportLatencies(const char *phase, int startTime);
 };
 
 #endif /* _APPLICATION_H__ */
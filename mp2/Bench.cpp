@@ -0,0 +1,702 @@
+/**********************************
+ * FILE NAME: Bench.cpp
+ *
+ * DESCRIPTION: Benchmarks for the emulated network and the hot paths of
+ *              both protocols.
+ *              Build with `make bench` and run `./Bench`.
+ **********************************/
+
+#include "stdincludes.h"
+#include "Config.h"
+#include "Address.h"
+#include "Params.h"
+#include "EmulNet.h"
+#include "Log.h"
+#include "MP1Node.h"
+#include "MP2Node.h"
+#include "HashTable.h"
+#include "Message.h"
+#include <chrono>
+#include <new>
+
+namespace {
+
+// Heap allocations so far. The Bench target links with --wrap for malloc,
+// calloc and realloc, so every allocation of our objects goes through the
+// wrappers below, and operator new is replaced to allocate with malloc.
+unsigned long allocations = 0;
+
+}  // namespace
+
+extern "C" {
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+	allocations++;
+	return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size)
+{
+	allocations++;
+	return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+	allocations++;
+	return __real_realloc(ptr, size);
+}
+}
+
+void *operator new(size_t size)
+{
+	void *ptr = malloc(size ? size : 1);
+	if (ptr == NULL)
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+	free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+	free(ptr);
+}
+
+namespace {
+
+// Number of ticks simulated for every configuration.
+const int benchTicks = 20;
+
+/**
+ * FUNCTION NAME: keepMessage
+ *
+ * DESCRIPTION: ENrecv callback that keeps the received buffer.
+ */
+int keepMessage(void *env, char *buff, int)
+{
+	std::vector<char *> *received = (std::vector<char *> *)env;
+	received->emplace_back(buff);
+	return 0;
+}
+
+/**
+ * FUNCTION NAME: enqueueMessage
+ *
+ * DESCRIPTION: ENrecv callback that queues the received buffer, the way the
+ *              nodes did before ENrecvBatch.
+ */
+int enqueueMessage(void *env, char *buff, int size)
+{
+	return Queue::enqueue((queue<q_elt> *)env, (void *)buff, size);
+}
+
+/**
+ * FUNCTION NAME: benchReceive
+ *
+ * DESCRIPTION: Measures the cost of one receive phase (every node calling
+ *              ENrecv, or ENrecvBatch if `batched`, once and releasing what
+ *              it got) with `numNodes` nodes each sending `msgsPerNode`
+ *              messages to random peers per tick.
+ */
+void benchReceive(int numNodes, int msgsPerNode, DeliveryMode mode, bool batched)
+{
+	std::shared_ptr<Params> par = std::make_shared<Params>();
+	par->NUM_PEERS = numNodes;
+	par->MAX_MSG_SIZE = 4000;
+	par->globaltime = 0;
+	std::unique_ptr<EmulNet> en = std::make_unique<EmulNet>(par);
+	en->setDeliveryMode(mode);
+
+	std::vector<Address> addrs;
+	for (int i = 0; i < numNodes; i++)
+	{
+		addrs.emplace_back(en->ENinit());
+	}
+
+	char payload[64];
+	memset(payload, 'x', sizeof(payload));
+	std::queue<q_elt> received;
+	std::vector<q_elt> batch;
+	size_t delivered = 0;
+	std::chrono::nanoseconds recvTime(0);
+
+	for (par->globaltime = 0; par->globaltime < benchTicks; par->globaltime++)
+	{
+		for (int i = 0; i < numNodes; i++)
+		{
+			for (int m = 0; m < msgsPerNode; m++)
+			{
+				en->ENsend(addrs[i], addrs[rand() % numNodes],
+				           payload, sizeof(payload), CHANNEL_MEMBERSHIP);
+			}
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < numNodes; i++)
+		{
+			if (batched)
+			{
+				delivered += en->ENrecvBatch(addrs[i], batch, CHANNEL_MEMBERSHIP);
+				for (const q_elt& msg : batch)
+				{
+					en->ENrelease((char *)msg.elt);
+				}
+				batch.clear();
+				continue;
+			}
+			en->ENrecv(addrs[i], enqueueMessage, NULL, 1, &received,
+			           CHANNEL_MEMBERSHIP);
+			while (!received.empty())
+			{
+				en->ENrelease((char *)received.front().elt);
+				received.pop();
+				delivered++;
+			}
+		}
+		recvTime += std::chrono::steady_clock::now() - start;
+
+		en->ENtick();
+	}
+
+	double nsPerTick = (double)recvTime.count() / benchTicks;
+	double nsPerMsg = delivered ? (double)recvTime.count() / delivered : 0.0;
+	// Steady state allocation behaviour, taken from the last tick.
+	const PoolStats& stats = en->getPoolStats();
+	std::string label = mode == HANDOFF ? "handoff" : "copy";
+	if (batched)
+	{
+		label += "+batch";
+	}
+	printf("%14s %8d %10d %12zu %16.0f %12.1f %12lu %12lu\n",
+	       label.c_str(), numNodes, msgsPerNode,
+	       delivered, nsPerTick, nsPerMsg,
+	       stats.allocationsLastTick, stats.mallocsLastTick);
+}
+
+/**
+ * FUNCTION NAME: benchMulticast
+ *
+ * DESCRIPTION: Measures the cost of sending one `payloadSize` byte message to
+ *              `fanout` nodes, either with one ENsend per destination or
+ *              with a single ENsendMany, and of receiving it.
+ */
+void benchMulticast(int fanout, int payloadSize, bool sendMany)
+{
+	const int rounds = 1000;
+	std::shared_ptr<Params> par = std::make_shared<Params>();
+	par->NUM_PEERS = fanout + 1;
+	par->MAX_MSG_SIZE = 4000;
+	par->globaltime = 0;
+	std::unique_ptr<EmulNet> en = std::make_unique<EmulNet>(par);
+	en->setDeliveryMode(HANDOFF);
+
+	Address sender = en->ENinit();
+	std::vector<Address> addrs;
+	for (int i = 0; i < fanout; i++)
+	{
+		addrs.emplace_back(en->ENinit());
+	}
+
+	std::vector<char> payload(payloadSize, 'x');
+	std::vector<char *> received;
+	std::chrono::nanoseconds sendTime(0);
+	std::chrono::nanoseconds totalTime(0);
+	unsigned long allocations = 0;
+
+	for (int r = 0; r < rounds; r++)
+	{
+		unsigned long allocationsBefore = en->getPoolStats().allocations;
+		auto start = std::chrono::steady_clock::now();
+		if (sendMany)
+		{
+			en->ENsendMany(sender, addrs, payload.data(), payloadSize,
+			               CHANNEL_MEMBERSHIP);
+		}
+		else
+		{
+			for (const Address& addr : addrs)
+			{
+				en->ENsend(sender, addr, payload.data(), payloadSize,
+				           CHANNEL_MEMBERSHIP);
+			}
+		}
+		auto sent = std::chrono::steady_clock::now();
+		allocations += en->getPoolStats().allocations - allocationsBefore;
+
+		for (const Address& addr : addrs)
+		{
+			en->ENrecv(addr, keepMessage, NULL, 1, &received,
+			           CHANNEL_MEMBERSHIP);
+			for (char *buff : received)
+			{
+				en->ENrelease(buff);
+			}
+			received.clear();
+		}
+		en->ENtick();
+		sendTime += sent - start;
+		totalTime += std::chrono::steady_clock::now() - start;
+	}
+
+	printf("%10s %8d %8d %14.0f %14.0f %12.1f\n",
+	       sendMany ? "sendMany" : "send", fanout, payloadSize,
+	       (double)sendTime.count() / rounds, (double)totalTime.count() / rounds,
+	       (double)allocations / rounds);
+}
+
+/**
+ * FUNCTION NAME: benchCoalesce
+ *
+ * DESCRIPTION: Measures the cost of sending and receiving with `numNodes`
+ *              nodes each sending `msgsPerLink` small messages to each of its
+ *              next 3 nodes per tick, with or without Params::COALESCE.
+ */
+void benchCoalesce(int numNodes, int msgsPerLink, bool coalesce)
+{
+	const int peers = 3;
+	std::shared_ptr<Params> par = std::make_shared<Params>();
+	par->NUM_PEERS = numNodes;
+	par->MAX_MSG_SIZE = 4000;
+	par->COALESCE = coalesce;
+	par->globaltime = 0;
+	std::unique_ptr<EmulNet> en = std::make_unique<EmulNet>(par);
+	en->setDeliveryMode(HANDOFF);
+
+	std::vector<Address> addrs;
+	for (int i = 0; i < numNodes; i++)
+	{
+		addrs.emplace_back(en->ENinit());
+	}
+
+	char payload[32];
+	memset(payload, 'x', sizeof(payload));
+	std::vector<q_elt> batch;
+	size_t delivered = 0;
+	unsigned long allocations = 0;
+	std::chrono::nanoseconds totalTime(0);
+
+	for (par->globaltime = 0; par->globaltime < benchTicks; par->globaltime++)
+	{
+		unsigned long allocationsBefore = en->getPoolStats().allocations;
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < numNodes; i++)
+		{
+			for (int p = 1; p <= peers; p++)
+			{
+				for (int m = 0; m < msgsPerLink; m++)
+				{
+					en->ENsend(addrs[i], addrs[(i + p) % numNodes],
+					           payload, sizeof(payload), CHANNEL_MEMBERSHIP);
+				}
+			}
+		}
+		for (int i = 0; i < numNodes; i++)
+		{
+			delivered += en->ENrecvBatch(addrs[i], batch, CHANNEL_MEMBERSHIP);
+			for (const q_elt& msg : batch)
+			{
+				en->ENrelease((char *)msg.elt);
+			}
+			batch.clear();
+		}
+		totalTime += std::chrono::steady_clock::now() - start;
+		allocations += en->getPoolStats().allocations - allocationsBefore;
+		en->ENtick();
+	}
+
+	printf("%10s %8d %10d %12zu %12.1f %14.1f\n",
+	       coalesce ? "coalesce" : "plain", numNodes, msgsPerLink, delivered,
+	       delivered ? (double)totalTime.count() / delivered : 0.0,
+	       (double)allocations / benchTicks);
+}
+
+/**
+ * CLASS NAME: Stopwatch
+ *
+ * DESCRIPTION: Time and allocations spent between start() and stop(),
+ *              summed over every such interval, printed per operation.
+ */
+class Stopwatch
+{
+private:
+	std::chrono::nanoseconds time;
+	unsigned long allocs;
+	std::chrono::steady_clock::time_point started;
+	unsigned long allocsStarted;
+public:
+	Stopwatch() : time(0), allocs(0), allocsStarted(0) {}
+
+	void start()
+	{
+		allocsStarted = allocations;
+		started = std::chrono::steady_clock::now();
+	}
+	void stop()
+	{
+		time += std::chrono::steady_clock::now() - started;
+		allocs += allocations - allocsStarted;
+	}
+	void print(const std::string& name, long ops) const
+	{
+		printf("%-44s %10ld %12.1f %12.2f\n", name.c_str(), ops,
+		       (double)time.count() / ops, (double)allocs / ops);
+	}
+};
+
+/**
+ * FUNCTION NAME: benchOp
+ *
+ * DESCRIPTION: Calls op(i) for every i below `iterations` and prints the
+ *              cost per call as the row `name`.
+ */
+template <typename Op>
+void benchOp(const std::string& name, long iterations, Op op)
+{
+	Stopwatch watch;
+	watch.start();
+	for (long i = 0; i < iterations; i++)
+	{
+		op(i);
+	}
+	watch.stop();
+	watch.print(name, iterations);
+}
+
+/**
+ * FUNCTION NAME: createParams
+ *
+ * DESCRIPTION: Parameters of a benchmark run, without a test file
+ */
+std::shared_ptr<Params> createParams(int numNodes)
+{
+	std::shared_ptr<Params> par = std::make_shared<Params>();
+	par->setNodeCount(numNodes);
+	par->globaltime = 0;
+	return par;
+}
+
+/**
+ * FUNCTION NAME: createMemberList
+ *
+ * DESCRIPTION: Fills the member list of `member` with nodes 1 to `numNodes`
+ */
+void createMemberList(Member& member, int numNodes, long heartbeat)
+{
+	member.memberList.clear();
+	for (int id = 1; id <= numNodes; id++)
+	{
+		member.memberList.emplace_back(id, 0, heartbeat, 0);
+	}
+	member.memberListVersion++;
+}
+
+/**
+ * FUNCTION NAME: benchSendRecv
+ *
+ * DESCRIPTION: Measures ENsend and ENrecvBatch on their own, with
+ *              `numNodes` nodes each sending 10 `payloadSize` byte messages
+ *              to random peers per tick.
+ */
+void benchSendRecv(int numNodes, int payloadSize)
+{
+	const int msgsPerNode = 10;
+	std::shared_ptr<Params> par = createParams(numNodes);
+	std::unique_ptr<EmulNet> en = std::make_unique<EmulNet>(par);
+	en->setDeliveryMode(HANDOFF);
+	std::vector<Address> addrs;
+	for (int i = 0; i < numNodes; i++)
+	{
+		addrs.emplace_back(en->ENinit());
+	}
+
+	std::vector<char> payload(payloadSize, 'x');
+	std::vector<q_elt> batch;
+	Stopwatch send;
+	Stopwatch recv;
+	long sent = 0;
+	long delivered = 0;
+	for (par->globaltime = 0; par->globaltime < benchTicks; par->globaltime++)
+	{
+		send.start();
+		for (int i = 0; i < numNodes; i++)
+		{
+			for (int m = 0; m < msgsPerNode; m++)
+			{
+				en->ENsend(addrs[i], addrs[rand() % numNodes], payload.data(),
+				           payloadSize, CHANNEL_MEMBERSHIP);
+			}
+		}
+		send.stop();
+		sent += numNodes * msgsPerNode;
+
+		recv.start();
+		for (int i = 0; i < numNodes; i++)
+		{
+			delivered += en->ENrecvBatch(addrs[i], batch, CHANNEL_MEMBERSHIP);
+			for (const q_elt& msg : batch)
+			{
+				en->ENrelease((char *)msg.elt);
+			}
+			batch.clear();
+		}
+		recv.stop();
+		en->ENtick();
+	}
+
+	std::string size = " " + to_string(numNodes) + " nodes " +
+	                   to_string(payloadSize) + " B";
+	send.print("EmulNet::ENsend" + size, sent);
+	recv.print("EmulNet::ENrecvBatch per msg" + size, delivered);
+}
+
+/**
+ * FUNCTION NAME: benchGossip
+ *
+ * DESCRIPTION: Measures building a GossipMessage of `numNodes` members and
+ *              handling it at a node that knows all of them, as
+ *              MP1Node::handleGossipMessage does for every gossip received
+ *              (through recvCallBack, the only way in).
+ */
+void benchGossip(int numNodes, std::shared_ptr<Log> log)
+{
+	const long rounds = 2000;
+	std::shared_ptr<Params> par = createParams(numNodes + 1);
+	std::shared_ptr<EmulNet> en = std::make_shared<EmulNet>(par);
+	std::shared_ptr<Member> member = std::make_shared<Member>();
+	Address addr = en->ENinit();
+	MP1Node node(member, *par, en, log, addr);
+	char joinAddr[] = "1:0";
+	node.nodeStart(joinAddr, par->PORTNUM);
+
+	Member sender;
+	Address senderAddr = en->ENinit();
+	createMemberList(sender, numNodes, 1);
+	std::string suffix = " " + to_string(numNodes) + " members";
+
+	benchOp("GossipMessage build" + suffix, rounds, [&](long)
+	{
+		GossipMessage msg(senderAddr, sender.memberList);
+	});
+
+	// Learn every member once, then every round brings new heartbeats.
+	GossipMessage first(senderAddr, sender.memberList);
+	node.recvCallBack(first.getMessage(), first.getMessageSize());
+	Stopwatch watch;
+	for (long r = 0; r < rounds; r++)
+	{
+		for (MemberListEntry& entry : sender.memberList)
+		{
+			entry.setheartbeat(r + 2);
+		}
+		GossipMessage msg(senderAddr, sender.memberList);
+		watch.start();
+		node.recvCallBack(msg.getMessage(), msg.getMessageSize());
+		watch.stop();
+	}
+	watch.print("MP1Node::handleGossipMessage" + suffix, rounds);
+}
+
+/**
+ * FUNCTION NAME: benchMessage
+ *
+ * DESCRIPTION: Measures serializing and parsing a KV store message with a
+ *              `valueSize` byte value
+ */
+void benchMessage(int valueSize)
+{
+	const long rounds = 100000;
+	Address from;
+	from.init();
+	Message msg(42, from, CREATE, "key42", std::string(valueSize, 'v'),
+	            PRIMARY);
+	std::string str = msg.toString();
+	std::string suffix = " " + to_string(valueSize) + " B value";
+	size_t length = 0;
+
+	benchOp("Message::toString" + suffix, rounds, [&](long)
+	{
+		length += msg.toString().size();
+	});
+	benchOp("Message parse" + suffix, rounds, [&](long)
+	{
+		Message parsed(str);
+		length += parsed.value.size();
+	});
+	if (length == 0)
+	{
+		printf("Message benchmark optimized away\n");
+	}
+}
+
+/**
+ * FUNCTION NAME: benchHashTable
+ *
+ * DESCRIPTION: Measures the CRUD operations of a HashTable of `numKeys`
+ *              keys
+ */
+void benchHashTable(long numKeys)
+{
+	HashTable table;
+	std::vector<std::string> keys;
+	for (long i = 0; i < numKeys; i++)
+	{
+		keys.emplace_back("key" + to_string(i));
+	}
+	std::string value(100, 'v');
+	std::string suffix = " " + to_string(numKeys) + " keys";
+
+	benchOp("HashTable::create" + suffix, numKeys, [&](long i)
+	{
+		table.create(keys[i], value);
+	});
+	benchOp("HashTable::read" + suffix, numKeys, [&](long i)
+	{
+		table.read(keys[(i * 7919) % numKeys]);
+	});
+	benchOp("HashTable::update" + suffix, numKeys, [&](long i)
+	{
+		table.update(keys[(i * 7919) % numKeys], value);
+	});
+	benchOp("HashTable::deleteKey" + suffix, numKeys, [&](long i)
+	{
+		table.deleteKey(keys[i]);
+	});
+}
+
+/**
+ * FUNCTION NAME: benchRing
+ *
+ * DESCRIPTION: Measures MP2Node::updateRing rebuilding the ring of
+ *              `numNodes` nodes and MP2Node::findNodes looking up the
+ *              replicas of a key in it
+ */
+void benchRing(int numNodes, std::shared_ptr<Log> log)
+{
+	const long rounds = std::max(100000L / numNodes, 100L);
+	std::shared_ptr<Params> par = createParams(numNodes);
+	std::shared_ptr<EmulNet> en = std::make_shared<EmulNet>(par);
+	std::shared_ptr<Member> member = std::make_shared<Member>();
+	Address addr = en->ENinit();
+	MP2Node node(member, *par, en, log, addr);
+	member->inited = true;
+	member->inGroup = true;
+	createMemberList(*member, numNodes, 1);
+	node.updateRing();
+	std::string suffix = " " + to_string(numNodes) + " nodes";
+
+	// Every call sees a new membership list version, so it rebuilds.
+	benchOp("MP2Node::updateRing" + suffix, rounds, [&](long)
+	{
+		member->memberListVersion++;
+		node.updateRing();
+	});
+
+	std::vector<std::string> keys;
+	for (int i = 0; i < 1000; i++)
+	{
+		keys.emplace_back("key" + to_string(i));
+	}
+	benchOp("MP2Node::findNodes" + suffix, 100000, [&](long i)
+	{
+		node.findNodes(keys[i % keys.size()]);
+	});
+}
+
+}  // namespace
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: Runs the receive benchmark over a grid of cluster sizes and
+ *              message volumes, the multicast benchmark over a grid of
+ *              fanouts and message sizes, the coalescing benchmark, then
+ *              the hot paths one by one.
+ **********************************/
+int main()
+{
+	srand(0);
+	printf("EmulNet receive cost per tick (%d ticks per row)\n", benchTicks);
+	printf("%14s %8s %10s %12s %16s %12s %12s %12s\n",
+	       "mode", "nodes", "msgs/node", "delivered", "ns/tick", "ns/msg",
+	       "allocs/tick", "mallocs/tick");
+
+	const int nodeCounts[] = {10, 100, 1000};
+	const int msgVolumes[] = {1, 10, 25};
+	const DeliveryMode modes[] = {COPY_ON_RECV, HANDOFF};
+	for (DeliveryMode mode : modes)
+	{
+		for (bool batched : {false, true})
+		{
+			for (int numNodes : nodeCounts)
+			{
+				for (int msgsPerNode : msgVolumes)
+				{
+					benchReceive(numNodes, msgsPerNode, mode, batched);
+				}
+			}
+		}
+	}
+
+	printf("\nEmulNet multicast cost per message\n");
+	printf("%10s %8s %8s %14s %14s %12s\n",
+	       "api", "fanout", "bytes", "send ns", "send+recv ns", "allocs");
+	const int fanouts[] = {3, 10, 50};
+	const int payloadSizes[] = {64, 1024, 3000};
+	for (int fanout : fanouts)
+	{
+		for (int payloadSize : payloadSizes)
+		{
+			benchMulticast(fanout, payloadSize, false);
+			benchMulticast(fanout, payloadSize, true);
+		}
+	}
+
+	printf("\nEmulNet send+recv cost per message, %d peers per node\n", 3);
+	printf("%10s %8s %10s %12s %12s %14s\n",
+	       "mode", "nodes", "msgs/link", "delivered", "ns/msg", "allocs/tick");
+	for (int numNodes : {100, 1000})
+	{
+		for (int msgsPerLink : {1, 2, 4})
+		{
+			benchCoalesce(numNodes, msgsPerLink, false);
+			benchCoalesce(numNodes, msgsPerLink, true);
+		}
+	}
+
+	// The protocols log as they would in a run without --debug.
+	std::shared_ptr<Log> log = std::make_shared<Log>(createParams(1), false);
+	printf("\nHot paths, each on its own\n");
+	printf("%-44s %10s %12s %12s\n", "operation", "ops", "ns/op", "allocs/op");
+	for (int numNodes : {10, 100, 1000})
+	{
+		benchSendRecv(numNodes, 64);
+	}
+	for (int numNodes : {10, 100, 250})
+	{
+		benchGossip(numNodes, log);
+	}
+	for (int valueSize : {10, 1000})
+	{
+		benchMessage(valueSize);
+	}
+	for (long numKeys : {1000L, 100000L})
+	{
+		benchHashTable(numKeys);
+	}
+	for (int numNodes : {10, 100, 1000})
+	{
+		benchRing(numNodes, log);
+	}
+
+	return SUCCESS;
+}
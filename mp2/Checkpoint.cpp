@@ -0,0 +1,163 @@
+/**********************************
+ * FILE NAME: Checkpoint.cpp
+ *
+ * DESCRIPTION: Definition of the simulator state checkpoints
+ **********************************/
+
+#include "Checkpoint.h"
+#include <errno.h>
+
+/**
+ * Constructor
+ */
+CheckpointWriter::CheckpointWriter(const std::string& path)
+	: path(path), partPath(path + ".part")
+{
+	file = fopen(partPath.c_str(), "wb");
+	if (file == NULL)
+	{
+		throw std::runtime_error("CheckpointWriter: cannot open " + partPath +
+		                         ": " + strerror(errno));
+	}
+	setvbuf(file, NULL, _IOFBF, Config::checkpointBufferBytes);
+	writeBytes(Config::checkpointMagic.data(), Config::checkpointMagic.size());
+}
+
+/**
+ * Destructor. A checkpoint that was not closed is thrown away.
+ */
+CheckpointWriter::~CheckpointWriter()
+{
+	if (file != NULL)
+	{
+		fclose(file);
+		remove(partPath.c_str());
+	}
+}
+
+/**
+ * FUNCTION NAME: section
+ *
+ * DESCRIPTION: Starts the part of the state tagged `tag`, four letters
+ */
+void CheckpointWriter::section(const char *tag)
+{
+	writeBytes(tag, 4);
+}
+
+/**
+ * FUNCTION NAME: writeBytes
+ *
+ * DESCRIPTION: Appends `size` bytes
+ */
+void CheckpointWriter::writeBytes(const void *data, size_t size)
+{
+	if (size > 0 && fwrite(data, size, 1, file) != 1)
+	{
+		throw std::runtime_error("CheckpointWriter: cannot write " + partPath +
+		                         ": " + strerror(errno));
+	}
+}
+
+/**
+ * FUNCTION NAME: writeString
+ *
+ * DESCRIPTION: Appends the length of `value` and its bytes
+ */
+void CheckpointWriter::writeString(const std::string& value)
+{
+	write(value.size());
+	writeBytes(value.data(), value.size());
+}
+
+/**
+ * FUNCTION NAME: close
+ *
+ * DESCRIPTION: Writes out the checkpoint and gives it its name
+ */
+void CheckpointWriter::close()
+{
+	bool failed = fclose(file) != 0;
+	file = NULL;
+	if (failed || rename(partPath.c_str(), path.c_str()) != 0)
+	{
+		int error = errno;
+		remove(partPath.c_str());
+		throw std::runtime_error("CheckpointWriter: cannot write " + path +
+		                         ": " + strerror(error));
+	}
+}
+
+/**
+ * Constructor
+ */
+CheckpointReader::CheckpointReader(const std::string& path)
+	: path(path)
+{
+	file = fopen(path.c_str(), "rb");
+	if (file == NULL)
+	{
+		throw std::runtime_error("CheckpointReader: cannot open " + path + ": " +
+		                         strerror(errno));
+	}
+	setvbuf(file, NULL, _IOFBF, Config::checkpointBufferBytes);
+
+	std::string magic(Config::checkpointMagic.size(), '\0');
+	if (fread(&magic[0], 1, magic.size(), file) != magic.size() ||
+	    magic != Config::checkpointMagic)
+	{
+		fclose(file);
+		throw std::runtime_error("CheckpointReader: " + path +
+		                         " is not a checkpoint");
+	}
+}
+
+/**
+ * Destructor
+ */
+CheckpointReader::~CheckpointReader()
+{
+	fclose(file);
+}
+
+/**
+ * FUNCTION NAME: section
+ *
+ * DESCRIPTION: Checks that the part of the state tagged `tag` comes next
+ */
+void CheckpointReader::section(const char *tag)
+{
+	char found[4];
+	readBytes(found, 4);
+	if (memcmp(found, tag, 4) != 0)
+	{
+		throw std::runtime_error("CheckpointReader: " + path + " has " +
+		                         std::string(found, 4) + " where " +
+		                         std::string(tag, 4) + " belongs");
+	}
+}
+
+/**
+ * FUNCTION NAME: readBytes
+ *
+ * DESCRIPTION: Reads the next `size` bytes into `data`
+ */
+void CheckpointReader::readBytes(void *data, size_t size)
+{
+	if (size > 0 && fread(data, size, 1, file) != 1)
+	{
+		throw std::runtime_error("CheckpointReader: " + path + " is truncated");
+	}
+}
+
+/**
+ * FUNCTION NAME: readString
+ *
+ * DESCRIPTION: Reads a string written by CheckpointWriter::writeString
+ */
+std::string CheckpointReader::readString()
+{
+	std::string value(read<size_t>(), '\0');
+	readBytes(&value[0], value.size());
+	return value;
+}
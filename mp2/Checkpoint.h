@@ -0,0 +1,101 @@
+/**********************************
+ * FILE NAME: Checkpoint.h
+ *
+ * DESCRIPTION: Header file of the simulator state checkpoints
+ **********************************/
+
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include "stdincludes.h"
+#include "Config.h"
+#include <type_traits>
+
+/**
+ * CLASS NAME: CheckpointWriter
+ *
+ * DESCRIPTION: Streams the state of a run to a checkpoint file, one field
+ *              at a time, through a stdio buffer of
+ *              Config::checkpointBufferBytes.
+ *
+ * A checkpoint starts with Config::checkpointMagic. Every part of the state
+ * then starts with a four letter section tag, so reading a checkpoint of
+ * another layout fails at the first section that moved instead of loading
+ * garbage. Fields are in the byte order of the host that wrote them.
+ *
+ * The file is written under a temporary name and renamed by close(), so a
+ * run stopped halfway never leaves a truncated checkpoint behind.
+ */
+class CheckpointWriter {
+private:
+	std::string path;
+	std::string partPath;
+	FILE *file;
+public:
+	CheckpointWriter(const std::string& path);
+	~CheckpointWriter();
+	CheckpointWriter(const CheckpointWriter&) = delete;
+	CheckpointWriter& operator = (const CheckpointWriter&) = delete;
+
+	void section(const char *tag);
+	void writeBytes(const void *data, size_t size);
+	void writeString(const std::string& value);
+	template <typename T> void write(const T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value,
+		              "only plain values are written as they are");
+		writeBytes(&value, sizeof(T));
+	}
+	template <typename T> void writeVector(const std::vector<T>& values)
+	{
+		write(values.size());
+		for (const T& value : values)
+		{
+			write(value);
+		}
+	}
+	void close();
+};
+
+/**
+ * CLASS NAME: CheckpointReader
+ *
+ * DESCRIPTION: Reads a checkpoint back in the order it was written. Every
+ *              read throws if the file ends early.
+ */
+class CheckpointReader {
+private:
+	std::string path;
+	FILE *file;
+public:
+	CheckpointReader(const std::string& path);
+	~CheckpointReader();
+	CheckpointReader(const CheckpointReader&) = delete;
+	CheckpointReader& operator = (const CheckpointReader&) = delete;
+
+	void section(const char *tag);
+	void readBytes(void *data, size_t size);
+	std::string readString();
+	template <typename T> void read(T& value)
+	{
+		static_assert(std::is_trivially_copyable<T>::value,
+		              "only plain values are read as they are");
+		readBytes(&value, sizeof(T));
+	}
+	template <typename T> T read()
+	{
+		T value;
+		read(value);
+		return value;
+	}
+	template <typename T> void readVector(std::vector<T>& values)
+	{
+		values.resize(read<size_t>());
+		for (T& value : values)
+		{
+			read(value);
+		}
+	}
+};
+
+#endif  // CHECKPOINT_H_
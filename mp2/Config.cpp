@@ -16,6 +16,13 @@ const short Config::numReplicas = 3;
 const short Config::numInserts = 100;
 const short Config::keyLength = 5;
 
+// Emulation Variables
+const double Config::enHighWatermark = 0.75;
+const double Config::linkDelayTailShape = 1.5;
+const std::string Config::shmPrefix = "emulnet";
+const std::string Config::traceMagic = "ENTRACE1";
+const std::string Config::checkpointMagic = "MP2CKPT1";
+
 // Logging Configuration Variables
 const int Config::maxWrites = 1;
 const std::string Config::magicNumber = "CS425";
@@ -14,9 +14,12 @@ class Config {
 public:
   // KV Store Configuration Variables
   static const short ringSize;
-  static constexpr short totalRunningTime = 700;
-  static constexpr short insertTime = totalRunningTime - 600;
-  static constexpr short testTime = insertTime + 50;
+  // Default length of a run (Params can override it with
+  // TOTAL_RUNNING_TIME). The test pairs are inserted and tested this long
+  // before the end of the run, see Params::insertTime.
+  static constexpr int totalRunningTime = 700;
+  static constexpr int insertLead = 600;
+  static constexpr int testLead = insertLead - 50;
   static const short stabilizeTime;
   static const short firstFailTime;
   static const short lastFailTime;
@@ -25,9 +28,39 @@ public:
   static const short keyLength;
 
   // Emulation Variables
-  static constexpr short maxNodes = 1000;
-  static constexpr short maxTime = 3600;
-  static constexpr size_t enBuffSize = 30000;
+  // Default cap on the bytes held in flight by an EmulNet, raised by
+  // enMemoryPerNode bytes per node in larger runs (Params can override it
+  // with EN_MEMORY_CAP).
+  static constexpr size_t enMemoryCap = 64 * 1024 * 1024;
+  static constexpr size_t enMemoryPerNode = 64 * 1024;
+  // Default largest message, raised by msgBytesPerNode bytes per node in
+  // larger runs so a gossip message can list every node (Params can
+  // override it with MAX_MSG_SIZE).
+  static constexpr int maxMsgSize = 4000;
+  static constexpr int msgBytesPerNode = 32;
+  // Fraction of the cap above which senders holding more than their fair
+  // share of the in-flight bytes are told to back off (MP1Node then holds
+  // its gossip rounds).
+  static const double enHighWatermark;
+  // Shape of the Pareto distribution used for long-tail link delays.
+  static const double linkDelayTailShape;
+  // First loopback port used by the UDP transport (Params can override it
+  // with UDP_BASE_PORT).
+  static constexpr int udpBasePort = 20000;
+  // Largest UDP payload over IPv4; a datagram holds the channel and the body.
+  static constexpr int udpMaxPayload = 65507;
+  // Default size of the ring of every node of the shared memory transport
+  // and prefix of the ring names (Params: SHM_RING_BYTES, SHM_PREFIX).
+  static constexpr size_t shmRingBytes = 1024 * 1024;
+  static const std::string shmPrefix;
+  // Bytes gathered before a trace is written out, and the first bytes of
+  // every trace file (see TraceWriter).
+  static constexpr size_t traceBufferBytes = 64 * 1024;
+  static const std::string traceMagic;
+  // Stdio buffer of a checkpoint file, and its first bytes (see
+  // CheckpointWriter).
+  static constexpr size_t checkpointBufferBytes = 1024 * 1024;
+  static const std::string checkpointMagic;
 
   // Logging Configuration Variables
   static const int maxWrites;  // number of writes after which to flush file
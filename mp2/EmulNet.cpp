@@ -12,19 +12,23 @@
 EmulNet::EmulNet(std::shared_ptr<Params> p)
 {
 	//trace.funcEntry("EmulNet::EmulNet");
-	int i,j;
+	int i;
 	par = std::move(p);
+	pool = std::make_shared<EnvelopePool>();
+	deliveryMode = COPY_ON_RECV;
+	inFlightBytes = 0;
+	for (i = 0; i < NUM_DROP_REASONS; i++)
+	{
+		drops[i] = 0;
+	}
+	defaultDelay.model = par->LINK_DELAY_MODEL;
+	defaultDelay.minDelay = par->LINK_DELAY_MIN;
+	defaultDelay.maxDelay = std::max(par->LINK_DELAY_MIN, par->LINK_DELAY_MAX);
+	wheelTime = 0;
+	growWheel(defaultDelay.maxDelay);
 	emulnet.setNextId(1);
 	emulnet.settCurrBuffSize(0);
 	enInited=0;
-	for (i = 0; i < Config::maxNodes; i++)
-	{
-		for (j = 0; j < Config::maxTime; j++)
-		{
-			sent_msgs[i][j] = 0;
-			recv_msgs[i][j] = 0;
-		}
-	}
 	//trace.funcExit("EmulNet::EmulNet", SUCCESS);
 }
 
@@ -33,16 +37,31 @@ EmulNet::EmulNet(std::shared_ptr<Params> p)
  */
 EmulNet::EmulNet(EmulNet &anotherEmulNet)
 {
-	int i, j;
+	int i;
 	this->par = anotherEmulNet.par;
+	this->pool = anotherEmulNet.pool;
+	this->deliveryMode = anotherEmulNet.deliveryMode;
+	this->inFlightBytes = anotherEmulNet.inFlightBytes;
+	this->senderInFlightBytes = anotherEmulNet.senderInFlightBytes;
+	for (i = 0; i < NUM_DROP_REASONS; i++)
+	{
+		this->drops[i] = anotherEmulNet.drops[i];
+	}
+	this->defaultDelay = anotherEmulNet.defaultDelay;
+	this->linkDelays = anotherEmulNet.linkDelays;
+	this->wheel = anotherEmulNet.wheel;
+	this->wheelTime = anotherEmulNet.wheelTime;
+	this->egress = anotherEmulNet.egress;
+	this->capture = anotherEmulNet.capture;
+	this->outboxes = anotherEmulNet.outboxes;
+	this->senders = anotherEmulNet.senders;
+	this->rngs = anotherEmulNet.rngs;
+	this->lanes = anotherEmulNet.lanes;
+	this->arrivals = anotherEmulNet.arrivals;
 	this->enInited = anotherEmulNet.enInited;
-	for (i = 0; i < Config::maxNodes; i++)
+	for (i = 0; i < NUM_CHANNELS; i++)
 	{
-		for (j = 0; j < Config::maxTime; j++)
-		{
-			this->sent_msgs[i][j] = anotherEmulNet.sent_msgs[i][j];
-			this->recv_msgs[i][j] = anotherEmulNet.recv_msgs[i][j];
-		}
+		this->msgCounts[i] = anotherEmulNet.msgCounts[i];
 	}
 	this->emulnet = anotherEmulNet.emulnet;
 }
@@ -52,14 +71,31 @@ EmulNet::EmulNet(EmulNet &anotherEmulNet)
  */
 EmulNet& EmulNet::operator =(EmulNet &anotherEmulNet)
 {
-	int i, j;
+	int i;
 	this->par = anotherEmulNet.par;
+	this->pool = anotherEmulNet.pool;
+	this->deliveryMode = anotherEmulNet.deliveryMode;
+	this->inFlightBytes = anotherEmulNet.inFlightBytes;
+	this->senderInFlightBytes = anotherEmulNet.senderInFlightBytes;
+	for (i = 0; i < NUM_DROP_REASONS; i++)
+	{
+		this->drops[i] = anotherEmulNet.drops[i];
+	}
+	this->defaultDelay = anotherEmulNet.defaultDelay;
+	this->linkDelays = anotherEmulNet.linkDelays;
+	this->wheel = anotherEmulNet.wheel;
+	this->wheelTime = anotherEmulNet.wheelTime;
+	this->egress = anotherEmulNet.egress;
+	this->capture = anotherEmulNet.capture;
+	this->outboxes = anotherEmulNet.outboxes;
+	this->senders = anotherEmulNet.senders;
+	this->rngs = anotherEmulNet.rngs;
+	this->lanes = anotherEmulNet.lanes;
+	this->arrivals = anotherEmulNet.arrivals;
 	this->enInited = anotherEmulNet.enInited;
-	for ( i = 0; i < Config::maxNodes; i++ ) {
-		for ( j = 0; j < Config::maxTime; j++ ) {
-			this->sent_msgs[i][j] = anotherEmulNet.sent_msgs[i][j];
-			this->recv_msgs[i][j] = anotherEmulNet.recv_msgs[i][j];
-		}
+	for (i = 0; i < NUM_CHANNELS; i++)
+	{
+		this->msgCounts[i] = anotherEmulNet.msgCounts[i];
 	}
 	this->emulnet = anotherEmulNet.emulnet;
 	return *this;
@@ -87,46 +123,45 @@ Address EmulNet::ENinit()
 /**
  * FUNCTION NAME: ENsend
  *
- * DESCRIPTION: EmulNet send function
+ * DESCRIPTION: EmulNet send function. On a lane the message is only
+ *              recorded, and all but the checks of its address and size are
+ *              left to mergeLanes, so a message dropped there for the state
+ *              of the network still counts as sent.
  *
  * RETURNS:
- * size
+ * size, or 0 if the message was dropped
  */
 int EmulNet::ENsend(const Address& myaddr,
 	                  const Address& toaddr,
-										char *data,
-										int size)
+										const char *data,
+										int size,
+										NetChannel channel)
 {
 	en_msg *em;
-	static char temp[2048];
+	int departure;
 
-	if ((emulnet.currbuffsize >= Config::enBuffSize) ||
-	    (size + (int)sizeof(en_msg) >= par->MAX_MSG_SIZE))
+	Lane *lane = currentLane();
+	if (lane != nullptr)
+	{
+		// The drop itself is counted when mergeLanes replays the send.
+		recordSend(lane, LANE_SEND, myaddr, &toaddr, 1, data, size, channel);
+		return undeliverable(*(int *)(toaddr.addr), size) == NUM_DROP_REASONS ?
+			size : 0;
+	}
+	if (!admit(*(int *)(myaddr.addr), *(int *)(toaddr.addr),
+	           par->getcurrtime(), size, sizeof(en_msg) + size, departure))
 	{
 		return 0;
 	}
+	if (par->COALESCE)
+	{
+		coalesce(myaddr, toaddr, data, size, channel, departure);
+		return size;
+	}
 
-	em = (en_msg *)malloc(sizeof(en_msg) + size);
-	em->size = size;
-
-	memcpy(&(em->from.addr), &(myaddr.addr), sizeof(em->from.addr));
-	memcpy(&(em->to.addr), &(toaddr.addr), sizeof(em->from.addr));
-	memcpy(em + 1, data, size);
-
-	emulnet.buff[emulnet.currbuffsize++] = em;
-
-	int src = *(int *)(myaddr.addr);
-	int time = par->getcurrtime();
-
-	assert(src <= Config::maxNodes);
-	assert(time < Config::maxTime);
-
-	sent_msgs[src][time]++;
-
-	snprintf(temp, sizeof(temp),
-		       "Sending 4+%d B msg type %d to %d.%d.%d.%d:%d ",
-					 size-4, *(int *)data, toaddr.addr[0], toaddr.addr[1],
-					 toaddr.addr[2], toaddr.addr[3], *(short *)&(toaddr.addr[4]));
+	em = newEnvelope(myaddr, toaddr, size, nullptr, channel);
+	memcpy(bodyOf(em), data, size);
+	schedule(em, departure);
 
 	return size;
 }
@@ -141,19 +176,103 @@ int EmulNet::ENsend(const Address& myaddr,
  */
 int EmulNet::ENsend(const Address& myaddr,
 	                  const Address& toaddr,
-										std::string data)
+										std::string data,
+										NetChannel channel)
+{
+	return this->ENsend(myaddr, toaddr, data.data(), (int)data.size(), channel);
+}
+
+/**
+ * FUNCTION NAME: ENsendMany
+ *
+ * DESCRIPTION: Sends the same message to every address in `toaddrs`. The body
+ *              is copied once, into one buffer along with the envelopes of
+ *              all the destinations, and counted in flight once. Each
+ *              destination is still dropped, delayed and counted on its own,
+ *              as if it had been sent with ENsend. With
+ *              Params::COALESCE the body is copied into the batch of every
+ *              destination instead, so that it keeps its place among the
+ *              other messages sent to that destination. On a lane the
+ *              destinations are counted as ENsend does.
+ *
+ * RETURNS:
+ * number of destinations the message was sent to
+ */
+int EmulNet::ENsendMany(const Address& myaddr,
+	                      const std::vector<Address>& toaddrs,
+	                      const char *data,
+	                      int size,
+	                      NetChannel channel)
+{
+	en_payload *shared = nullptr;
+	int sent = 0;
+	int src = *(int *)(myaddr.addr);
+	int time = par->getcurrtime();
+
+	Lane *lane = currentLane();
+	if (lane != nullptr)
+	{
+		recordSend(lane, LANE_SEND_MANY, myaddr, toaddrs.data(), toaddrs.size(),
+		           data, size, channel);
+		for (const Address& toaddr : toaddrs)
+		{
+			if (undeliverable(*(int *)(toaddr.addr), size) == NUM_DROP_REASONS)
+			{
+				sent++;
+			}
+		}
+		return sent;
+	}
+	for (size_t i = 0; i < toaddrs.size(); i++)
+	{
+		const Address& toaddr = toaddrs[i];
+		int departure;
+		// Only the first envelope brings the body into the network.
+		size_t held = sizeof(en_msg) + (shared == nullptr ? size : 0);
+		if (!admit(src, *(int *)(toaddr.addr), time, size, held, departure))
+		{
+			continue;
+		}
+		if (par->COALESCE)
+		{
+			coalesce(myaddr, toaddr, data, size, channel, departure);
+			sent++;
+			continue;
+		}
+		if (shared == nullptr)
+		{
+			shared = newShared(src, data, size, toaddrs.size() - i);
+		}
+		schedule(newEnvelope(myaddr, toaddr, size, shared, channel), departure);
+		sent++;
+	}
+
+	return sent;
+}
+
+/**
+ * FUNCTION NAME: ENsendMany
+ *
+ * DESCRIPTION: Sends the same message to every address in `toaddrs`
+ *
+ * RETURNS:
+ * number of destinations the message was sent to
+ */
+int EmulNet::ENsendMany(const Address& myaddr,
+	                      const std::vector<Address>& toaddrs,
+	                      const std::string& data,
+	                      NetChannel channel)
 {
-	char * str = (char *) malloc(data.length() * sizeof(char));
-	memcpy(str, data.c_str(), data.size());
-	int ret = this->ENsend(myaddr, toaddr, str, (data.length() * sizeof(char)));
-	free(str);
-	return ret;
+	return this->ENsendMany(myaddr, toaddrs, data.data(), (int)data.size(),
+	                        channel);
 }
 
 /**
  * FUNCTION NAME: ENrecv
  *
- * DESCRIPTION: EmulNet receive function
+ * DESCRIPTION: EmulNet receive function. Hands every message waiting for
+ *              `myaddr` on `channel` to the callback `enq`, together with
+ *              `queue`.
  *
  * RETURN:
  * 0
@@ -162,88 +281,1337 @@ int EmulNet::ENrecv(const Address& myaddr,
 	                  int (* enq)(void *, char *, int),
 										struct timeval *t,
 										int times,
-										void *queue)
+										void *queue,
+										NetChannel channel)
 {
 	// times is always assumed to be 1
-	int i;
-	char* tmp;
-	int sz;
-	en_msg *emsg;
-
-	for (i = emulnet.currbuffsize - 1; i >= 0; i--)
+	std::vector<en_msg *> *mailbox = takeMailbox(myaddr, channel);
+	if (mailbox == nullptr)
 	{
-		emsg = emulnet.buff[i];
+		return 0;
+	}
 
-		if (0 == strcmp(emsg->to.addr, myaddr.addr))
+	// Messages are delivered in the order they became due.
+	for (en_msg *emsg : *mailbox)
+	{
+		if (emsg->frames > 0)
 		{
-			sz = emsg->size;
-			tmp = (char *) malloc(sz * sizeof(char));
-			memcpy(tmp, (char *)(emsg+1), sz);
-
-			emulnet.buff[i] = emulnet.buff[emulnet.currbuffsize-1];
-			emulnet.currbuffsize--;
+			unpack(emsg, unpacked);
+			for (const q_elt& msg : unpacked)
+			{
+				(*enq)(queue, (char *)msg.elt, msg.size);
+			}
+			unpacked.clear();
+			continue;
+		}
+		int sz = emsg->size;
+		(*enq)(queue, deliver(emsg), sz);
+	}
+	mailbox->clear();
 
-			(*enq)(queue, (char *)tmp, sz);
+	return 0;
+}
 
-			free(emsg);
+/**
+ * FUNCTION NAME: ENrecvBatch
+ *
+ * DESCRIPTION: Appends every message waiting for `myaddr` on `channel` to
+ *              `batch`, in the order they became due. Unlike ENrecv there is no call per
+ *              message, and a caller that keeps `batch` from one tick to the
+ *              next receives without allocating.
+ *
+ * RETURN:
+ * number of messages received
+ */
+int EmulNet::ENrecvBatch(const Address& myaddr, std::vector<q_elt>& batch,
+                         NetChannel channel)
+{
+	std::vector<en_msg *> *mailbox = takeMailbox(myaddr, channel);
+	if (mailbox == nullptr)
+	{
+		return 0;
+	}
 
-			int dst = *(int *)(myaddr.addr);
-			int time = par->getcurrtime();
+	size_t before = batch.size();
+	batch.reserve(before + mailbox->size());
+	for (en_msg *emsg : *mailbox)
+	{
+		if (emsg->frames > 0)
+		{
+			unpack(emsg, batch);
+			continue;
+		}
+		int sz = emsg->size;
+		batch.emplace_back(deliver(emsg), sz);
+	}
+	mailbox->clear();
 
-			assert(dst <= Config::maxNodes);
-			assert(time < Config::maxTime);
+	return (int)(batch.size() - before);
+}
 
-			recv_msgs[dst][time]++;
+/**
+ * FUNCTION NAME: ENrecvAll
+ *
+ * DESCRIPTION: Receives for `myaddr` on every channel at once, appending
+ *              what came on channel c to batches[c]. A null batch leaves the
+ *              messages of its channel waiting.
+ *
+ * RETURN:
+ * number of messages received
+ */
+int EmulNet::ENrecvAll(const Address& myaddr,
+                       std::vector<q_elt> *batches[NUM_CHANNELS])
+{
+	int received = 0;
+	for (int c = 0; c < NUM_CHANNELS; c++)
+	{
+		if (batches[c] != nullptr)
+		{
+			received += ENrecvBatch(myaddr, *batches[c], (NetChannel)c);
 		}
 	}
-
-	return 0;
+	return received;
 }
 
 /**
- * FUNCTION NAME: ENcleanup
+ * FUNCTION NAME: setLinkDelay
  *
- * DESCRIPTION: Cleanup the EmulNet. Called exactly once at the end of the program.
+ * DESCRIPTION: Overrides the delay distribution of the link from `from` to
+ *              `to`. Other links keep the distribution given by Params.
  */
-int EmulNet::ENcleanup()
+void EmulNet::setLinkDelay(const Address& from, const Address& to, LinkDelay delay)
 {
-	emulnet.nextid=0;
-	int i, j;
-	int sent_total, recv_total;
+	delay.maxDelay = std::max(delay.minDelay, delay.maxDelay);
+	linkDelays[linkKey(*(int *)(from.addr), *(int *)(to.addr))] = delay;
+	growWheel(delay.maxDelay);
+}
 
-	FILE* file = fopen("msgcount.log", "w+");
+/**
+ * FUNCTION NAME: ENbackpressure
+ *
+ * DESCRIPTION: Returns true when the in-flight store is above its high
+ *              watermark and `myaddr` holds more than its fair share of it
+ *              (the memory cap split evenly across the nodes). Senders that
+ *              see true should hold back optional traffic until it clears.
+ */
+bool EmulNet::ENbackpressure(const Address& myaddr)
+{
+	if (inFlightBytes < Config::enHighWatermark * par->EN_MEMORY_CAP)
+	{
+		return false;
+	}
+	int src = *(int *)(myaddr.addr);
+	if (src < 0 || src >= (int)senderInFlightBytes.size())
+	{
+		return false;
+	}
+	int numNodes = std::max(emulnet.nextid - 1, 1);
+	return senderInFlightBytes[src] > par->EN_MEMORY_CAP / numNodes;
+}
 
-	while(emulnet.currbuffsize > 0)
+/**
+ * FUNCTION NAME: ENrelease
+ *
+ * DESCRIPTION: Called by a node once it is done with a message body `data`
+ *              it received. In HANDOFF mode this returns the envelope holding
+ *              the body, or the last reference to a shared body, to the pool.
+ *              In COPY_ON_RECV mode the copy is recycled at the end of the
+ *              tick and nothing needs to be done. On a lane the release is
+ *              left to mergeLanes.
+ */
+void EmulNet::ENrelease(char *data)
+{
+	Lane *lane = currentLane();
+	if (lane != nullptr)
 	{
-		free(emulnet.buff[--emulnet.currbuffsize]);
+		LaneOp op = {};
+		op.kind = LANE_RELEASE;
+		op.data = data;
+		lane->ops.push_back(op);
+		return;
+	}
+	if (deliveryMode == HANDOFF)
+	{
+		en_payload *payload = (en_payload *)data - 1;
+		if (payload->inlined == EN_FRAMED)
+		{
+			en_frame *frame = (en_frame *)payload - 1;
+			payload = (en_payload *)((char *)frame - frame->offset);
+			if (--payload->refs == 0)
+			{
+				pool->release((en_msg *)payload - 1);
+			}
+		}
+		else if (payload->inlined)
+		{
+			pool->release((en_msg *)payload - 1);
+		}
+		else if (--payload->refs == 0)
+		{
+			releaseShared(payload);
+		}
 	}
+}
+
+/**
+ * FUNCTION NAME: ENdeliverDue
+ *
+ * DESCRIPTION: Moves the messages that are due to the mailboxes. Receiving
+ *              does this by itself, except on a lane: the main thread calls
+ *              this before the workers of a parallel tick receive.
+ */
+void EmulNet::ENdeliverDue()
+{
+	flushCoalesced();
+	releaseDue();
+}
+
+/**
+ * FUNCTION NAME: ENtakeArrivals
+ *
+ * DESCRIPTION: Appends to `ids` the nodes that got messages in an empty
+ *              mailbox since the last call, and forgets them. Along with
+ *              ENnextDelivery, lets the application visit only the nodes
+ *              with messages to receive. Call ENdeliverDue first to include
+ *              the messages due in the current tick.
+ */
+void EmulNet::ENtakeArrivals(std::vector<int>& ids)
+{
+	ids.insert(ids.end(), arrivals.begin(), arrivals.end());
+	arrivals.clear();
+}
 
-	for (i = 1; i <= par->NUM_PEERS; i++)
+/**
+ * FUNCTION NAME: ENnextDelivery
+ *
+ * DESCRIPTION: Returns the next tick in which a node will have messages to
+ *              receive, INT_MAX if no message is in flight. Valid once the
+ *              coalesced messages of the tick are in the network (ENtick).
+ */
+int EmulNet::ENnextDelivery() const
+{
+	if (!arrivals.empty())
+	{
+		return par->getcurrtime() + 1;
+	}
+	// Every slot holds a single tick, so the first one holding messages is
+	// the earliest.
+	for (int time = wheelTime + 1; time <= wheelTime + (int)wheel.size(); time++)
 	{
-		fprintf(file, "node %3d ", i);
-		sent_total = 0;
-		recv_total = 0;
+		if (!wheel[time & (wheel.size() - 1)].empty())
+		{
+			return time;
+		}
+	}
+	return INT_MAX;
+}
+
+/**
+ * FUNCTION NAME: ENtick
+ *
+ * DESCRIPTION: Called by the application at the end of every tick. Puts the
+ *              coalesced messages of the tick in the network and recycles the
+ *              buffers handed to the nodes during the tick.
+ */
+void EmulNet::ENtick()
+{
+	flushCoalesced();
+	pool->endTick();
+}
+
+/**
+ * FUNCTION NAME: setLanes
+ *
+ * DESCRIPTION: Prepares `numLanes` lanes for the workers of parallel ticks.
+ *              A worker on lane k (WorkerPool::setLane) may then receive,
+ *              send and release concurrently with the workers on the other
+ *              lanes: the network only records what it is asked in the lane,
+ *              and mergeLanes carries it out. Lanes need HANDOFF delivery.
+ */
+void EmulNet::setLanes(int numLanes)
+{
+	assert(deliveryMode == HANDOFF);
+	lanes.clear();
+	lanes.resize(numLanes);
+}
 
-		for (j = 0; j < par->getcurrtime(); j++)
+/**
+ * FUNCTION NAME: mergeLanes
+ *
+ * DESCRIPTION: Carries out what was recorded in the lanes, lane after lane
+ *              and in the order it was recorded, and empties them. Called
+ *              by the main thread once the workers are done.
+ */
+void EmulNet::mergeLanes()
+{
+	for (Lane& lane : lanes)
+	{
+		emulnet.currbuffsize -= lane.taken;
+		for (const LaneOp& op : lane.ops)
 		{
-			sent_total += sent_msgs[i][j];
-			recv_total += recv_msgs[i][j];
-			if (i != 67)
+			switch (op.kind)
 			{
-				fprintf(file, " (%4d, %4d)", sent_msgs[i][j], recv_msgs[i][j]);
-				if (j % 10 == 9)
+				case LANE_DELIVERED:
+					settle(op.emsg);
+					break;
+				case LANE_SEND:
+					this->ENsend(op.from, lane.toaddrs[op.firstTo],
+					             lane.bodies.data() + op.offset, op.size, op.channel);
+					break;
+				case LANE_SEND_MANY:
 				{
-					fprintf(file, "\n         ");
+					std::vector<Address> toaddrs(
+						lane.toaddrs.begin() + op.firstTo,
+						lane.toaddrs.begin() + op.firstTo + op.numTo);
+					this->ENsendMany(op.from, toaddrs,
+					                 lane.bodies.data() + op.offset, op.size, op.channel);
+					break;
 				}
-			}
-			else
-			{
-				fprintf(file, "special %4d %4d %4d\n", j, sent_msgs[i][j], recv_msgs[i][j]);
+				case LANE_RELEASE:
+					ENrelease(op.data);
+					break;
 			}
 		}
-		fprintf(file, "\n");
-		fprintf(file, "node %3d sent_total %6u  recv_total %6u\n\n", i, sent_total, recv_total);
+		lane.ops.clear();
+		lane.bodies.clear();
+		lane.toaddrs.clear();
+		lane.taken = 0;
+	}
+}
+
+/**
+ * FUNCTION NAME: currentLane
+ *
+ * DESCRIPTION: Returns the lane of the calling thread, or null if it works
+ *              directly on the network.
+ */
+EmulNet::Lane *EmulNet::currentLane()
+{
+	int lane = WorkerPool::currentLane();
+	if (lane < 0 || lane >= (int)lanes.size())
+	{
+		return nullptr;
+	}
+	return &lanes[lane];
+}
+
+/**
+ * FUNCTION NAME: recordSend
+ *
+ * DESCRIPTION: Records in `lane` a send of `data` from `myaddr` to the
+ *              `numTo` addresses at `toaddrs`.
+ */
+void EmulNet::recordSend(Lane *lane, LaneOpKind kind, const Address& myaddr,
+                         const Address *toaddrs, size_t numTo,
+                         const char *data, int size, NetChannel channel)
+{
+	LaneOp op = {};
+	op.kind = kind;
+	op.from = myaddr;
+	op.channel = channel;
+	op.offset = lane->bodies.size();
+	op.size = size;
+	op.firstTo = lane->toaddrs.size();
+	op.numTo = numTo;
+	lane->bodies.insert(lane->bodies.end(), data, data + size);
+	lane->toaddrs.insert(lane->toaddrs.end(), toaddrs, toaddrs + numTo);
+	lane->ops.push_back(op);
+}
+
+/**
+ * FUNCTION NAME: bodyOf
+ *
+ * DESCRIPTION: Returns the body of the message in envelope `em`.
+ */
+char *EmulNet::bodyOf(const en_msg *em)
+{
+	return (char *)(em->payload + 1);
+}
+
+/**
+ * FUNCTION NAME: frameBytesOf
+ *
+ * DESCRIPTION: Returns the bytes taken in a coalesced body by the frame of a
+ *              `size` byte message.
+ */
+size_t EmulNet::frameBytesOf(int size)
+{
+	return (sizeof(en_frame) + sizeof(en_payload) + size + 7) & ~(size_t)7;
+}
+
+/**
+ * FUNCTION NAME: undeliverable
+ *
+ * DESCRIPTION: Returns why a message of `size` bytes to node id `dst` can
+ *              never be delivered, whatever the state of the network, or
+ *              NUM_DROP_REASONS if it can.
+ */
+DropReason EmulNet::undeliverable(int dst, int size) const
+{
+	// A zeroed or corrupt address would index outside the mailboxes.
+	if (dst <= 0 || dst > par->NUM_PEERS)
+	{
+		return DROP_BAD_ADDRESS;
+	}
+	if (size + (int)sizeof(en_msg) >= par->MAX_MSG_SIZE)
+	{
+		return DROP_OVERSIZE;
+	}
+	return NUM_DROP_REASONS;
+}
+
+/**
+ * FUNCTION NAME: admit
+ *
+ * DESCRIPTION: Decides whether a message of `size` bytes from node id `src`
+ *              to node id `dst`, adding `held` bytes to the in-flight store,
+ *              enters the network, counting it if dropped. On success
+ *              `departure` is set to the tick it leaves in.
+ */
+bool EmulNet::admit(int src, int dst, int time, int size, size_t held,
+                    int& departure)
+{
+	DropReason reason = undeliverable(dst, size);
+	if (reason != NUM_DROP_REASONS)
+	{
+		drop(reason);
+		return false;
+	}
+	if (par->MSG_DROP_PROB > 0 &&
+	    (int)rngOf(src).below(100) < (int)(par->MSG_DROP_PROB * 100))
+	{
+		drop(DROP_RANDOM);
+		return false;
+	}
+	if (inFlightBytes + held > par->EN_MEMORY_CAP)
+	{
+		drop(DROP_BUFFER_FULL);
+		return false;
 	}
+	departure = reserveEgress(src, time, size);
+	if (departure < 0)
+	{
+		drop(DROP_BANDWIDTH);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: newEnvelope
+ *
+ * DESCRIPTION: Allocates the envelope of a `size` byte message. If `shared`
+ *              is null the envelope has room for the body inline, and for
+ *              `room` more bytes after it, otherwise it takes a reference to
+ *              the `shared` body.
+ */
+en_msg *EmulNet::newEnvelope(const Address& myaddr, const Address& toaddr,
+                             int size, en_payload *shared, NetChannel channel,
+                             size_t room)
+{
+	en_msg *em;
+	if (shared == nullptr)
+	{
+		em = (en_msg *)pool->allocate(sizeof(en_msg) + sizeof(en_payload) +
+		                              size + room);
+		em->payload = (en_payload *)(em + 1);
+		em->payload->refs = 1;
+		em->payload->inlined = 1;
+	}
+	else
+	{
+		// The envelopes follow the shared body in its buffer. They are all
+		// made before any is delivered, so refs counts those made so far.
+		em = (en_msg *)((char *)(shared + 1) + ((size + 7) & ~7)) + shared->refs;
+		em->payload = shared;
+		shared->refs++;
+	}
+	em->size = size;
+	em->frames = 0;
+	em->channel = channel;
+	memcpy(&(em->from.addr), &(myaddr.addr), sizeof(em->from.addr));
+	memcpy(&(em->to.addr), &(toaddr.addr), sizeof(em->from.addr));
+	return em;
+}
+
+/**
+ * FUNCTION NAME: newShared
+ *
+ * DESCRIPTION: Allocates a buffer holding a copy of the `size` byte body
+ *              `data` sent by node id `src`, and room for the envelopes of
+ *              `numTo` destinations, and counts the body in flight.
+ */
+en_payload *EmulNet::newShared(int src, const char *data, int size, size_t numTo)
+{
+	en_shared *header = (en_shared *)pool->allocate(sizeof(en_shared) +
+		sizeof(en_payload) + ((size + 7) & ~7) + numTo * sizeof(en_msg));
+	header->from = src;
+	header->size = size;
+	en_payload *shared = (en_payload *)(header + 1);
+	shared->refs = 0;
+	shared->inlined = 0;
+	memcpy(shared + 1, data, size);
+	trackInFlight(src, size, true);
+	return shared;
+}
+
+/**
+ * FUNCTION NAME: schedule
+ *
+ * DESCRIPTION: Puts envelope `em`, leaving in tick `departure`, in its
+ *              destination mailbox or on the timing wheel, and counts it.
+ */
+void EmulNet::schedule(en_msg *em, int departure)
+{
+	int src = *(int *)(em->from.addr);
+	int dst = *(int *)(em->to.addr);
+	int time = par->getcurrtime();
+
+	em->due = departure + sampleDelay(src, dst);
+
+	releaseDue();
+	if (em->due == time)
+	{
+		putInMailbox(em);
+	}
+	else
+	{
+		growWheel(em->due - time);
+		wheel[em->due & (wheel.size() - 1)].emplace_back(em);
+	}
+	emulnet.currbuffsize++;
+	trackInFlight(em, true);
+
+	if (em->frames == 0)
+	{
+		msgCounts[em->channel].countSent(src, time, em->size);
+		return;
+	}
+	// The messages of a coalesced envelope are counted one by one.
+	char *frames = bodyOf(em);
+	char *end = frames + em->size;
+	while (frames < end)
+	{
+		int size = ((en_frame *)frames)->size;
+		msgCounts[em->channel].countSent(src, time, size);
+		frames += frameBytesOf(size);
+	}
+}
+
+/**
+ * FUNCTION NAME: releaseEnvelope
+ *
+ * DESCRIPTION: Returns envelope `em` to the pool. The envelope of a shared
+ *              body lives in the buffer of the body, which is returned along
+ *              with the last reference to it.
+ */
+void EmulNet::releaseEnvelope(en_msg *em)
+{
+	en_payload *payload = em->payload;
+	if (payload->inlined)
+	{
+		pool->release(em);
+	}
+	else if (--payload->refs == 0)
+	{
+		releaseShared(payload);
+	}
+}
+
+/**
+ * FUNCTION NAME: releaseShared
+ *
+ * DESCRIPTION: Returns the buffer of the shared body `payload`, whose last
+ *              reference was released, to the pool and stops counting it in
+ *              flight.
+ */
+void EmulNet::releaseShared(en_payload *payload)
+{
+	en_shared *header = (en_shared *)payload - 1;
+	trackInFlight(header->from, header->size, false);
+	pool->release(header);
+}
+
+/**
+ * FUNCTION NAME: takeMailbox
+ *
+ * DESCRIPTION: Moves the messages that are due to the mailboxes and returns
+ *              the mailbox of `myaddr` on `channel`, or null if nothing was
+ *              ever sent to it. The caller empties the mailbox.
+ */
+std::vector<en_msg *> *EmulNet::takeMailbox(const Address& myaddr,
+                                            NetChannel channel)
+{
+	int dst = *(int *)(myaddr.addr);
+	Lane *lane = currentLane();
+
+	// Messages sent earlier in the tick can be received right away. The
+	// workers of a parallel tick find them moved already by ENdeliverDue.
+	if (lane == nullptr)
+	{
+		flushCoalesced();
+		releaseDue();
+	}
+
+	int index = dst * NUM_CHANNELS + channel;
+	if (dst < 0 || index >= (int)emulnet.mailboxes.size())
+	{
+		return nullptr;
+	}
+	std::vector<en_msg *> *mailbox = &emulnet.mailboxes[index];
+	if (lane != nullptr)
+	{
+		lane->taken += mailbox->size();
+	}
+	else
+	{
+		emulnet.currbuffsize -= mailbox->size();
+	}
+	return mailbox;
+}
+
+/**
+ * FUNCTION NAME: deliver
+ *
+ * DESCRIPTION: Takes the message in envelope `emsg` out of the network and
+ *              returns the body to hand to the receiving node. The envelope
+ *              may be released, so its fields must be read beforehand.
+ */
+char *EmulNet::deliver(en_msg *emsg)
+{
+	char *body;
+	int sz = emsg->size;
+
+	if (deliveryMode == HANDOFF)
+	{
+		// The node takes ownership of the body and releases it with
+		// ENrelease once it has handled the message.
+		body = bodyOf(emsg);
+		settle(emsg);
+	}
+	else
+	{
+		account(emsg);
+		// The copy handed to the node stays valid until the end of the tick.
+		body = (char *)pool->allocate(sz * sizeof(char));
+		memcpy(body, bodyOf(emsg), sz);
+		pool->releaseAtEndOfTick(body);
+		releaseEnvelope(emsg);
+	}
+	return body;
+}
+
+/**
+ * FUNCTION NAME: settle
+ *
+ * DESCRIPTION: Accounts for the message in envelope `emsg`, just handed off
+ *              to its receiver, which now holds the reference of the
+ *              envelope to the body. On a lane this is left to mergeLanes.
+ */
+void EmulNet::settle(en_msg *emsg)
+{
+	Lane *lane = currentLane();
+	if (lane != nullptr)
+	{
+		LaneOp op = {};
+		op.kind = LANE_DELIVERED;
+		op.emsg = emsg;
+		lane->ops.push_back(op);
+		return;
+	}
+
+	account(emsg);
+}
+
+/**
+ * FUNCTION NAME: account
+ *
+ * DESCRIPTION: Takes the bytes of envelope `emsg` out of the in-flight
+ *              totals and counts and records the delivery of every message
+ *              it holds.
+ */
+void EmulNet::account(const en_msg *emsg)
+{
+	int src = *(int *)(emsg->from.addr);
+	int dst = *(int *)(emsg->to.addr);
+	int time = par->getcurrtime();
+
+	trackInFlight(emsg, false);
+	if (emsg->frames == 0)
+	{
+		msgCounts[emsg->channel].countRecv(dst, time, emsg->size);
+		captureDelivery(src, dst, emsg->channel, bodyOf(emsg), emsg->size);
+		return;
+	}
+
+	char *frames = bodyOf(emsg);
+	char *end = frames + emsg->size;
+	while (frames < end)
+	{
+		en_frame *frame = (en_frame *)frames;
+		char *body = (char *)((en_payload *)(frame + 1) + 1);
+		msgCounts[emsg->channel].countRecv(dst, time, frame->size);
+		captureDelivery(src, dst, emsg->channel, body, frame->size);
+		frames += frameBytesOf(frame->size);
+	}
+}
+
+/**
+ * FUNCTION NAME: coalesce
+ *
+ * DESCRIPTION: Appends the message `data` of `size` bytes to the batch of
+ *              the link from `myaddr` to `toaddr` on `channel` for this
+ *              tick. The batch is put in the network by flushCoalesced.
+ *
+ * The first message of a batch is copied into a plain envelope, sized with
+ * room for the frame of a second message like it, and travels as such if no
+ * other message follows. The second message turns the body into frames,
+ * then every message is copied once into the next frame.
+ */
+void EmulNet::coalesce(const Address& myaddr, const Address& toaddr,
+                       const char *data, int size, NetChannel channel,
+                       int departure)
+{
+	int src = *(int *)(myaddr.addr);
+	if (src >= (int)outboxes.size())
+	{
+		outboxes.resize(src + 1);
+	}
+	Outbox& outbox = outboxes[src];
+	if (outbox.open == 0)
+	{
+		senders.emplace_back(src);
+	}
+
+	CoalesceBatch *batch = nullptr;
+	for (size_t i = 0; i < outbox.open; i++)
+	{
+		const en_msg *em = outbox.batches[i].em;
+		if (memcmp(em->to.addr, toaddr.addr, sizeof(toaddr.addr)) == 0 &&
+		    em->channel == channel &&
+		    outbox.batches[i].departure == departure)
+		{
+			batch = &outbox.batches[i];
+			break;
+		}
+	}
+	if (batch == nullptr)
+	{
+		if (outbox.open == outbox.batches.size())
+		{
+			outbox.batches.resize(outbox.open + 1);
+		}
+		batch = &outbox.batches[outbox.open++];
+		size_t room = 2 * frameBytesOf(size) - size;
+		batch->em = newEnvelope(myaddr, toaddr, size, nullptr, channel, room);
+		batch->departure = departure;
+		batch->room = EnvelopePool::capacityFor(sizeof(en_msg) +
+			sizeof(en_payload) + size + room) - sizeof(en_msg) - sizeof(en_payload);
+		memcpy(bodyOf(batch->em), data, size);
+		return;
+	}
+
+	en_msg *em = batch->em;
+	size_t used = em->frames > 0 ? (size_t)em->size : frameBytesOf(em->size);
+	if (used + frameBytesOf(size) > batch->room)
+	{
+		growBatch(batch, used + frameBytesOf(size));
+		em = batch->em;
+	}
+	char *body = bodyOf(em);
+	if (em->frames == 0)
+	{
+		// The body of the first message moves behind its frame header.
+		int first = em->size;
+		memmove(body + sizeof(en_frame) + sizeof(en_payload), body, first);
+		en_frame *frame = (en_frame *)body;
+		frame->size = first;
+		frame->offset = (int)sizeof(en_payload);
+		en_payload *payload = (en_payload *)(frame + 1);
+		payload->refs = 0;
+		payload->inlined = EN_FRAMED;
+		em->frames = 1;
+		em->size = (int)used;
+	}
+
+	en_frame *frame = (en_frame *)(body + em->size);
+	frame->size = size;
+	frame->offset = (int)(sizeof(en_payload) + em->size);
+	en_payload *payload = (en_payload *)(frame + 1);
+	payload->refs = 0;
+	payload->inlined = EN_FRAMED;
+	memcpy(payload + 1, data, size);
+	em->frames++;
+	em->size += (int)frameBytesOf(size);
+}
+
+/**
+ * FUNCTION NAME: growBatch
+ *
+ * DESCRIPTION: Moves `batch` to an envelope with room for a body of at
+ *              least `needed` bytes, and at least twice its current room.
+ */
+void EmulNet::growBatch(CoalesceBatch *batch, size_t needed)
+{
+	size_t header = sizeof(en_msg) + sizeof(en_payload);
+	size_t bytes = header + std::max(needed, 2 * batch->room);
+	en_msg *em = (en_msg *)pool->allocate(bytes);
+	memcpy((void *)em, batch->em, header + batch->em->size);
+	em->payload = (en_payload *)(em + 1);
+	pool->release(batch->em);
+	batch->em = em;
+	batch->room = EnvelopePool::capacityFor(bytes) - header;
+}
+
+/**
+ * FUNCTION NAME: flushCoalesced
+ *
+ * DESCRIPTION: Puts the envelope of every open batch in the network. A batch
+ *              of a single message goes as a plain message.
+ */
+void EmulNet::flushCoalesced()
+{
+	for (int src : senders)
+	{
+		Outbox& outbox = outboxes[src];
+		for (size_t i = 0; i < outbox.open; i++)
+		{
+			schedule(outbox.batches[i].em, outbox.batches[i].departure);
+		}
+		outbox.open = 0;
+	}
+	senders.clear();
+}
+
+/**
+ * FUNCTION NAME: unpack
+ *
+ * DESCRIPTION: Takes the coalesced envelope `emsg` out of the network and
+ *              appends the messages packed in it to `out`, the same way
+ *              deliver() would hand each of them to the receiving node.
+ */
+void EmulNet::unpack(en_msg *emsg, std::vector<q_elt>& out)
+{
+	char *frames = bodyOf(emsg);
+	char *end = frames + emsg->size;
+
+	while (frames < end)
+	{
+		en_frame *frame = (en_frame *)frames;
+		char *body = (char *)((en_payload *)(frame + 1) + 1);
+
+		if (deliveryMode == HANDOFF)
+		{
+			out.emplace_back(body, frame->size);
+		}
+		else
+		{
+			char *copy = (char *)pool->allocate(frame->size);
+			memcpy(copy, body, frame->size);
+			pool->releaseAtEndOfTick(copy);
+			out.emplace_back(copy, frame->size);
+		}
+		frames += frameBytesOf(frame->size);
+	}
+
+	if (deliveryMode == HANDOFF)
+	{
+		// Every handed off message holds a reference to the coalesced body.
+		// The first one takes over the reference of the envelope.
+		emsg->payload->refs += emsg->frames - 1;
+		settle(emsg);
+	}
+	else
+	{
+		account(emsg);
+		releaseEnvelope(emsg);
+	}
+}
+
+/**
+ * FUNCTION NAME: drop
+ *
+ * DESCRIPTION: Counts a message refused by ENsend.
+ */
+void EmulNet::drop(DropReason reason)
+{
+	drops[reason]++;
+}
+
+/**
+ * FUNCTION NAME: trackInFlight
+ *
+ * DESCRIPTION: Adds or removes the bytes of `em` from the in-flight totals.
+ *              A shared body is counted on its own, see newShared.
+ */
+void EmulNet::trackInFlight(const en_msg *em, bool added)
+{
+	size_t bytes = sizeof(en_msg) + (em->payload->inlined ? em->size : 0);
+	trackInFlight(*(int *)(em->from.addr), bytes, added);
+}
+
+/**
+ * FUNCTION NAME: trackInFlight
+ *
+ * DESCRIPTION: Adds or removes `bytes` held for sender id `src` from the
+ *              in-flight totals.
+ */
+void EmulNet::trackInFlight(int src, size_t bytes, bool added)
+{
+	if (src >= (int)senderInFlightBytes.size())
+	{
+		senderInFlightBytes.resize(src + 1, 0);
+	}
+	if (added)
+	{
+		inFlightBytes += bytes;
+		senderInFlightBytes[src] += bytes;
+	}
+	else
+	{
+		inFlightBytes -= bytes;
+		senderInFlightBytes[src] -= bytes;
+	}
+}
+
+/**
+ * FUNCTION NAME: linkKey
+ *
+ * DESCRIPTION: Key of the link from node id `from` to node id `to`.
+ */
+long long EmulNet::linkKey(int from, int to)
+{
+	return ((long long)from << 32) | (unsigned int)to;
+}
+
+/**
+ * FUNCTION NAME: rngOf
+ *
+ * DESCRIPTION: Returns the random stream of sender id `id`, creating the
+ *              streams up to it on first use
+ */
+Random& EmulNet::rngOf(int id)
+{
+	while (id >= (int)rngs.size())
+	{
+		rngs.emplace_back(par->SEED, RANDOM_NETWORK, rngs.size());
+	}
+	return rngs[id];
+}
+
+/**
+ * FUNCTION NAME: sampleDelay
+ *
+ * DESCRIPTION: Draws the delay, in ticks, of a message sent from node id
+ *              `from` to node id `to`.
+ */
+int EmulNet::sampleDelay(int from, int to)
+{
+	const LinkDelay *delay = &defaultDelay;
+	if (!linkDelays.empty())
+	{
+		auto it = linkDelays.find(linkKey(from, to));
+		if (it != linkDelays.end())
+		{
+			delay = &it->second;
+		}
+	}
+
+	switch (delay->model)
+	{
+		case DELAY_UNIFORM:
+			return delay->minDelay +
+			       (int)rngOf(from).below(delay->maxDelay - delay->minDelay + 1);
+		case DELAY_LONG_TAIL:
+		{
+			// Pareto with scale minDelay + 1, shifted back so the mode is minDelay.
+			double u = 1.0 - rngOf(from).uniform();
+			double sample = (delay->minDelay + 1) * pow(u, -1.0 / Config::linkDelayTailShape) - 1;
+			return (int)std::min(sample, (double)delay->maxDelay);
+		}
+		case DELAY_FIXED:
+		default:
+			return delay->minDelay;
+	}
+}
+
+/**
+ * FUNCTION NAME: reserveEgress
+ *
+ * DESCRIPTION: Books `size` payload bytes on the egress link of node id
+ *              `from`, which carries Params::EGRESS_BYTES_PER_TICK bytes per
+ *              tick. A message always fits on a link that is idle for the
+ *              tick, however large it is.
+ *
+ * RETURNS:
+ * the tick the message leaves in, or -1 if it has to be dropped
+ */
+int EmulNet::reserveEgress(int from, int time, int size)
+{
+	size_t cap = par->EGRESS_BYTES_PER_TICK;
+	if (cap == 0)
+	{
+		return time;
+	}
+	if (from >= (int)egress.size())
+	{
+		egress.resize(from + 1, EgressState{0, 0});
+	}
+
+	EgressState& link = egress[from];
+	if (link.tick < time)
+	{
+		link.tick = time;
+		link.used = 0;
+	}
+	if (link.used > 0 && link.used + size > cap)
+	{
+		if (par->EGRESS_POLICY == EGRESS_DROP)
+		{
+			return -1;
+		}
+		// Queue behind the traffic already booked on the link.
+		link.tick++;
+		link.used = 0;
+	}
+	link.used += size;
+	return link.tick;
+}
+
+/**
+ * FUNCTION NAME: growWheel
+ *
+ * DESCRIPTION: Makes the timing wheel large enough for messages delayed by
+ *              up to `delay` ticks, moving queued messages to their new slot.
+ */
+void EmulNet::growWheel(int delay)
+{
+	size_t slots = wheel.empty() ? 1 : wheel.size();
+	while (slots <= (size_t)delay)
+	{
+		slots <<= 1;
+	}
+	if (slots == wheel.size())
+	{
+		return;
+	}
+
+	std::vector<std::vector<en_msg *>> oldWheel;
+	oldWheel.swap(wheel);
+	wheel.resize(slots);
+	for (auto& slot : oldWheel)
+	{
+		for (en_msg *em : slot)
+		{
+			wheel[em->due & (slots - 1)].emplace_back(em);
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: releaseDue
+ *
+ * DESCRIPTION: Moves the messages that are due by the current tick from the
+ *              timing wheel to their destination mailbox.
+ */
+void EmulNet::releaseDue()
+{
+	int now = par->getcurrtime();
+	if (now < wheelTime)
+	{
+		// The clock was reset; messages still on the wheel keep their slot.
+		wheelTime = now;
+		return;
+	}
+	// Every slot holds a single tick, so one pass over the wheel is enough
+	// however far the clock moved.
+	int ticks = std::min(now - wheelTime, (int)wheel.size());
+	for (int time = now - ticks + 1; time <= now; time++)
+	{
+		std::vector<en_msg *>& slot = wheel[time & (wheel.size() - 1)];
+		for (en_msg *em : slot)
+		{
+			putInMailbox(em);
+		}
+		slot.clear();
+	}
+	wheelTime = now;
+}
+
+/**
+ * FUNCTION NAME: putInMailbox
+ *
+ * DESCRIPTION: Puts envelope `em`, which is due, in its destination mailbox
+ *              and notes the arrival if the mailbox was empty.
+ */
+void EmulNet::putInMailbox(en_msg *em)
+{
+	int dst = *(int *)(em->to.addr);
+	std::vector<en_msg *>& mailbox = emulnet.mailbox(dst, em->channel);
+	if (mailbox.empty())
+	{
+		arrivals.push_back(dst);
+	}
+	mailbox.emplace_back(em);
+}
+
+/**
+ * FUNCTION NAME: setCapture
+ *
+ * DESCRIPTION: Records every message delivered from now on to `writer`. A
+ *              null `writer` stops the recording.
+ */
+void EmulNet::setCapture(std::shared_ptr<TraceWriter> writer)
+{
+	capture = std::move(writer);
+}
+
+/**
+ * FUNCTION NAME: captureDelivery
+ *
+ * DESCRIPTION: Records the message `body` delivered to `to` on `channel`,
+ *              if capturing
+ */
+void EmulNet::captureDelivery(int from, int to, NetChannel channel,
+                              const char *body, int size)
+{
+	if (capture)
+	{
+		capture->record(par->getcurrtime(), channel, from, to, body, size);
+	}
+}
+
+/**
+ * FUNCTION NAME: save
+ *
+ * DESCRIPTION: Writes the network to checkpoint `w`, between ticks: the
+ *              messages in the mailboxes and on the timing wheel with their
+ *              bodies, the random streams, the egress links and the counts.
+ *              Coalesced batches are not written, so COALESCE must be off.
+ */
+void EmulNet::save(CheckpointWriter& w) const
+{
+	if (par->COALESCE)
+	{
+		throw std::runtime_error("EmulNet: cannot checkpoint with COALESCE");
+	}
+	w.section("EMNT");
+	w.write(emulnet.nextid);
+	w.write(drops);
+	w.write(wheelTime);
+	w.writeVector(egress);
+	w.writeVector(rngs);
+	w.write(linkDelays.size());
+	for (const auto& link : linkDelays)
+	{
+		w.write(link.first);
+		w.write(link.second);
+	}
+	for (int c = 0; c < NUM_CHANNELS; c++)
+	{
+		msgCounts[c].save(w);
+	}
+	w.writeVector(arrivals);
+
+	// Every mailbox in delivery order, then the wheel from the next tick on.
+	w.write(emulnet.mailboxes.size());
+	for (const auto& mailbox : emulnet.mailboxes)
+	{
+		w.write(mailbox.size());
+		for (const en_msg *em : mailbox)
+		{
+			saveEnvelope(w, em);
+		}
+	}
+	size_t onWheel = 0;
+	for (const auto& slot : wheel)
+	{
+		onWheel += slot.size();
+	}
+	w.write(wheel.size());
+	w.write(onWheel);
+	for (int time = wheelTime + 1; time <= wheelTime + (int)wheel.size(); time++)
+	{
+		for (const en_msg *em : wheel[time & (wheel.size() - 1)])
+		{
+			saveEnvelope(w, em);
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: load
+ *
+ * DESCRIPTION: Reads the network written by save back from checkpoint `r`
+ *              into this network, which must not have carried any message.
+ *              Bodies shared by several envelopes come back as a copy per
+ *              envelope.
+ */
+void EmulNet::load(CheckpointReader& r)
+{
+	r.section("EMNT");
+	r.read(emulnet.nextid);
+	r.read(drops);
+	r.read(wheelTime);
+	r.readVector(egress);
+	rngs.clear();
+	for (size_t count = r.read<size_t>(); count > 0; count--)
+	{
+		rngs.emplace_back(par->SEED, RANDOM_NETWORK, rngs.size());
+		r.read(rngs.back());
+	}
+	linkDelays.clear();
+	for (size_t count = r.read<size_t>(); count > 0; count--)
+	{
+		long long key = r.read<long long>();
+		linkDelays[key] = r.read<LinkDelay>();
+	}
+	for (int c = 0; c < NUM_CHANNELS; c++)
+	{
+		msgCounts[c].load(r);
+	}
+	r.readVector(arrivals);
+
+	emulnet.mailboxes.resize(r.read<size_t>());
+	for (auto& mailbox : emulnet.mailboxes)
+	{
+		for (size_t count = r.read<size_t>(); count > 0; count--)
+		{
+			mailbox.emplace_back(loadEnvelope(r));
+		}
+	}
+	growWheel((int)r.read<size_t>() - 1);
+	for (size_t count = r.read<size_t>(); count > 0; count--)
+	{
+		en_msg *em = loadEnvelope(r);
+		wheel[em->due & (wheel.size() - 1)].emplace_back(em);
+	}
+}
+
+/**
+ * FUNCTION NAME: saveEnvelope
+ *
+ * DESCRIPTION: Writes the message in envelope `em` to checkpoint `w`
+ */
+void EmulNet::saveEnvelope(CheckpointWriter& w, const en_msg *em) const
+{
+	w.writeBytes(em->from.addr, sizeof(em->from.addr));
+	w.writeBytes(em->to.addr, sizeof(em->to.addr));
+	w.write(em->channel);
+	w.write(em->due);
+	w.write(em->size);
+	w.writeBytes(bodyOf(em), em->size);
+}
+
+/**
+ * FUNCTION NAME: loadEnvelope
+ *
+ * DESCRIPTION: Reads a message written by saveEnvelope into a new envelope,
+ *              counted as in flight
+ */
+en_msg *EmulNet::loadEnvelope(CheckpointReader& r)
+{
+	Address from;
+	Address to;
+	r.readBytes(from.addr, sizeof(from.addr));
+	r.readBytes(to.addr, sizeof(to.addr));
+	NetChannel channel = r.read<NetChannel>();
+	int due = r.read<int>();
+	int size = r.read<int>();
+	en_msg *em = newEnvelope(from, to, size, nullptr, channel);
+	r.readBytes(bodyOf(em), size);
+	em->due = due;
+	emulnet.currbuffsize++;
+	trackInFlight(em, true);
+	return em;
+}
+
+/**
+ * FUNCTION NAME: ENcleanup
+ *
+ * DESCRIPTION: Cleanup the EmulNet. Called exactly once at the end of the program.
+ */
+int EmulNet::ENcleanup()
+{
+	flushCoalesced();
+	emulnet.nextid=0;
+	if (capture)
+	{
+		capture->flush();
+	}
+	int c, i, j;
+	int sent, recv;
+	int sent_total, recv_total;
+	size_t sent_bytes, recv_bytes;
+
+	FILE* file = fopen(par->outputPath("msgcount.log").c_str(), "w+");
+
+	for (auto& mailbox : emulnet.mailboxes)
+	{
+		for (en_msg *emsg : mailbox)
+		{
+			releaseEnvelope(emsg);
+		}
+		mailbox.clear();
+	}
+	for (auto& slot : wheel)
+	{
+		for (en_msg *emsg : slot)
+		{
+			releaseEnvelope(emsg);
+		}
+		slot.clear();
+	}
+	emulnet.currbuffsize = 0;
+	inFlightBytes = 0;
+	senderInFlightBytes.clear();
+
+	const char *channelNames[NUM_CHANNELS] = {"membership", "kvstore"};
+	for (c = 0; c < NUM_CHANNELS; c++)
+	{
+		const MsgCounters& counts = msgCounts[c];
+		fprintf(file, "channel %s\n", channelNames[c]);
+		for (i = 1; i <= par->NUM_PEERS; i++)
+		{
+			fprintf(file, "node %3d ", i);
+			sent_total = 0;
+			recv_total = 0;
+			sent_bytes = 0;
+			recv_bytes = 0;
+
+			for (j = 0; j < par->getcurrtime(); j++)
+			{
+				sent = counts.getSent(i, j);
+				recv = counts.getRecv(i, j);
+				sent_total += sent;
+				recv_total += recv;
+				sent_bytes += counts.getSentBytes(i, j);
+				recv_bytes += counts.getRecvBytes(i, j);
+				if (i != 67)
+				{
+					fprintf(file, " (%4d, %4d)", sent, recv);
+					if (j % 10 == 9)
+					{
+						fprintf(file, "\n         ");
+					}
+				}
+				else
+				{
+					fprintf(file, "special %4d %4d %4d\n", j, sent, recv);
+				}
+			}
+			fprintf(file, "\n");
+			fprintf(file, "node %3d sent_total %6u  recv_total %6u\n", i, sent_total, recv_total);
+			fprintf(file, "node %3d sent_bytes %8zu  recv_bytes %8zu\n\n", i, sent_bytes, recv_bytes);
+		}
+	}
+
+	const PoolStats& stats = pool->getStats();
+	fprintf(file, "envelope pool allocations %lu mallocs %lu\n",
+	        stats.allocations, stats.mallocs);
+	fprintf(file, "dropped buffer_full %lu oversize %lu random %lu bandwidth %lu bad_address %lu\n",
+	        drops[DROP_BUFFER_FULL], drops[DROP_OVERSIZE], drops[DROP_RANDOM],
+	        drops[DROP_BANDWIDTH], drops[DROP_BAD_ADDRESS]);
 
 	fclose(file);
 	return 0;
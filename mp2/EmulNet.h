@@ -12,9 +12,76 @@
 #include "Address.h"
 #include "Params.h"
 #include "Member.h"
+#include "EnvelopePool.h"
+#include "Trace.h"
+#include "Random.h"
+#include "WorkerPool.h"
+#include "Checkpoint.h"
 
 using namespace std;
 
+/**
+ * ENUM NAME: NetChannel
+ *
+ * DESCRIPTION: Protocol a message belongs to. The nodes of both protocols
+ *              share one network, in which every channel has its own
+ *              mailboxes and message counts.
+ */
+enum NetChannel
+{
+	CHANNEL_MEMBERSHIP, // MP1Node
+	CHANNEL_KVSTORE,    // MP2Node
+	NUM_CHANNELS
+};
+
+/**
+ * Struct Name: en_payload
+ *
+ * Header placed right before every message body. A unicast body is stored
+ * inline, right after its en_msg and this header. A body sent to several
+ * nodes with ENsendMany is stored once, after an en_shared header, in a
+ * buffer that also holds the envelopes of every destination.
+ */
+typedef struct en_payload {
+	// Envelopes and handed off bodies still using a shared body
+	int refs;
+	// 1 if the body is stored inline in its envelope, as coalesced bodies
+	// are, EN_FRAMED if it is one of the messages packed in a coalesced body
+	int inlined;
+} en_payload;
+
+#define EN_FRAMED 2
+
+/**
+ * Struct Name: en_shared
+ *
+ * Header of a body shared by the envelopes of ENsendMany, right before its
+ * en_payload. The body is counted in flight once, from the first envelope
+ * until its last reference is released, and each envelope only for itself.
+ */
+typedef struct en_shared {
+	// Sender id the body is counted against
+	int from;
+	// Bytes of the body
+	int size;
+} en_shared;
+
+/**
+ * Struct Name: en_frame
+ *
+ * With Params::COALESCE, the messages sent from one node to another in a
+ * tick travel in a single envelope. Its body holds one frame per message:
+ * this header, an en_payload marked EN_FRAMED and the message body, padded
+ * to 8 bytes. Every message handed off from the frames holds a reference to
+ * the coalesced body, and the last one released frees the envelope.
+ */
+typedef struct en_frame {
+	// Bytes of the message body
+	int size;
+	// Bytes from the en_payload of the coalesced body to this frame
+	int offset;
+} en_frame;
+
 /**
  * Struct Name: en_msg
  */
@@ -25,27 +92,36 @@ typedef struct en_msg {
 	Address from;
 	// Destination node
 	Address to;
+	// Tick at which the message is delivered
+	int due;
+	// Header of the body, which follows it
+	en_payload *payload;
+	// Number of messages packed in the body, 0 if it is a single message
+	int frames;
+	// Protocol of the message
+	NetChannel channel;
 } en_msg;
 
 /**
  * Class Name: EM
+ *
+ * In-flight messages are kept in a mailbox per destination node and channel,
+ * indexed by the node id in the first 4 bytes of the address. A receive
+ * therefore only touches the messages addressed to the receiving node on
+ * that channel.
  */
 class EM {
 public:
 	int nextid;
 	int currbuffsize;
 	int firsteltindex;
-	en_msg* buff[Config::enBuffSize];
+	std::vector<std::vector<en_msg *>> mailboxes;
 	EM() {}
 	EM& operator = (EM &anotherEM) {
 		this->nextid = anotherEM.getNextId();
 		this->currbuffsize = anotherEM.getCurrBuffSize();
 		this->firsteltindex = anotherEM.getFirstEltIndex();
-		int i = this->currbuffsize;
-		while (i > 0) {
-			this->buff[i] = anotherEM.buff[i];
-			i--;
-		}
+		this->mailboxes = anotherEM.mailboxes;
 		return *this;
 	}
 	int getNextId() {
@@ -66,39 +142,330 @@ public:
 	void setFirstEltIndex(int firsteltindex) {
 		this->firsteltindex = firsteltindex;
 	}
+	// Returns the mailbox of node `id` on `channel`, creating it if needed.
+	std::vector<en_msg *>& mailbox(int id, NetChannel channel) {
+		int index = id * NUM_CHANNELS + channel;
+		if (index >= (int)mailboxes.size())
+		{
+			mailboxes.resize((id + 1) * NUM_CHANNELS);
+		}
+		return mailboxes[index];
+	}
 	virtual ~EM() {}
 };
 
+/**
+ * Class Name: MsgCounters
+ *
+ * Number of messages and payload bytes sent and received by each node in
+ * each tick. A node only
+ * stores the ticks up to the last one it sent or received in, so the memory
+ * used follows the nodes and ticks of the run instead of a fixed maximum.
+ */
+class MsgCounters {
+public:
+	struct Count {
+		int sent;
+		int recv;
+		size_t sentBytes;
+		size_t recvBytes;
+	};
+	void countSent(int node, int time, size_t bytes) {
+		Count& c = at(node, time);
+		c.sent++;
+		c.sentBytes += bytes;
+	}
+	void countRecv(int node, int time, size_t bytes) {
+		Count& c = at(node, time);
+		c.recv++;
+		c.recvBytes += bytes;
+	}
+	int getSent(int node, int time) const {
+		const Count *c = find(node, time);
+		return c ? c->sent : 0;
+	}
+	int getRecv(int node, int time) const {
+		const Count *c = find(node, time);
+		return c ? c->recv : 0;
+	}
+	size_t getSentBytes(int node, int time) const {
+		const Count *c = find(node, time);
+		return c ? c->sentBytes : 0;
+	}
+	size_t getRecvBytes(int node, int time) const {
+		const Count *c = find(node, time);
+		return c ? c->recvBytes : 0;
+	}
+	void save(CheckpointWriter& w) const {
+		w.write(counts.size());
+		for (const std::vector<Count>& ticks : counts)
+		{
+			w.writeVector(ticks);
+		}
+	}
+	void load(CheckpointReader& r) {
+		counts.resize(r.read<size_t>());
+		for (std::vector<Count>& ticks : counts)
+		{
+			r.readVector(ticks);
+		}
+	}
+private:
+	// counts[node][time]
+	std::vector<std::vector<Count>> counts;
+	Count& at(int node, int time) {
+		assert(node >= 0 && time >= 0);
+		if (node >= (int)counts.size())
+		{
+			counts.resize(node + 1);
+		}
+		std::vector<Count>& ticks = counts[node];
+		if (time >= (int)ticks.size())
+		{
+			ticks.resize(time + 1, Count());
+		}
+		return ticks[time];
+	}
+	const Count *find(int node, int time) const {
+		if (node < 0 || node >= (int)counts.size() ||
+		    time < 0 || time >= (int)counts[node].size())
+		{
+			return nullptr;
+		}
+		return &counts[node][time];
+	}
+};
+
+/**
+ * STRUCT NAME: LinkDelay
+ *
+ * DESCRIPTION: Delay distribution of a link, in ticks.
+ */
+struct LinkDelay {
+	LinkDelayModel model;
+	int minDelay;
+	int maxDelay;
+};
+
+/**
+ * ENUM NAME: DeliveryMode
+ *
+ * DESCRIPTION: How ENrecv hands a message body to the receiving node.
+ *
+ * COPY_ON_RECV: the node gets a copy that is recycled at the end of the tick.
+ * HANDOFF: the node gets the body inside the original envelope and owns it
+ *          until it calls ENrelease, so the body is only copied at send.
+ */
+enum DeliveryMode
+{
+	COPY_ON_RECV,
+	HANDOFF
+};
+
+/**
+ * ENUM NAME: DropReason
+ *
+ * DESCRIPTION: Why ENsend refused a message.
+ */
+enum DropReason
+{
+	DROP_BUFFER_FULL, // the in-flight store reached its memory cap
+	DROP_OVERSIZE,    // larger than Params::MAX_MSG_SIZE or the transport allows
+	DROP_RANDOM,      // dropped with probability Params::MSG_DROP_PROB
+	DROP_BANDWIDTH,   // over Params::EGRESS_BYTES_PER_TICK with EGRESS_DROP
+	DROP_BAD_ADDRESS, // the destination id is not one of the nodes
+	NUM_DROP_REASONS
+};
+
 /**
  * CLASS NAME: EmulNet
  *
  * DESCRIPTION: This class defines an emulated network
+ *
+ * The ENinit/ENsend/ENrecv/ENrelease/ENtick/ENcleanup functions are virtual so
+ * that other transports (see UdpNet) can carry the same traffic for the
+ * nodes, which only see an EmulNet.
+ *
+ * One network carries the traffic of both protocols. Sends and receives name
+ * the NetChannel they are on, and ENrecvAll takes what a node received on
+ * every channel in one call.
  */
 class EmulNet
 {
-private:
+protected:
 	std::shared_ptr<Params> par;
-	int sent_msgs[Config::maxNodes + 1][Config::maxTime];
-	int recv_msgs[Config::maxNodes + 1][Config::maxTime];
+	MsgCounters msgCounts[NUM_CHANNELS];
 	int enInited;
 	EM emulnet;
+	std::shared_ptr<EnvelopePool> pool;
+	DeliveryMode deliveryMode;
+	// Bytes (envelope plus body) held in flight, in total and per sender id.
+	size_t inFlightBytes;
+	std::vector<size_t> senderInFlightBytes;
+	unsigned long drops[NUM_DROP_REASONS];
+
+	// Delay of every link without an override, and the overrides keyed by
+	// linkKey(from id, to id).
+	LinkDelay defaultDelay;
+	std::unordered_map<long long, LinkDelay> linkDelays;
+	// Timing wheel holding the messages that are not due yet. Slot
+	// (due & (wheel.size() - 1)) holds the messages due at tick `due`; the
+	// wheel is always larger than the longest delay, so a slot only ever
+	// holds a single tick. wheelTime is the last tick moved to the mailboxes.
+	std::vector<std::vector<en_msg *>> wheel;
+	int wheelTime;
+	// Per sender id, the tick its egress link is filling and the payload
+	// bytes already sent in that tick.
+	struct EgressState {
+		int tick;
+		size_t used;
+	};
+	std::vector<EgressState> egress;
+	// Trace every delivered message is recorded to, if any.
+	std::shared_ptr<TraceWriter> capture;
+	// With Params::COALESCE, the frames sent in the current tick that are
+	// not in the network yet: per sender id, one batch per receiver, built in
+	// the envelope it travels in. `room` is the bytes the envelope has for
+	// its body. Batch slots are reused from tick to tick; only the first
+	// `open` of a sender are in use. `senders` lists the sender ids with
+	// open batches.
+	struct CoalesceBatch {
+		en_msg *em;
+		int departure;
+		size_t room;
+	};
+	struct Outbox {
+		size_t open = 0;
+		std::vector<CoalesceBatch> batches;
+	};
+	std::vector<Outbox> outboxes;
+	std::vector<int> senders;
+	std::vector<q_elt> unpacked;
+	// Random stream of every sender id, for drops and link delays.
+	std::vector<Random> rngs;
+	// What the worker threads of a parallel tick asked of the network, per
+	// lane (see WorkerPool), in the order they asked it. mergeLanes replays
+	// the lanes in order on the main thread.
+	enum LaneOpKind
+	{
+		LANE_DELIVERED,   // emsg was handed to its receiver
+		LANE_SEND,        // ENsend of `size` bytes at `offset`
+		LANE_SEND_MANY,   // ENsendMany of the same
+		LANE_RELEASE      // ENrelease of `data`
+	};
+	struct LaneOp {
+		LaneOpKind kind;
+		en_msg *emsg;
+		char *data;
+		Address from;
+		NetChannel channel;
+		size_t offset;
+		int size;
+		size_t firstTo;
+		size_t numTo;
+	};
+	struct Lane {
+		std::vector<LaneOp> ops;
+		std::vector<char> bodies;      // bodies of the recorded sends
+		std::vector<Address> toaddrs;  // destinations of the recorded sends
+		size_t taken = 0;              // messages taken out of the mailboxes
+	};
+	std::vector<Lane> lanes;
+	// Ids of the nodes whose mailboxes were empty when a message was put in
+	// them, since the last ENtakeArrivals. A node in it may have received
+	// in between, or be listed once per channel.
+	std::vector<int> arrivals;
+
+	static char *bodyOf(const en_msg *em);
+	static size_t frameBytesOf(int size);
+	DropReason undeliverable(int dst, int size) const;
+	bool admit(int src, int dst, int time, int size, size_t held,
+	           int& departure);
+	en_msg *newEnvelope(const Address& myaddr, const Address& toaddr,
+	                    int size, en_payload *shared, NetChannel channel,
+	                    size_t room = 0);
+	en_payload *newShared(int src, const char *data, int size, size_t numTo);
+	void schedule(en_msg *em, int departure);
+	void releaseEnvelope(en_msg *em);
+	void releaseShared(en_payload *payload);
+	std::vector<en_msg *> *takeMailbox(const Address& myaddr, NetChannel channel);
+	char *deliver(en_msg *emsg);
+	void settle(en_msg *emsg);
+	void account(const en_msg *emsg);
+	Lane *currentLane();
+	void recordSend(Lane *lane, LaneOpKind kind, const Address& myaddr,
+	                const Address *toaddrs, size_t numTo,
+	                const char *data, int size, NetChannel channel);
+	void coalesce(const Address& myaddr, const Address& toaddr,
+	              const char *data, int size, NetChannel channel, int departure);
+	void growBatch(CoalesceBatch *batch, size_t needed);
+	void flushCoalesced();
+	void unpack(en_msg *emsg, std::vector<q_elt>& out);
+	void drop(DropReason reason);
+	void trackInFlight(const en_msg *em, bool added);
+	void trackInFlight(int src, size_t bytes, bool added);
+	static long long linkKey(int from, int to);
+	Random& rngOf(int id);
+	int sampleDelay(int from, int to);
+	int reserveEgress(int from, int time, int size);
+	void growWheel(int delay);
+	void putInMailbox(en_msg *em);
+	void releaseDue();
+	void captureDelivery(int from, int to, NetChannel channel,
+	                     const char *body, int size);
+	void saveEnvelope(CheckpointWriter& w, const en_msg *em) const;
+	en_msg *loadEnvelope(CheckpointReader& r);
 public:
  	EmulNet(std::shared_ptr<Params> p);
  	EmulNet(EmulNet &anotherEmulNet);
  	EmulNet& operator = (EmulNet &anotherEmulNet);
  	virtual ~EmulNet();
-	Address ENinit();
-	int ENsend(const Address& myaddr, const Address& toaddr, std::string data);
-	int ENsend(const Address& myaddr,
-		         const Address& toaddr,
-						 char* data,
-						 int size);
-	int ENrecv(const Address& myaddr,
-		         int (* enq)(void *, char *, int),
-						 struct timeval *t,
-						 int times,
-						 void *queue);
-	int ENcleanup();
+	virtual Address ENinit();
+	int ENsend(const Address& myaddr, const Address& toaddr, std::string data,
+	           NetChannel channel);
+	virtual int ENsend(const Address& myaddr,
+		                 const Address& toaddr,
+						         const char* data,
+						         int size,
+						         NetChannel channel);
+	int ENsendMany(const Address& myaddr,
+	               const std::vector<Address>& toaddrs,
+	               const std::string& data,
+	               NetChannel channel);
+	virtual int ENsendMany(const Address& myaddr,
+	                       const std::vector<Address>& toaddrs,
+	                       const char* data,
+	                       int size,
+	                       NetChannel channel);
+	virtual int ENrecv(const Address& myaddr,
+		                 int (* enq)(void *, char *, int),
+						         struct timeval *t,
+						         int times,
+						         void *queue,
+						         NetChannel channel);
+	virtual int ENrecvBatch(const Address& myaddr, std::vector<q_elt>& batch,
+	                        NetChannel channel);
+	virtual int ENrecvAll(const Address& myaddr,
+	                      std::vector<q_elt> *batches[NUM_CHANNELS]);
+	void setLinkDelay(const Address& from, const Address& to, LinkDelay delay);
+	void setCapture(std::shared_ptr<TraceWriter> writer);
+	bool ENbackpressure(const Address& myaddr);
+	virtual void ENrelease(char *data);
+	void ENdeliverDue();
+	void ENtakeArrivals(std::vector<int>& ids);
+	int ENnextDelivery() const;
+	virtual void ENtick();
+	void setLanes(int numLanes);
+	void mergeLanes();
+	virtual int ENcleanup();
+	void save(CheckpointWriter& w) const;
+	void load(CheckpointReader& r);
+	const PoolStats& getPoolStats() const { return pool->getStats(); }
+	void setDeliveryMode(DeliveryMode mode) { deliveryMode = mode; }
+	DeliveryMode getDeliveryMode() const { return deliveryMode; }
+	size_t getInFlightBytes() const { return inFlightBytes; }
+	unsigned long getDropCount(DropReason reason) const { return drops[reason]; }
+	const MsgCounters& getMsgCounts(NetChannel channel) const { return msgCounts[channel]; }
 };
 
 #endif /* _EMULNET_H_ */
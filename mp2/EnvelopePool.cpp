@@ -0,0 +1,165 @@
+/**********************************
+ * FILE NAME: EnvelopePool.cpp
+ *
+ * DESCRIPTION: Definition of the EnvelopePool class
+ **********************************/
+
+#include "EnvelopePool.h"
+
+// Size classes are 64, 128, ..., 8192 bytes including the block header.
+const size_t EnvelopePool::minBlockSize = 64;
+const size_t EnvelopePool::maxBlockSize = 8192;
+const int EnvelopePool::numSizeClasses = 8;
+
+/**
+ * Constructor
+ */
+EnvelopePool::EnvelopePool() : freeLists(numSizeClasses, nullptr) {}
+
+/**
+ * Destructor
+ *
+ * Frees every block the pool knows about. Buffers that are still handed out
+ * are owned by the caller.
+ */
+EnvelopePool::~EnvelopePool()
+{
+	endTick();
+	for (BlockHeader *head : freeLists)
+	{
+		while (head != nullptr)
+		{
+			BlockHeader *next = head->next;
+			free(head);
+			head = next;
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: sizeClassFor
+ *
+ * DESCRIPTION: Returns the size class of a buffer of `size` bytes, or -1 if
+ *              it is too large to be pooled.
+ */
+int EnvelopePool::sizeClassFor(size_t size)
+{
+	size_t blockSize = minBlockSize;
+	for (int sizeClass = 0; sizeClass < numSizeClasses; sizeClass++)
+	{
+		if (size + sizeof(BlockHeader) <= blockSize)
+		{
+			return sizeClass;
+		}
+		blockSize <<= 1;
+	}
+	return -1;
+}
+
+/**
+ * FUNCTION NAME: headerOf
+ *
+ * DESCRIPTION: Returns the header of a buffer handed out by the pool.
+ */
+EnvelopePool::BlockHeader *EnvelopePool::headerOf(void *buffer)
+{
+	return (BlockHeader *)buffer - 1;
+}
+
+/**
+ * FUNCTION NAME: capacityFor
+ *
+ * DESCRIPTION: Returns the bytes usable in the buffer handed out for a
+ *              request of `size` bytes, which is rounded up to its size class.
+ */
+size_t EnvelopePool::capacityFor(size_t size)
+{
+	int sizeClass = sizeClassFor(size);
+	if (sizeClass < 0)
+	{
+		return size;
+	}
+	return (minBlockSize << sizeClass) - sizeof(BlockHeader);
+}
+
+/**
+ * FUNCTION NAME: allocate
+ *
+ * DESCRIPTION: Returns a buffer of at least `size` bytes, reusing a released
+ *              buffer of the same size class when one is available.
+ */
+void *EnvelopePool::allocate(size_t size)
+{
+	int sizeClass = sizeClassFor(size);
+	BlockHeader *block = nullptr;
+
+	stats.allocations++;
+	stats.allocationsThisTick++;
+
+	if (sizeClass >= 0 && freeLists[sizeClass] != nullptr)
+	{
+		block = freeLists[sizeClass];
+		freeLists[sizeClass] = block->next;
+	}
+	else
+	{
+		size_t blockSize = (sizeClass >= 0) ?
+			(minBlockSize << sizeClass) : size + sizeof(BlockHeader);
+		block = (BlockHeader *)malloc(blockSize);
+		stats.mallocs++;
+		stats.mallocsThisTick++;
+	}
+
+	block->next = nullptr;
+	block->sizeClass = sizeClass;
+	return block + 1;
+}
+
+/**
+ * FUNCTION NAME: release
+ *
+ * DESCRIPTION: Returns `buffer` to the pool straight away.
+ */
+void EnvelopePool::release(void *buffer)
+{
+	BlockHeader *block = headerOf(buffer);
+	stats.releases++;
+
+	if (block->sizeClass < 0)
+	{
+		free(block);
+		return;
+	}
+	block->next = freeLists[block->sizeClass];
+	freeLists[block->sizeClass] = block;
+}
+
+/**
+ * FUNCTION NAME: releaseAtEndOfTick
+ *
+ * DESCRIPTION: Returns `buffer` to the pool on the next call to endTick().
+ */
+void EnvelopePool::releaseAtEndOfTick(void *buffer)
+{
+	releasedThisTick.emplace_back(headerOf(buffer));
+}
+
+/**
+ * FUNCTION NAME: endTick
+ *
+ * DESCRIPTION: Recycles the buffers released during the tick and rolls the
+ *              per tick counters over.
+ */
+void EnvelopePool::endTick()
+{
+	for (BlockHeader *block : releasedThisTick)
+	{
+		release(block + 1);
+	}
+	releasedThisTick.clear();
+
+	stats.allocationsLastTick = stats.allocationsThisTick;
+	stats.mallocsLastTick = stats.mallocsThisTick;
+	stats.allocationsThisTick = 0;
+	stats.mallocsThisTick = 0;
+}
@@ -0,0 +1,84 @@
+/**********************************
+ * FILE NAME: EnvelopePool.h
+ *
+ * DESCRIPTION: Pooled allocator for the buffers used by the
+ *              emulated network.
+ **********************************/
+
+#ifndef ENVELOPE_POOL_H_
+#define ENVELOPE_POOL_H_
+
+#include "stdincludes.h"
+
+/**
+ * STRUCT NAME: PoolStats
+ *
+ * DESCRIPTION: Allocation counters of an EnvelopePool.
+ */
+struct PoolStats {
+	// Buffers handed out by the pool.
+	unsigned long allocations;
+	// Buffers that needed a call to malloc.
+	unsigned long mallocs;
+	// Buffers returned to the pool.
+	unsigned long releases;
+	// Counters for the tick in progress and for the last completed tick.
+	unsigned long allocationsThisTick;
+	unsigned long mallocsThisTick;
+	unsigned long allocationsLastTick;
+	unsigned long mallocsLastTick;
+
+	PoolStats()
+		: allocations(0), mallocs(0), releases(0),
+		  allocationsThisTick(0), mallocsThisTick(0),
+		  allocationsLastTick(0), mallocsLastTick(0) {}
+};
+
+/**
+ * CLASS NAME: EnvelopePool
+ *
+ * DESCRIPTION: Hands out buffers from per size class free lists.
+ *
+ * Sizes are rounded up to a power of two between minBlockSize and
+ * maxBlockSize. Released buffers go back to the free list of their class, so
+ * once the pool is warm a send or receive does not call malloc. Requests
+ * larger than maxBlockSize are served by malloc directly.
+ *
+ * Buffers released with releaseAtEndOfTick() stay valid until endTick() is
+ * called, which lets the network hand a buffer to a node for the rest of
+ * the tick without the node having to free it.
+ */
+class EnvelopePool {
+private:
+	struct BlockHeader {
+		BlockHeader *next; // free list link
+		int sizeClass;     // index into freeLists, -1 if not pooled
+	};
+
+	static const size_t minBlockSize;
+	static const size_t maxBlockSize;
+	static const int numSizeClasses;
+
+	std::vector<BlockHeader *> freeLists;
+	std::vector<BlockHeader *> releasedThisTick;
+	PoolStats stats;
+
+	static int sizeClassFor(size_t size);
+	static BlockHeader *headerOf(void *buffer);
+
+public:
+	EnvelopePool();
+	EnvelopePool(const EnvelopePool &anotherPool) = delete;
+	EnvelopePool& operator =(const EnvelopePool &anotherPool) = delete;
+	~EnvelopePool();
+
+	static size_t capacityFor(size_t size);
+	void *allocate(size_t size);
+	void release(void *buffer);
+	void releaseAtEndOfTick(void *buffer);
+	void endTick();
+
+	const PoolStats& getStats() const { return stats; }
+};
+
+#endif  // ENVELOPE_POOL_H_
@@ -0,0 +1,100 @@
+/**********************************
+ * FILE NAME: EventQueue.cpp
+ *
+ * DESCRIPTION: Definition of the queue of timed node wake-ups
+ **********************************/
+
+#include "EventQueue.h"
+
+/**
+ * Constructor
+ */
+EventQueue::EventQueue(int numNodes)
+	: scheduled(numNodes, INT_MAX)
+{
+}
+
+/**
+ * FUNCTION NAME: schedule
+ *
+ * DESCRIPTION: Wakes node `node` at tick `time`, unless it is already woken
+ *              at that tick or earlier
+ */
+void EventQueue::schedule(int time, int node)
+{
+	if (time >= scheduled[node])
+	{
+		return;
+	}
+	scheduled[node] = time;
+	heap.emplace(time, node);
+}
+
+/**
+ * FUNCTION NAME: popDue
+ *
+ * DESCRIPTION: Removes the wake-ups due by tick `time` and appends their
+ *              nodes to `nodes`. A node may be appended more than once.
+ */
+void EventQueue::popDue(int time, std::vector<int>& nodes)
+{
+	while (!heap.empty() && heap.top().first <= time)
+	{
+		int node = heap.top().second;
+		// A replaced wake-up is still in the heap; it wakes the node too
+		// early at worst, which a node must cope with anyway.
+		if (scheduled[node] == heap.top().first)
+		{
+			scheduled[node] = INT_MAX;
+		}
+		nodes.push_back(node);
+		heap.pop();
+	}
+}
+
+/**
+ * FUNCTION NAME: nextTime
+ *
+ * DESCRIPTION: Tick of the earliest wake-up, INT_MAX if there is none
+ */
+int EventQueue::nextTime() const
+{
+	return heap.empty() ? INT_MAX : heap.top().first;
+}
+
+/**
+ * FUNCTION NAME: save
+ *
+ * DESCRIPTION: Writes the wake-ups, replaced ones included, to checkpoint
+ *              `w`
+ */
+void EventQueue::save(CheckpointWriter& w) const
+{
+	w.section("EVTQ");
+	w.writeVector(scheduled);
+	std::priority_queue<WakeUp, std::vector<WakeUp>, std::greater<WakeUp>>
+		wakeUps = heap;
+	w.write(wakeUps.size());
+	for (; !wakeUps.empty(); wakeUps.pop())
+	{
+		w.write(wakeUps.top().first);
+		w.write(wakeUps.top().second);
+	}
+}
+
+/**
+ * FUNCTION NAME: load
+ *
+ * DESCRIPTION: Replaces the wake-ups with those of checkpoint `r`
+ */
+void EventQueue::load(CheckpointReader& r)
+{
+	r.section("EVTQ");
+	r.readVector(scheduled);
+	heap = decltype(heap)();
+	for (size_t count = r.read<size_t>(); count > 0; count--)
+	{
+		int time = r.read<int>();
+		heap.emplace(time, r.read<int>());
+	}
+}
@@ -0,0 +1,42 @@
+/**********************************
+ * FILE NAME: EventQueue.h
+ *
+ * DESCRIPTION: Header file of the queue of timed node wake-ups
+ **********************************/
+
+#ifndef EVENT_QUEUE_H_
+#define EVENT_QUEUE_H_
+
+#include "stdincludes.h"
+#include "Checkpoint.h"
+#include <functional>
+
+/**
+ * CLASS NAME: EventQueue
+ *
+ * DESCRIPTION: The ticks at which nodes have timed work to do, such as a
+ *              gossip round, a member to clean up or a transaction to time
+ *              out, kept in a priority queue ordered by tick.
+ *
+ * Only the earliest wake-up scheduled for a node is kept: an earlier one
+ * replaces it, a later one is ignored. The node works out its next timer
+ * again every time it is visited, so the later one is scheduled then.
+ */
+class EventQueue
+{
+private:
+	typedef std::pair<int, int> WakeUp; // (tick, node)
+	std::priority_queue<WakeUp, std::vector<WakeUp>, std::greater<WakeUp>> heap;
+	// Tick of the wake-up in `heap` that counts for each node, INT_MAX if none.
+	std::vector<int> scheduled;
+public:
+	EventQueue(int numNodes);
+
+	void schedule(int time, int node);
+	void popDue(int time, std::vector<int>& nodes);
+	int nextTime() const;
+	void save(CheckpointWriter& w) const;
+	void load(CheckpointReader& r);
+};
+
+#endif  // EVENT_QUEUE_H_
@@ -150,3 +150,33 @@ unsigned long HashTable::count(const std::string& key)
 {
 	return (unsigned long)(hashTable.count(key));
 }
+
+/**
+ * FUNCTION NAME: save
+ *
+ * DESCRIPTION: Writes every (key,value) pair to checkpoint `w`
+ */
+void HashTable::save(CheckpointWriter& w) const
+{
+	w.write(hashTable.size());
+	for (const auto& entry : hashTable)
+	{
+		w.writeString(entry.first);
+		w.writeString(entry.second);
+	}
+}
+
+/**
+ * FUNCTION NAME: load
+ *
+ * DESCRIPTION: Replaces the contents with the pairs of checkpoint `r`
+ */
+void HashTable::load(CheckpointReader& r)
+{
+	hashTable.clear();
+	for (size_t count = r.read<size_t>(); count > 0; count--)
+	{
+		std::string key = r.readString();
+		hashTable.emplace_hint(hashTable.end(), key, r.readString());
+	}
+}
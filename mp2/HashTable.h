@@ -12,6 +12,7 @@
  */
 #include "stdincludes.h"
 #include "Entry.h"
+#include "Checkpoint.h"
 
 /**
  * CLASS NAME: HashTable
@@ -32,6 +33,8 @@ public:
 	unsigned long currentSize();
 	void clear();
 	unsigned long count(const std::string& key);
+	void save(CheckpointWriter& w) const;
+	void load(CheckpointReader& r);
 	virtual ~HashTable();
 };
 
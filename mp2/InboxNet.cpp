@@ -0,0 +1,293 @@
+/**********************************
+ * FILE NAME: InboxNet.cpp
+ *
+ * DESCRIPTION: Definition of the InboxNet class
+ **********************************/
+
+#include "InboxNet.h"
+
+/**
+ * Constructor
+ */
+InboxNet::InboxNet(std::shared_ptr<Params> p, int firstId)
+	: EmulNet(std::move(p))
+{
+	emulnet.setNextId(firstId);
+}
+
+/**
+ * Destructor
+ */
+InboxNet::~InboxNet()
+{
+	for (auto& inbox : inboxes)
+	{
+		for (const q_elt& msg : inbox)
+		{
+			pool->release(msg.elt);
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: ENinit
+ *
+ * DESCRIPTION: Gives the next node hosted by this process its address
+ */
+Address InboxNet::ENinit()
+{
+	Address myaddr = EmulNet::ENinit();
+	int id = *(int *)(myaddr.addr);
+	if (id >= (int)hosted.size())
+	{
+		hosted.resize(id + 1, false);
+		inboxes.resize((id + 1) * NUM_CHANNELS);
+	}
+	hosted[id] = true;
+	return myaddr;
+}
+
+/**
+ * FUNCTION NAME: admitTo
+ *
+ * DESCRIPTION: Returns whether a message of `size` bytes may be sent to node
+ *              id `dst`, counting it as dropped if not. An id that is not
+ *              one of the nodes would name another process's port or ring.
+ */
+bool InboxNet::admitTo(int dst, int size)
+{
+	DropReason reason = undeliverable(dst, size);
+	if (reason != NUM_DROP_REASONS)
+	{
+		drop(reason);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * FUNCTION NAME: ENsendMany
+ *
+ * DESCRIPTION: Sends the same message to every address in `toaddrs`
+ *
+ * RETURNS:
+ * number of destinations the message was sent to
+ */
+int InboxNet::ENsendMany(const Address& myaddr,
+                         const std::vector<Address>& toaddrs,
+                         const char *data,
+                         int size,
+                         NetChannel channel)
+{
+	int sent = 0;
+	for (const Address& toaddr : toaddrs)
+	{
+		if (ENsend(myaddr, toaddr, data, size, channel) > 0)
+		{
+			sent++;
+		}
+	}
+	return sent;
+}
+
+/**
+ * FUNCTION NAME: ENrecv
+ *
+ * DESCRIPTION: Hands every message received by `myaddr` on `channel` to the
+ *              callback `enq`, together with `queue`
+ *
+ * RETURN:
+ * 0
+ */
+int InboxNet::ENrecv(const Address& myaddr,
+                     int (* enq)(void *, char *, int),
+                     struct timeval *t,
+                     int times,
+                     void *queue,
+                     NetChannel channel)
+{
+	std::vector<q_elt> *inbox = takeInbox(myaddr, channel);
+	if (inbox == nullptr)
+	{
+		return 0;
+	}
+
+	int dst = *(int *)(myaddr.addr);
+	for (const q_elt& msg : *inbox)
+	{
+		(*enq)(queue, deliver(msg, dst, channel), msg.size);
+	}
+	inbox->clear();
+
+	return 0;
+}
+
+/**
+ * FUNCTION NAME: ENrecvBatch
+ *
+ * DESCRIPTION: Appends every message received by `myaddr` on `channel` to
+ *              `batch`
+ *
+ * RETURN:
+ * number of messages received
+ */
+int InboxNet::ENrecvBatch(const Address& myaddr, std::vector<q_elt>& batch,
+                          NetChannel channel)
+{
+	int dst = *(int *)(myaddr.addr);
+	if (!isHosted(dst))
+	{
+		return 0;
+	}
+	collect(dst);
+	return deliverInbox(dst, channel, batch);
+}
+
+/**
+ * FUNCTION NAME: ENrecvAll
+ *
+ * DESCRIPTION: Collects once for `myaddr` and appends what it received on
+ *              channel c to batches[c]. A null batch leaves the messages of
+ *              its channel waiting.
+ *
+ * RETURN:
+ * number of messages received
+ */
+int InboxNet::ENrecvAll(const Address& myaddr,
+                        std::vector<q_elt> *batches[NUM_CHANNELS])
+{
+	int dst = *(int *)(myaddr.addr);
+	if (!isHosted(dst))
+	{
+		return 0;
+	}
+	collect(dst);
+
+	int received = 0;
+	for (int c = 0; c < NUM_CHANNELS; c++)
+	{
+		if (batches[c] != nullptr)
+		{
+			received += deliverInbox(dst, (NetChannel)c, *batches[c]);
+		}
+	}
+	return received;
+}
+
+/**
+ * FUNCTION NAME: ENrelease
+ *
+ * DESCRIPTION: Called by a node once it is done with a message body `data`.
+ *              In HANDOFF mode this returns the body to the pool.
+ */
+void InboxNet::ENrelease(char *data)
+{
+	if (deliveryMode == HANDOFF)
+	{
+		pool->release(data);
+	}
+}
+
+/**
+ * FUNCTION NAME: ENcleanup
+ *
+ * DESCRIPTION: Drops the undelivered messages and writes the message counts
+ */
+int InboxNet::ENcleanup()
+{
+	for (auto& inbox : inboxes)
+	{
+		for (const q_elt& msg : inbox)
+		{
+			pool->release(msg.elt);
+		}
+		inbox.clear();
+	}
+	return EmulNet::ENcleanup();
+}
+
+/**
+ * FUNCTION NAME: isHosted
+ *
+ * DESCRIPTION: Returns true if node id `id` is hosted by this process
+ */
+bool InboxNet::isHosted(int id) const
+{
+	return id >= 0 && id < (int)hosted.size() && hosted[id];
+}
+
+/**
+ * FUNCTION NAME: receive
+ *
+ * DESCRIPTION: Called by collect() for every message received for node id
+ *              `id` from node id `from` on `channel`. Copies the body into a
+ *              pool buffer in the inbox.
+ */
+void InboxNet::receive(int id, int from, NetChannel channel,
+                       const char *data, int size)
+{
+	if (channel < 0 || channel >= NUM_CHANNELS)
+	{
+		return;
+	}
+	captureDelivery(from, id, channel, data, size);
+	char *body = (char *)pool->allocate(size);
+	memcpy(body, data, size);
+	inboxes[id * NUM_CHANNELS + channel].emplace_back(body, size);
+}
+
+/**
+ * FUNCTION NAME: takeInbox
+ *
+ * DESCRIPTION: Collects the messages of `myaddr` and returns its inbox on
+ *              `channel`, or null if the node is not hosted by this process.
+ */
+std::vector<q_elt> *InboxNet::takeInbox(const Address& myaddr,
+                                        NetChannel channel)
+{
+	int dst = *(int *)(myaddr.addr);
+	if (!isHosted(dst))
+	{
+		return nullptr;
+	}
+	collect(dst);
+	return &inboxes[dst * NUM_CHANNELS + channel];
+}
+
+/**
+ * FUNCTION NAME: deliverInbox
+ *
+ * DESCRIPTION: Appends the inbox of node id `dst` on `channel` to `batch`
+ *
+ * RETURN:
+ * number of messages delivered
+ */
+int InboxNet::deliverInbox(int dst, NetChannel channel, std::vector<q_elt>& batch)
+{
+	std::vector<q_elt>& inbox = inboxes[dst * NUM_CHANNELS + channel];
+	int received = (int)inbox.size();
+	batch.reserve(batch.size() + received);
+	for (const q_elt& msg : inbox)
+	{
+		batch.emplace_back(deliver(msg, dst, channel), msg.size);
+	}
+	inbox.clear();
+
+	return received;
+}
+
+/**
+ * FUNCTION NAME: deliver
+ *
+ * DESCRIPTION: Counts the received message `msg` and returns its body. In
+ *              COPY_ON_RECV mode the body is recycled at the end of the tick.
+ */
+char *InboxNet::deliver(const q_elt& msg, int dst, NetChannel channel)
+{
+	msgCounts[channel].countRecv(dst, par->getcurrtime(), msg.size);
+	if (deliveryMode != HANDOFF)
+	{
+		pool->releaseAtEndOfTick(msg.elt);
+	}
+	return (char *)msg.elt;
+}
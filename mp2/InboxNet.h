@@ -0,0 +1,72 @@
+/**********************************
+ * FILE NAME: InboxNet.h
+ *
+ * DESCRIPTION: Base class of the transports that carry messages
+ *              outside the emulated network
+ **********************************/
+
+#ifndef INBOX_NET_H_
+#define INBOX_NET_H_
+
+#include "stdincludes.h"
+#include "EmulNet.h"
+
+/**
+ * CLASS NAME: InboxNet
+ *
+ * DESCRIPTION: Delivery side shared by UdpNet and ShmNet.
+ *
+ * A process only hosts some of the nodes: the ones it called ENinit for.
+ * Before a hosted node receives, collect() moves whatever the transport got
+ * for it into the node's inbox, as pool buffers. ENrecv and ENrecvBatch then
+ * deliver the inbox with the same HANDOFF / COPY_ON_RECV rules as EmulNet.
+ * Link delays, bandwidth caps and random drops of the emulated network do
+ * not apply.
+ */
+class InboxNet : public EmulNet
+{
+protected:
+	// Messages received but not yet delivered, per node id and channel at
+	// index id * NUM_CHANNELS + channel. The bodies are pool buffers.
+	std::vector<std::vector<q_elt>> inboxes;
+	std::vector<bool> hosted;
+
+	bool isHosted(int id) const;
+	bool admitTo(int dst, int size);
+	void receive(int id, int from, NetChannel channel, const char *data, int size);
+	// Moves the messages received for node id `id` to its inbox.
+	virtual void collect(int id) = 0;
+
+private:
+	std::vector<q_elt> *takeInbox(const Address& myaddr, NetChannel channel);
+	int deliverInbox(int dst, NetChannel channel, std::vector<q_elt>& batch);
+	char *deliver(const q_elt& msg, int dst, NetChannel channel);
+
+public:
+	InboxNet(std::shared_ptr<Params> p, int firstId);
+	InboxNet(const InboxNet &anotherInboxNet) = delete;
+	InboxNet& operator =(const InboxNet &anotherInboxNet) = delete;
+	virtual ~InboxNet();
+
+	using EmulNet::ENsendMany;
+	Address ENinit() override;
+	int ENsendMany(const Address& myaddr,
+	               const std::vector<Address>& toaddrs,
+	               const char* data,
+	               int size,
+	               NetChannel channel) override;
+	int ENrecv(const Address& myaddr,
+	           int (* enq)(void *, char *, int),
+	           struct timeval *t,
+	           int times,
+	           void *queue,
+	           NetChannel channel) override;
+	int ENrecvBatch(const Address& myaddr, std::vector<q_elt>& batch,
+	                NetChannel channel) override;
+	int ENrecvAll(const Address& myaddr,
+	              std::vector<q_elt> *batches[NUM_CHANNELS]) override;
+	void ENrelease(char *data) override;
+	int ENcleanup() override;
+};
+
+#endif  // INBOX_NET_H_
@@ -0,0 +1,184 @@
+/**********************************
+ * FILE NAME: LatencyHistogram.cpp
+ *
+ * DESCRIPTION: Definition of the latency statistics of client calls
+ **********************************/
+
+#include "LatencyHistogram.h"
+
+/**
+ * Constructor
+ */
+LatencyHistogram::LatencyHistogram() : total(0) {}
+
+/**
+ * FUNCTION NAME: record
+ *
+ * DESCRIPTION: Counts a latency of `ticks` ticks
+ */
+void LatencyHistogram::record(int ticks)
+{
+	ticks = std::max(ticks, 0);
+	if ((size_t)ticks >= counts.size())
+	{
+		counts.resize(ticks + 1, 0);
+	}
+	counts[ticks]++;
+	total++;
+}
+
+/**
+ * FUNCTION NAME: merge
+ *
+ * DESCRIPTION: Adds the counts of `other` to these
+ */
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+	if (other.counts.size() > counts.size())
+	{
+		counts.resize(other.counts.size(), 0);
+	}
+	for (size_t ticks = 0; ticks < other.counts.size(); ticks++)
+	{
+		counts[ticks] += other.counts[ticks];
+	}
+	total += other.total;
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Forgets every latency
+ */
+void LatencyHistogram::clear()
+{
+	counts.clear();
+	total = 0;
+}
+
+/**
+ * FUNCTION NAME: percentile
+ *
+ * DESCRIPTION: Returns the smallest latency at least `fraction` of the
+ *              latencies are at or below, -1 if there are none
+ */
+int LatencyHistogram::percentile(double fraction) const
+{
+	if (total == 0)
+	{
+		return -1;
+	}
+	long rank = std::max((long)ceil(fraction * total), 1L);
+	long seen = 0;
+	for (size_t ticks = 0; ticks < counts.size(); ticks++)
+	{
+		seen += counts[ticks];
+		if (seen >= rank)
+		{
+			return (int)ticks;
+		}
+	}
+	return (int)counts.size() - 1;
+}
+
+/**
+ * FUNCTION NAME: save
+ *
+ * DESCRIPTION: Writes the counts to checkpoint `w`
+ */
+void LatencyHistogram::save(CheckpointWriter& w) const
+{
+	w.writeVector(counts);
+	w.write(total);
+}
+
+/**
+ * FUNCTION NAME: load
+ *
+ * DESCRIPTION: Replaces the counts with those of checkpoint `r`
+ */
+void LatencyHistogram::load(CheckpointReader& r)
+{
+	r.readVector(counts);
+	r.read(total);
+}
+
+/**
+ * FUNCTION NAME: record
+ *
+ * DESCRIPTION: Records the outcome at tick `now` of a call of type `type`
+ *              made at tick `startTime`
+ */
+void CoordinatorStats::record(TransactionType type, int startTime, int now,
+                              bool success)
+{
+	if (success)
+	{
+		succeeded[type].record(now - startTime);
+	}
+	else
+	{
+		failed[type]++;
+	}
+	lastOutcome = std::max(lastOutcome, now);
+}
+
+/**
+ * FUNCTION NAME: merge
+ *
+ * DESCRIPTION: Adds the outcomes of `other` to these
+ */
+void CoordinatorStats::merge(const CoordinatorStats& other)
+{
+	for (int type = 0; type < numTypes; type++)
+	{
+		succeeded[type].merge(other.succeeded[type]);
+		failed[type] += other.failed[type];
+	}
+	lastOutcome = std::max(lastOutcome, other.lastOutcome);
+}
+
+/**
+ * FUNCTION NAME: clear
+ *
+ * DESCRIPTION: Forgets every outcome
+ */
+void CoordinatorStats::clear()
+{
+	for (int type = 0; type < numTypes; type++)
+	{
+		succeeded[type].clear();
+		failed[type] = 0;
+	}
+	lastOutcome = -1;
+}
+
+/**
+ * FUNCTION NAME: save
+ *
+ * DESCRIPTION: Writes the outcomes to checkpoint `w`
+ */
+void CoordinatorStats::save(CheckpointWriter& w) const
+{
+	for (int type = 0; type < numTypes; type++)
+	{
+		succeeded[type].save(w);
+		w.write(failed[type]);
+	}
+	w.write(lastOutcome);
+}
+
+/**
+ * FUNCTION NAME: load
+ *
+ * DESCRIPTION: Replaces the outcomes with those of checkpoint `r`
+ */
+void CoordinatorStats::load(CheckpointReader& r)
+{
+	for (int type = 0; type < numTypes; type++)
+	{
+		succeeded[type].load(r);
+		r.read(failed[type]);
+	}
+	r.read(lastOutcome);
+}
@@ -0,0 +1,65 @@
+/**********************************
+ * FILE NAME: LatencyHistogram.h
+ *
+ * DESCRIPTION: Header file of the latency statistics of client calls
+ **********************************/
+
+#ifndef LATENCY_HISTOGRAM_H_
+#define LATENCY_HISTOGRAM_H_
+
+#include "stdincludes.h"
+#include "TransactionState.h"
+
+/**
+ * CLASS NAME: LatencyHistogram
+ *
+ * DESCRIPTION: Counts of latencies in whole ticks. Latencies are short (a
+ *              transaction times out after a few ticks), so a count per
+ *              tick is exact and small, and the percentiles need no
+ *              approximation.
+ */
+class LatencyHistogram
+{
+private:
+	// counts[t] is the number of latencies of t ticks.
+	std::vector<long> counts;
+	long total;
+public:
+	LatencyHistogram();
+
+	void record(int ticks);
+	void merge(const LatencyHistogram& other);
+	void clear();
+	long count() const { return total; }
+	int percentile(double fraction) const;
+	void save(CheckpointWriter& w) const;
+	void load(CheckpointReader& r);
+};
+
+/**
+ * STRUCT NAME: CoordinatorStats
+ *
+ * DESCRIPTION: Outcome of the client calls coordinated by one MP2Node, by
+ *              TransactionType: the latency from the call to the quorum of
+ *              successes for those that succeeded, a count for those that
+ *              failed or timed out.
+ */
+struct CoordinatorStats
+{
+	static constexpr int numTypes = T_DELETE + 1;
+
+	LatencyHistogram succeeded[numTypes];
+	long failed[numTypes];
+	// Tick of the last outcome, -1 if none
+	int lastOutcome;
+
+	CoordinatorStats() { clear(); }
+
+	void record(TransactionType type, int startTime, int now, bool success);
+	void merge(const CoordinatorStats& other);
+	void clear();
+	void save(CheckpointWriter& w) const;
+	void load(CheckpointReader& r);
+};
+
+#endif  // LATENCY_HISTOGRAM_H_
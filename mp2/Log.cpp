@@ -1,5 +1,5 @@
 /**********************************
- * FILE NAME: Log.h
+ * FILE NAME: Log.cpp
  *
  * DESCRIPTION: Log class definition
  **********************************/
@@ -9,38 +9,28 @@
 /**
  * Constructor
  */
-Log::Log(std::shared_ptr<Params> p, bool debug) : debugMode(debug)
+Log::Log(std::shared_ptr<Params> p, bool debug)
+	: debugMode(debug), dbgFile(NULL), statsFile(NULL), numWrites(0)
 {
 	par = std::move(p);
 	firstTime = false;
 }
 
 /**
- * Copy constructor
- */
-Log::Log(const Log &anotherLog)
-{
-	this->par = anotherLog.par;
-	this->firstTime = anotherLog.firstTime;
-	this->debugMode = anotherLog.debugMode;
-}
-
-/**
- * Assignment Operator Overloading
+ * Destructor
  */
-Log& Log::operator = (const Log& anotherLog)
+Log::~Log()
 {
-	this->par = anotherLog.par;
-	this->firstTime = anotherLog.firstTime;
-	this->debugMode = anotherLog.debugMode;
-	return *this;
+	if (dbgFile != NULL)
+	{
+		fclose(dbgFile);
+	}
+	if (statsFile != NULL)
+	{
+		fclose(statsFile);
+	}
 }
 
-/**
- * Destructor
- */
-Log::~Log() {}
-
 void Log::logDebug(Address *addr, const char *str)
 {
 	if (this->debugMode)
@@ -56,33 +46,9 @@ void Log::logDebug(Address *addr, const char *str)
  */
 void Log::unconditionalLog(Address *addr, const char * str, ...)
 {
-	static FILE *fp;
-	static FILE *fp2;
 	va_list vararglist;
-	static char buffer[30000];
-	static int numwrites;
-	static char stdstring[30];
-	static char stdstring2[40];
-	static char stdstring3[40];
-	static int dbg_opened=0;
-
-	if (dbg_opened != 639)
-	{
-		numwrites=0;
-
-		stdstring2[0]=0;
-
-		strcpy(stdstring3, stdstring2);
-
-		strcat(stdstring2, Config::debugLog.c_str());
-		strcat(stdstring3, Config::statsLog.c_str());
-
-		fp = fopen(stdstring2, "w");
-		fp2 = fopen(stdstring3, "w");
-
-		dbg_opened=639;
-	}
-	else
+	char buffer[30000];
+	char stdstring[30];
 
 	snprintf(stdstring, sizeof(stdstring), "%d.%d.%d.%d:%d ",
 	         addr->addr[0], addr->addr[1], addr->addr[2], addr->addr[3],
@@ -92,6 +58,34 @@ void Log::unconditionalLog(Address *addr, const char * str, ...)
 	vsnprintf(buffer, sizeof(buffer), str, vararglist);
 	va_end(vararglist);
 
+	std::string line = "\n ";
+	line += stdstring;
+	line += "[" + std::to_string(par->getcurrtime()) + "] ";
+	line += buffer;
+	bool stats = memcmp(buffer, "#STATSLOG#", 10) == 0;
+
+	int lane = WorkerPool::currentLane();
+	if (lane >= 0 && lane < (int)lanes.size())
+	{
+		lanes[lane].push_back(LogLine{stats, std::move(line)});
+		return;
+	}
+	write(stats, line);
+}
+
+/**
+ * FUNCTION NAME: write
+ *
+ * DESCRIPTION: Appends `line` to stats.log if `stats`, to dbg.log otherwise
+ */
+void Log::write(bool stats, const std::string& line)
+{
+	if (dbgFile == NULL || statsFile == NULL)
+	{
+		open(dbgFile, Config::debugLog);
+		open(statsFile, Config::statsLog);
+	}
+
 	if (!firstTime)
 	{
 		int magicNumber = 0;
@@ -101,29 +95,70 @@ void Log::unconditionalLog(Address *addr, const char * str, ...)
 		{
 			magicNumber += (int)magic.at(i);
 		}
-		fprintf(fp, "%x\n", magicNumber);
+		fprintf(dbgFile, "%x\n", magicNumber);
 		firstTime = true;
 	}
 
-	if (memcmp(buffer, "#STATSLOG#", 10)==0)
+	fputs(line.c_str(), stats ? statsFile : dbgFile);
+
+	if (++numWrites >= Config::maxWrites)
 	{
-		fprintf(fp2, "\n %s", stdstring);
-		fprintf(fp2, "[%d] ", par->getcurrtime());
+		fflush(dbgFile);
+		fflush(statsFile);
+		numWrites = 0;
+	}
+}
 
-		fprintf(fp2, "%s", buffer);
+/**
+ * FUNCTION NAME: open
+ *
+ * DESCRIPTION: Opens `file` as `name` in the output directory of the run,
+ *              unless it is open already
+ */
+void Log::open(FILE *&file, const std::string& name)
+{
+	if (file != NULL)
+	{
+		return;
 	}
-	else
+	std::string path = par->outputPath(name);
+	file = fopen(path.c_str(), "w");
+	if (file == NULL)
 	{
-		fprintf(fp, "\n %s", stdstring);
-		fprintf(fp, "[%d] ", par->getcurrtime());
-		fprintf(fp, "%s", buffer);
+		throw std::runtime_error("Log: cannot open " + path + ": " +
+		                         strerror(errno));
 	}
+}
+
+/**
+ * FUNCTION NAME: setLanes
+ *
+ * DESCRIPTION: Prepares `numLanes` lanes for the workers of parallel ticks.
+ *              What a worker on lane k (WorkerPool::setLane) logs is kept in
+ *              the lane until mergeLanes writes it out.
+ */
+void Log::setLanes(int numLanes)
+{
+	lanes.clear();
+	lanes.resize(numLanes);
+}
 
-	if (++numwrites >= Config::maxWrites)
+/**
+ * FUNCTION NAME: mergeLanes
+ *
+ * DESCRIPTION: Writes out the lines kept in the lanes, lane after lane, and
+ *              empties them. Called by the main thread once the workers are
+ *              done.
+ */
+void Log::mergeLanes()
+{
+	for (std::vector<LogLine>& lane : lanes)
 	{
-		fflush(fp);
-		fflush(fp2);
-		numwrites=0;
+		for (const LogLine& line : lane)
+		{
+			write(line.stats, line.text);
+		}
+		lane.clear();
 	}
 }
 
@@ -134,7 +169,7 @@ void Log::unconditionalLog(Address *addr, const char * str, ...)
  */
 void Log::logNodeAdd(Address *thisNode, Address *addedAddr)
 {
-	static char stdstring[100];
+	char stdstring[100];
 	snprintf(stdstring, sizeof(stdstring),
 	         "Node %d.%d.%d.%d:%d joined at time %d",
 					 addedAddr->addr[0], addedAddr->addr[1], addedAddr->addr[2],
@@ -150,7 +185,7 @@ void Log::logNodeAdd(Address *thisNode, Address *addedAddr)
  */
 void Log::logNodeRemove(Address *thisNode, Address *removedAddr)
 {
-	static char stdstring[100];
+	char stdstring[100];
 	snprintf(stdstring, sizeof(stdstring),
 	        "Node %d.%d.%d.%d:%d removed at time %d",
 					removedAddr->addr[0], removedAddr->addr[1], removedAddr->addr[2],
@@ -170,7 +205,7 @@ void Log::logCreateSuccess(Address * address,
 													 string key,
 													 string value)
 {
-	static char stdstring[100];
+	char stdstring[100];
 	string str;
 	if (isCoordinator)
 	{
@@ -198,7 +233,7 @@ void Log::logReadSuccess(Address * address,
 												 string key,
 												 string value)
 {
-  static char stdstring[100];
+  char stdstring[100];
 	string str;
 	if (isCoordinator)
 	{
@@ -226,7 +261,7 @@ void Log::logUpdateSuccess(Address * address,
 													 string key,
 													 string newValue)
 {
-  static char stdstring[100];
+  char stdstring[100];
 	string str;
 	if (isCoordinator)
 	{
@@ -253,7 +288,7 @@ void Log::logDeleteSuccess(Address * address,
 													 int transID,
 													 string key)
 {
-  static char stdstring[100];
+  char stdstring[100];
 	string str;
 	if (isCoordinator)
 	{
@@ -280,7 +315,7 @@ void Log::logCreateFail(Address * address,
 												string key,
 												string value)
 {
-	static char stdstring[100];
+	char stdstring[100];
 	string str;
 	if (isCoordinator)
 	{
@@ -308,7 +343,7 @@ void Log::logReadFail(Address * address,
 											int transID,
 											string key)
 {
-  static char stdstring[100];
+  char stdstring[100];
 	string str;
 	if (isCoordinator)
 	{
@@ -335,7 +370,7 @@ void Log::logUpdateFail(Address * address,
 												string key,
 												string newValue)
 {
-  static char stdstring[100];
+  char stdstring[100];
 	string str;
 	if (isCoordinator)
 	{
@@ -362,7 +397,7 @@ void Log::logDeleteFail(Address * address,
 												int transID,
 												string key)
 {
-  static char stdstring[100];
+  char stdstring[100];
 	string str;
 	if (isCoordinator)
 	{
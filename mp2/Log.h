@@ -12,6 +12,7 @@
 #include "Params.h"
 #include "Address.h"
 #include "Member.h"
+#include "WorkerPool.h"
 
 /**
  * CLASS NAME: Log
@@ -23,16 +24,31 @@ private:
 	std::shared_ptr<Params> par;
 	bool firstTime;
 	bool debugMode;
+	// dbg.log and stats.log of this run, opened by the first write
+	FILE *dbgFile;
+	FILE *statsFile;
+	int numWrites;
+	// Lines logged by the workers of a parallel tick, per lane.
+	struct LogLine {
+		bool stats;
+		std::string text;
+	};
+	std::vector<std::vector<LogLine>> lanes;
+
+	void open(FILE *&file, const std::string& name);
+	void write(bool stats, const std::string& line);
 
 public:
 	Log(std::shared_ptr<Params> p, bool debug);
-	Log(const Log &anotherLog);
-	Log& operator = (const Log &anotherLog);
+	Log(const Log &anotherLog) = delete;
+	Log& operator = (const Log &anotherLog) = delete;
 	virtual ~Log();
 
 	// Generic logging method.
 	void logDebug(Address *, const char * str);
 	void unconditionalLog(Address *, const char * str, ...);
+	void setLanes(int numLanes);
+	void mergeLanes();
 
 	// Failure detection logging
 	void logNodeAdd(Address *, Address *);
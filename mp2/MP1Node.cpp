@@ -6,7 +6,6 @@
  **********************************/
 
 #include "MP1Node.h"
-#include <random>
 
 const short MP1Node::tCleanup = 20;
 const short MP1Node::tFail = 10;
@@ -21,7 +20,9 @@ MP1Node::MP1Node(std::shared_ptr<Member> member,
 	               const Params &params,
 								 std::shared_ptr<EmulNet> emul,
 								 std::shared_ptr<Log> log,
-								 Address address): par(params)
+								 Address address):
+	par(params), rng(params.SEED, RANDOM_MEMBERSHIP, *(int *)address.addr),
+	nextGossipTime(-1), nextCleanupTime(INT_MAX)
 {
 	for( int i = 0; i < 6; i++ ) {
 		NULLADDR[i] = 0;
@@ -42,7 +43,7 @@ MP1Node::~MP1Node() {}
 /**
  * FUNCTION NAME: recvLoop
  *
- * DESCRIPTION: This function receives message from the network and pushes into the queue
+ * DESCRIPTION: This function receives message from the network into the inbox
  * 				This function is called by a node to receive messages currently waiting for it
  */
 int MP1Node::recvLoop()
@@ -53,21 +54,10 @@ int MP1Node::recvLoop()
     }
     else
 		{
-    	return emulNet->ENrecv(
-				memberNode->addr, enqueueWrapper, NULL, 1, &(memberNode->mp1q));
+    	return emulNet->ENrecvBatch(memberNode->addr, inbox, CHANNEL_MEMBERSHIP);
     }
 }
 
-/**
- * FUNCTION NAME: enqueueWrapper
- *
- * DESCRIPTION: Enqueue the message from Emulnet into the queue
- */
-int MP1Node::enqueueWrapper(void *env, char *buff, int size)
-{
-	return Queue::enqueue((queue<q_elt> *)env, (void *)buff, size);
-}
-
 /**
  * FUNCTION NAME: nodeStart
  *
@@ -83,7 +73,7 @@ void MP1Node::nodeStart(char *servaddrstr, short servport)
   if(!introduceSelfToGroup(joinaddr)) {
     finishUpThisNode();
 		logMsg("Unable to join self to group. Exiting.");
-    exit(1);
+    throw std::runtime_error("Unable to join self to group");
   }
 
   return;
@@ -102,7 +92,7 @@ void MP1Node::initThisNode()
     // node is up!
 	memberNode->numNeighbours = 0;
 	memberNode->heartbeat = 0;
-	memberNode->pingCounter = MP1Node::tGossip;
+	nextGossipTime = -1;
   initMemberListTable();
 }
 
@@ -130,7 +120,8 @@ int MP1Node::introduceSelfToGroup(Address& joinaddr)
 		// you send from your own address to the joinaddr, specifying the msg
 		// and its size
     emulNet->ENsend(memberNode->addr, joinaddr,
-					          joinMsg.getMessage(), joinMsg.getMessageSize());
+					          joinMsg.getMessage(), joinMsg.getMessageSize(),
+					          CHANNEL_MEMBERSHIP);
   }
 
 	return 1;
@@ -179,21 +170,17 @@ void MP1Node::nodeLoop()
 /**
  * FUNCTION NAME: checkMessages
  *
- * DESCRIPTION: Check messages in the queue and call the respective message handler
+ * DESCRIPTION: Check messages in the inbox and call the respective message handler
  */
 void MP1Node::checkMessages()
 {
-    void *ptr;
-    int size;
-
-    // Pop waiting messages from memberNode's mp1q
-    while (!memberNode->mp1q.empty())
+    // Handle the messages received this tick, in arrival order
+    for (const q_elt& msg : inbox)
 		{
-    	ptr = memberNode->mp1q.front().elt;
-    	size = memberNode->mp1q.front().size;
-    	memberNode->mp1q.pop();
-    	recvCallBack((char *)ptr, size);
+    	recvCallBack((char *)msg.elt, msg.size);
+    	emulNet->ENrelease((char *)msg.elt);
     }
+    inbox.clear();
     return;
 }
 
@@ -245,7 +232,8 @@ bool MP1Node::recvCallBack(char *data, int size)
 																				&memberNode->heartbeat);
 
 		  emulNet->ENsend(memberNode->addr, senderAddr,
-		                  joinMsg.getMessage(), joinMsg.getMessageSize());
+		                  joinMsg.getMessage(), joinMsg.getMessageSize(),
+		                  CHANNEL_MEMBERSHIP);
 		  logEvent(
 			  "Sending reply message for join request to %d.%d.%d.%d:%d", senderAddr);
 
@@ -264,8 +252,21 @@ bool MP1Node::recvCallBack(char *data, int size)
  */
 void MP1Node::nodeLoopOps()
 {
-	// Propagate the membership list if it's time to gossip again.
-	if (memberNode->pingCounter == 0)
+	// The first round is tGossip ticks after joining, the next ones
+	// tGossip + 1 ticks apart.
+	if (nextGossipTime < 0)
+	{
+		nextGossipTime = par.getcurrtime() + MP1Node::tGossip;
+	}
+
+	// Propagate the membership list if it's time to gossip again. While the
+	// network pushes back on this node, the round waits for the next tick.
+	if (par.getcurrtime() >= nextGossipTime &&
+	    emulNet->ENbackpressure(memberNode->addr))
+	{
+		nextGossipTime = par.getcurrtime() + 1;
+	}
+	else if (par.getcurrtime() >= nextGossipTime)
 	{
 		// Time to gossip again.
 		// Start by updating your own heartbeat.
@@ -281,20 +282,80 @@ void MP1Node::nodeLoopOps()
 		// Send to a random subset of active neighbours
 		sendGossip(activeNodes, std::move(gossipMsg));
 
-		// Reset the ping counter.
-		memberNode->pingCounter = MP1Node::tGossip;
-	}
-  else
-	{
-		memberNode->pingCounter--;
+		nextGossipTime = par.getcurrtime() + MP1Node::tGossip + 1;
 	}
 
 	// Remove any nodes that have not been updated recently.
-	cleanMemberList();
+	if (par.getcurrtime() >= nextCleanupTime)
+	{
+		cleanMemberList();
+	}
 
 	return;
 }
 
+/**
+ * FUNCTION NAME: nextWakeTime
+ *
+ * DESCRIPTION: Returns the next tick at which nodeLoop has work to do even if
+ *              no message arrives, INT_MAX if there is none. Visiting the
+ *              node in other ticks without messages changes nothing.
+ */
+int MP1Node::nextWakeTime()
+{
+	if (memberNode->failed || !memberNode->inGroup)
+	{
+		// Only a message can move the node on.
+		return INT_MAX;
+	}
+	if (nextGossipTime < 0)
+	{
+		return par.getcurrtime() + 1;
+	}
+	return std::min(nextGossipTime, nextCleanupTime);
+}
+
+/**
+ * FUNCTION NAME: save
+ *
+ * DESCRIPTION: Writes the protocol state of the node to checkpoint `w`,
+ *              between ticks. The Member is written by its owner.
+ */
+void MP1Node::save(CheckpointWriter& w) const
+{
+	if (!inbox.empty())
+	{
+		throw std::runtime_error("MP1Node: cannot checkpoint queued messages");
+	}
+	w.section("MP1N");
+	w.write(rng);
+	w.write(nextGossipTime);
+	w.write(nextCleanupTime);
+}
+
+/**
+ * FUNCTION NAME: load
+ *
+ * DESCRIPTION: Reads the protocol state of the node back from checkpoint
+ *              `r`, once its Member is loaded, and indexes its member list.
+ */
+void MP1Node::load(CheckpointReader& r)
+{
+	r.section("MP1N");
+	r.read(rng);
+	r.read(nextGossipTime);
+	r.read(nextCleanupTime);
+
+	memTableIdx.clear();
+	for (size_t i = 0; i < memberNode->memberList.size(); i++)
+	{
+		MemberListEntry& entry = memberNode->memberList[i];
+		Address entryAddr = addressHandler->addressFromIdAndPort(
+			entry.getid(), entry.getport());
+		memTableIdx[std::string(entryAddr.addr)] = i;
+	}
+}
+
 /**
  * FUNCTION NAME: getJoinAddress
  *
@@ -313,6 +374,8 @@ Address MP1Node::getJoinAddress()
 void MP1Node::initMemberListTable()
 {
 	memberNode->memberList.clear();
+	memberNode->memberListVersion++;
+	nextCleanupTime = INT_MAX;
 	// Add self to the table
 	addMembershipEntry(memberNode->addr, memberNode->heartbeat);
 }
@@ -354,10 +417,13 @@ void MP1Node::addMembershipEntry(Address& newAddr, long newHeartbeat)
 
 	memTableIdx[newAddrStr] = memberNode->memberList.size();
 	memberNode->memberList.push_back(mle);
+	memberNode->memberListVersion++;
 	log->logNodeAdd(&memberNode->addr, &newAddr);
 	if (memberNode->addr != newAddr)
 	{
     memberNode->numNeighbours++;
+		nextCleanupTime = std::min(
+			nextCleanupTime, par.getcurrtime() + MP1Node::tCleanup + 1);
   }
 }
 
@@ -399,6 +465,7 @@ void MP1Node::logMsg(const char* msg)
 void MP1Node::cleanMemberList()
 {
 	std::vector<MemberListEntry> cleanedMemberList;
+	nextCleanupTime = INT_MAX;
 	for (auto itr = memberNode->memberList.begin();
        itr != memberNode->memberList.end();
 		   itr++)
@@ -413,12 +480,21 @@ void MP1Node::cleanMemberList()
 		{
 			memTableIdx[entryAddrStr] = cleanedMemberList.size();
 			cleanedMemberList.emplace_back(*itr);
+			if (entryAddr != memberNode->addr)
+			{
+				// Heartbeats only move the timestamps on, so no member can be
+				// cleaned up before this.
+				nextCleanupTime = std::min(
+					nextCleanupTime,
+					(int)itr->gettimestamp() + MP1Node::tCleanup + 1);
+			}
 		}
 		else
 		{
 			log->logNodeRemove(&memberNode->addr, &entryAddr);
 			memTableIdx.erase(entryAddrStr);
 			memberNode->numNeighbours--;
+			memberNode->memberListVersion++;
 		}
 	}
 
@@ -454,13 +530,10 @@ std::vector<MemberListEntry> MP1Node::getActiveNodes()
 void MP1Node::sendGossip(std::vector<MemberListEntry>& activeNodes,
                          std::unique_ptr<GossipMessage> gossipMsg)
 {
-	std::random_device rd;
-	std::mt19937 g(rd());
-	std::shuffle(activeNodes.begin(), activeNodes.end(), g);
+	std::shuffle(activeNodes.begin(), activeNodes.end(), rng);
 	int neighborsInGossip = (int)(Config::gossipProportion * activeNodes.size());
 
-  char* msg = gossipMsg->getMessage();
-
+	std::vector<Address> destAddrs;
 	for (int i = 0; i < neighborsInGossip; i++)
 	{
 		Address destAddr = addressHandler->addressFromIdAndPort(
@@ -469,10 +542,14 @@ void MP1Node::sendGossip(std::vector<MemberListEntry>& activeNodes,
 		{
 			continue;
 		}
-		emulNet->ENsend(memberNode->addr, destAddr,
-										msg, gossipMsg->getMessageSize());
+		destAddrs.emplace_back(destAddr);
 		logEvent("Sending gossip message to %d.%d.%d.%d:%d", destAddr);
 	}
+
+	// Every neighbour shares the same copy of the gossip message.
+	emulNet->ENsendMany(memberNode->addr, destAddrs,
+	                    gossipMsg->getMessage(), gossipMsg->getMessageSize(),
+	                    CHANNEL_MEMBERSHIP);
 }
 
 void MP1Node::handleGossipMessage(char* gossipData,
@@ -535,7 +612,7 @@ void MP1Node::printMemberTable()
 	{
 		Address mleAddress = addressHandler->addressFromIdAndPort(
 			itr->getid(), itr->getport());
-		static char logMsg[1024];
+		char logMsg[1024];
 	  snprintf(
 			logMsg,
 			sizeof(logMsg),
@@ -558,7 +635,7 @@ void MP1Node::incrementHeartbeat()
 	if (itr == memTableIdx.end())
 	{
 		logMsg("Something has gone wrong, cannot find self!");
-		exit(1);
+		throw std::runtime_error("Something has gone wrong, cannot find self!");
 	}
 	memberNode->memberList[itr->second].setheartbeat(memberNode->heartbeat);
 	memberNode->memberList[itr->second].settimestamp(par.getcurrtime());
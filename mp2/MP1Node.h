@@ -16,6 +16,7 @@
 #include "Message.h"
 #include "EmulNet.h"
 #include "Queue.h"
+#include "Random.h"
 
 /**
  * CLASS NAME: MP1Node
@@ -32,6 +33,14 @@ private:
   std::unique_ptr<AddressHandler> addressHandler;
   std::unordered_map<std::string, size_t> memTableIdx;
   std::string addrStr;
+  // Messages received this tick, handled by checkMessages.
+  std::vector<q_elt> inbox;
+  // Picks the gossip targets.
+  Random rng;
+  // Tick of the next gossip round, -1 until the first nodeLoopOps.
+  int nextGossipTime;
+  // First tick at which a member other than this node can be cleaned up.
+  int nextCleanupTime;
 
   static const short tCleanup;
   static const short tFail;
@@ -63,14 +72,20 @@ public:
 	std::shared_ptr<Member> getMemberNode() {
 		return memberNode;
 	}
+	// Inbox filled by recvLoop, or directly by EmulNet::ENrecvAll
+	std::vector<q_elt>& getInbox() {
+		return inbox;
+	}
 	int recvLoop();
-	static int enqueueWrapper(void *env, char *buff, int size);
 	void nodeStart(char *servaddrstr, short serverport);
 	int finishUpThisNode();
 	void nodeLoop();
 	void checkMessages();
 	bool recvCallBack(char *data, int size);
 	void nodeLoopOps();
+	int nextWakeTime();
+	void save(CheckpointWriter& w) const;
+	void load(CheckpointReader& r);
 	Address getJoinAddress();
 	void initMemberListTable();
 	virtual ~MP1Node();
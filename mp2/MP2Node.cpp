@@ -5,8 +5,6 @@
  **********************************/
 #include "MP2Node.h"
 
-int MP2Node::transactionId = 0;
-
 /**
  * constructor
  */
@@ -14,7 +12,8 @@ MP2Node::MP2Node(std::shared_ptr<Member> memberNode,
 	               const Params &par,
 								 std::shared_ptr<EmulNet> emulNet,
 								 std::shared_ptr<Log> log,
-								 Address address): par(par)
+								 Address address): ringVersion(-1), par(par),
+								 transactionId(0)
 {
 	this->memberNode = memberNode;
 	this->emulNet = emulNet;
@@ -45,6 +44,13 @@ void MP2Node::updateRing()
 	// Indicates whether the ring has changed
 	bool change = false;
 
+	// The ring only changes along with the membership list.
+	if (this->ringVersion == this->memberNode->memberListVersion)
+	{
+		return;
+	}
+	this->ringVersion = this->memberNode->memberListVersion;
+
 	/*
 	 *  Step 1. Get the current membership list from Membership Protocol / MP1
 	 *
@@ -192,19 +198,13 @@ void MP2Node::clientRead(std::string key)
 	// Get an ID for the current transaction.
 	int currTransId = getTransactionId();
 
-	// Iterate through the replicas.
-	for (auto rItr = replicas.begin(); rItr != replicas.end(); rItr++)
-	{
-		// Construct message for the replica.
-		Message rMsg = Message(
-			currTransId,
-			this->memberNode->addr,
-			KVMessageType::READ,
-			key);
-
-		// Send the read message to the replica.
-		this->sendMsg(rItr->nodeAddress, rMsg);
-	}
+	// Every replica gets the same read message.
+	Message rMsg = Message(
+		currTransId,
+		this->memberNode->addr,
+		KVMessageType::READ,
+		key);
+	this->sendMsg(replicas, rMsg);
 
 	// Keep a record of the pending read transaction.
 	this->pendingReads.insert(
@@ -263,19 +263,13 @@ void MP2Node::clientDelete(std::string key)
   // Get the transaction ID for this transaction.
 	int currTransId = getTransactionId();
 
-  // Iterate through the replicas.
-	for (auto rItr = replicas.begin(); rItr != replicas.end(); rItr++)
-	{
-		// Construct the delete message for the replica.
-		Message dMsg = Message(
-			currTransId,
-			this->memberNode->addr,
-			KVMessageType::DELETE,
-			key);
-
-		// Send the delete message to the replica.
-		this->sendMsg(rItr->nodeAddress, dMsg);
-	}
+  // Every replica gets the same delete message.
+	Message dMsg = Message(
+		currTransId,
+		this->memberNode->addr,
+		KVMessageType::DELETE,
+		key);
+	this->sendMsg(replicas, dMsg);
 
 	// Keep a record of the pending transaction.
 	// We use the WriteTransactionState constructor for delete states.
@@ -339,9 +333,8 @@ bool MP2Node::updateKeyValue(const std::string& key,
 		auto metaItr = this->replicaMetadata.find(key);
 		if (metaItr == this->replicaMetadata.end())
 		{
-			std::cout << "Something went wrong, we have no metadata for ";
-			std::cout << key << std::endl;
-			exit(1);
+			throw std::runtime_error(
+				"Something went wrong, we have no metadata for " + key);
 		}
 		metaItr->second = replica;
 	}
@@ -374,7 +367,7 @@ bool MP2Node::deletekey(const std::string& key)
  *
  * DESCRIPTION: This function is the message handler of this node.
  * 				This function does the following:
- * 				1) Pops messages from the queue
+ * 				1) Takes the messages received this tick from the inbox
  * 				2) Handles the messages according to message types
  */
 void MP2Node::checkMessages()
@@ -382,21 +375,14 @@ void MP2Node::checkMessages()
 	char * data;
 	int size;
 
-	/*
-	 * Declare your local variables here
-	 */
-
-	// dequeue all messages and handle them
-	while (!memberNode->mp2q.empty())
+	// handle all the messages received this tick, in arrival order
+	for (const q_elt& received : this->inbox)
 	{
-		/*
-		 * Pop a message from the queue
-		 */
-		data = (char *)memberNode->mp2q.front().elt;
-		size = memberNode->mp2q.front().size;
-		memberNode->mp2q.pop();
+		data = (char *)received.elt;
+		size = received.size;
 
 		string message(data, data + size);
+		this->emulNet->ENrelease(data);
 		Message msg = Message(message);
 
     // Note: when re-replicating for failures / nodes joining we set the
@@ -423,10 +409,10 @@ void MP2Node::checkMessages()
 			  handleReadReplyMessage(msg);
 				break;
 			default:
-			  std::cout << "Invalid message type received" << std::endl;
-			  exit(1);
+			  throw std::runtime_error("Invalid message type received");
 		}
 	}
+	this->inbox.clear();
 
 	this->removeExpiredTransactions();
 }
@@ -505,27 +491,16 @@ bool MP2Node::iAmPrimary(string key, int myIdx)
 /**
  * FUNCTION NAME: recvLoop
  *
- * DESCRIPTION: Receive messages from EmulNet and push into the queue (mp2q)
+ * DESCRIPTION: Receive messages from EmulNet into the inbox
  */
 bool MP2Node::recvLoop() {
     if ( memberNode->failed ) {
     	return false;
     }
     else {
-    	return emulNet->ENrecv(
-				memberNode->addr, this->enqueueWrapper, NULL, 1, &(memberNode->mp2q));
+    	return emulNet->ENrecvBatch(memberNode->addr, this->inbox, CHANNEL_KVSTORE);
     }
 }
-
-/**
- * FUNCTION NAME: enqueueWrapper
- *
- * DESCRIPTION: Enqueue the message from Emulnet into the queue of MP2Node
- */
-int MP2Node::enqueueWrapper(void *env, char *buff, int size)
-{
-	return Queue::enqueue((queue<q_elt> *)env, (void *)buff, size);
-}
 /**
  * FUNCTION NAME: stabilizationProtocol
  *
@@ -546,7 +521,13 @@ void MP2Node::stabilizationProtocol() {
 
 	for (int ringPos = 0; ringPos < this->ring.size(); ringPos++)
 	{
-		if (!haveReplicasOfAlive[0] && (this->ring[ringPos].nodeAddress ==
+		// Checked first: on a ring of fewer than three nodes our neighbours
+		// wrap around to ourselves.
+		if (this->ring[ringPos].nodeAddress == this->memberNode->addr)
+		{
+			myPos = ringPos;
+		}
+		else if (!haveReplicasOfAlive[0] && (this->ring[ringPos].nodeAddress ==
 			  this->haveReplicasOf[0].nodeAddress))
 		{
 			haveReplicasOfAlive[0] = true;
@@ -556,10 +537,6 @@ void MP2Node::stabilizationProtocol() {
 		{
 			haveReplicasOfAlive[1] = true;
 		}
-		else if (this->ring[ringPos].nodeAddress == this->memberNode->addr)
-		{
-			myPos = ringPos;
-		}
 		else if (!hasMyReplicasAlive[0] && (this->ring[ringPos].nodeAddress ==
 		         this->hasMyReplicas[0].nodeAddress))
 		{
@@ -574,8 +551,7 @@ void MP2Node::stabilizationProtocol() {
 
 	if (myPos < 0)
 	{
-		std::cout << "Cannot find self!" << std::endl;
-		exit(1);
+		throw std::runtime_error("Cannot find self!");
 	}
 
   // Copy old values as these will be needed for replica management.
@@ -602,8 +578,7 @@ void MP2Node::stabilizationProtocol() {
 			std::string v = this->ht->read(repItr->first);
 			if (v.compare("") == 0)
 			{
-				std::cout << "Cannot find value for " << repItr->first << std::endl;
-				exit(1);
+				throw std::runtime_error("Cannot find value for " + repItr->first);
 			}
 
 			// Create the replication messages for the secondary and tertiary. For
@@ -897,10 +872,16 @@ void MP2Node::handleWriteReplyMessage(const Message& msg)
 	if (txnPointer->second.hasTransactionSucceeded())
 	{
 		logWriteSuccess(msg.transID);
+		this->stats.record(txnPointer->second.getTransactionType(),
+		                   txnPointer->second.getStartTime(),
+		                   this->par.getcurrtime(), true);
 	}
 	else if (txnPointer->second.hasTransactionFailed())
 	{
 		logWriteFailure(msg.transID);
+		this->stats.record(txnPointer->second.getTransactionType(),
+		                   txnPointer->second.getStartTime(),
+		                   this->par.getcurrtime(), false);
 	}
 
 	if (txnPointer->second.allRepliesReceived())
@@ -953,6 +934,9 @@ void MP2Node::handleReadReplyMessage(const Message& msg)
 				readTxnPointer->second.getKey(),
 				msg.value);
 		}
+		this->stats.record(TransactionType::T_READ,
+		                   readTxnPointer->second.getStartTime(),
+		                   this->par.getcurrtime(), msg.value.compare("") != 0);
 	}
 
 	if (readTxnPointer->second.allRepliesReceived())
@@ -965,6 +949,9 @@ void MP2Node::handleReadReplyMessage(const Message& msg)
 				true,
 				msg.transID,
 				readTxnPointer->second.getKey());
+			this->stats.record(TransactionType::T_READ,
+			                   readTxnPointer->second.getStartTime(),
+			                   this->par.getcurrtime(), false);
 		}
 
 		// We have received all replies so this transaction is no longer pending.
@@ -1070,9 +1057,7 @@ void MP2Node::logWriteFailure(int transId)
  */
 int MP2Node::getTransactionId()
 {
-	int transId = MP2Node::transactionId;
-	MP2Node::transactionId++;
-	return transId;
+	return transactionId++;
 }
 
 /*
@@ -1108,7 +1093,7 @@ void MP2Node::removeExpiredTransactions()
 {
 	int currTime = par.getcurrtime();
 
-	std::unordered_map<int, ReadTransactionState> pendingReads;
+	std::map<int, ReadTransactionState> pendingReads;
 	// Start with the read transactions.
 	for (auto readTxnPointer = this->pendingReads.begin();
        readTxnPointer != this->pendingReads.end();
@@ -1126,6 +1111,9 @@ void MP2Node::removeExpiredTransactions()
 				  true,
 				  readTxnPointer->first,
 				  readTxnPointer->second.getKey());
+			  this->stats.record(TransactionType::T_READ,
+			                     readTxnPointer->second.getStartTime(),
+			                     currTime, false);
 		  }
 		}
 		else
@@ -1135,7 +1123,7 @@ void MP2Node::removeExpiredTransactions()
 	}
 	this->pendingReads = pendingReads;
 
-  std::unordered_map<int, WriteTransactionState> pendingWrites;
+  std::map<int, WriteTransactionState> pendingWrites;
 	// Next do write transactions.
 	for (auto writeTxnPointer = this->pendingWrites.begin();
        writeTxnPointer != this->pendingWrites.end();
@@ -1174,9 +1162,11 @@ void MP2Node::removeExpiredTransactions()
 						  writeTxnPointer->second.getKey());
 					  break;
 				  default:
-				    std::cout << "Invalid write transaction type" << std::endl;
-					  exit(1);
+				    throw std::runtime_error("Invalid write transaction type");
 			  }
+			  this->stats.record(writeTxnPointer->second.getTransactionType(),
+			                     writeTxnPointer->second.getStartTime(),
+			                     currTime, false);
 			}
 		}
 		else
@@ -1187,6 +1177,132 @@ void MP2Node::removeExpiredTransactions()
 	this->pendingWrites = pendingWrites;
 }
 
+/**
+ * FUNCTION NAME: nextWakeTime
+ *
+ * DESCRIPTION: Returns the next tick at which checkMessages times out a
+ *              pending transaction, INT_MAX if there is none.
+ */
+int MP2Node::nextWakeTime()
+{
+	int wakeTime = INT_MAX;
+	for (auto& read : this->pendingReads)
+	{
+		wakeTime = std::min(wakeTime, read.second.getExpiryTime());
+	}
+	for (auto& write : this->pendingWrites)
+	{
+		wakeTime = std::min(wakeTime, write.second.getExpiryTime());
+	}
+	return wakeTime;
+}
+
+/**
+ * FUNCTION NAME: saveNodes
+ *
+ * DESCRIPTION: Writes the addresses of `nodes` to checkpoint `w`
+ */
+static void saveNodes(CheckpointWriter& w, const std::vector<Node>& nodes)
+{
+	w.write(nodes.size());
+	for (const Node& node : nodes)
+	{
+		w.writeBytes(node.nodeAddress.addr, sizeof(node.nodeAddress.addr));
+	}
+}
+
+/**
+ * FUNCTION NAME: loadNodes
+ *
+ * DESCRIPTION: Reads the nodes written by saveNodes into `nodes`
+ */
+static void loadNodes(CheckpointReader& r, std::vector<Node>& nodes)
+{
+	nodes.clear();
+	for (size_t count = r.read<size_t>(); count > 0; count--)
+	{
+		Address address;
+		r.readBytes(address.addr, sizeof(address.addr));
+		nodes.emplace_back(address);
+	}
+}
+
+/**
+ * FUNCTION NAME: save
+ *
+ * DESCRIPTION: Writes the ring, the neighbourhood, the store, the pending
+ *              transactions and the outcomes of this node to checkpoint
+ *              `w`. The Member is written by its owner.
+ */
+void MP2Node::save(CheckpointWriter& w) const
+{
+	if (!this->inbox.empty())
+	{
+		throw std::runtime_error("MP2Node: cannot checkpoint queued messages");
+	}
+	w.section("MP2N");
+	saveNodes(w, this->ring);
+	saveNodes(w, this->hasMyReplicas);
+	saveNodes(w, this->haveReplicasOf);
+	w.write(this->ringVersion);
+	this->ht->save(w);
+	w.write(this->replicaMetadata.size());
+	for (const auto& replica : this->replicaMetadata)
+	{
+		w.writeString(replica.first);
+		w.write(replica.second);
+	}
+	w.write(this->pendingWrites.size());
+	for (const auto& write : this->pendingWrites)
+	{
+		w.write(write.first);
+		write.second.save(w);
+	}
+	w.write(this->pendingReads.size());
+	for (const auto& read : this->pendingReads)
+	{
+		w.write(read.first);
+		read.second.save(w);
+	}
+	this->stats.save(w);
+	w.write(this->transactionId);
+}
+
+/**
+ * FUNCTION NAME: load
+ *
+ * DESCRIPTION: Reads the state written by save back from checkpoint `r`
+ */
+void MP2Node::load(CheckpointReader& r)
+{
+	r.section("MP2N");
+	loadNodes(r, this->ring);
+	loadNodes(r, this->hasMyReplicas);
+	loadNodes(r, this->haveReplicasOf);
+	r.read(this->ringVersion);
+	this->ht->load(r);
+	this->replicaMetadata.clear();
+	for (size_t count = r.read<size_t>(); count > 0; count--)
+	{
+		std::string key = r.readString();
+		this->replicaMetadata[key] = r.read<ReplicaType>();
+	}
+	this->pendingWrites.clear();
+	for (size_t count = r.read<size_t>(); count > 0; count--)
+	{
+		int transId = r.read<int>();
+		this->pendingWrites.insert({transId, WriteTransactionState(r)});
+	}
+	this->pendingReads.clear();
+	for (size_t count = r.read<size_t>(); count > 0; count--)
+	{
+		int transId = r.read<int>();
+		this->pendingReads.insert({transId, ReadTransactionState(r)});
+	}
+	this->stats.load(r);
+	r.read(this->transactionId);
+}
+
 /**
  * FUNCTION NAME: initializeNeighbourhood
  *
@@ -1209,8 +1325,7 @@ void MP2Node::initializeNeighbourhood()
 
 	if (myPos == -1)
 	{
-		std::cout << "Error: cannot find self" << std::endl;
-		exit(1);
+		throw std::runtime_error("Error: cannot find self");
 	}
 
 	// Set the predecessors and successors.
@@ -1229,10 +1344,12 @@ void MP2Node::setNeighbourhood(int myPosOnRing)
 {
 	// Set the 2 predecessors.
 	this->haveReplicasOf = std::vector<Node>();
+	// currPos is negative for the first two nodes; taken modulo the unsigned
+	// ring size as is, it would land on an arbitrary node, possibly ourselves.
 	for (int currPos = myPosOnRing - 2; currPos < myPosOnRing; currPos++)
 	{
 		this->haveReplicasOf.emplace_back(
-			this->ring.at((currPos % this->ring.size())));
+			this->ring.at((currPos + this->ring.size()) % this->ring.size()));
 	}
 
 	// Then set the 2 successors.
@@ -1255,5 +1372,24 @@ void MP2Node::setNeighbourhood(int myPosOnRing)
 void MP2Node::sendMsg(const Address& toAddr, const Message& msg)
 {
 	this->emulNet->ENsend(
-		this->memberNode->addr, toAddr, msg.toString());
+		this->memberNode->addr, toAddr, msg.toString(), CHANNEL_KVSTORE);
+}
+
+/**
+ * FUNCTION NAME: sendMsg
+ *
+ * DESCRIPTION: a helper message for sending the same message `msg` over the
+ *              network from this node to every node in `toNodes`. The message
+ *              is serialized once and shared by all the destinations.
+ */
+void MP2Node::sendMsg(const std::vector<Node>& toNodes, const Message& msg)
+{
+	std::vector<Address> toAddrs;
+	toAddrs.reserve(toNodes.size());
+	for (const Node& node : toNodes)
+	{
+		toAddrs.emplace_back(node.nodeAddress);
+	}
+	this->emulNet->ENsendMany(
+		this->memberNode->addr, toAddrs, msg.toString(), CHANNEL_KVSTORE);
 }
@@ -18,6 +18,7 @@
 #include "Message.h"
 #include "Queue.h"
 #include "TransactionState.h"
+#include "LatencyHistogram.h"
 
 /**
  * CLASS NAME: MP2Node
@@ -36,23 +37,36 @@ private:
 	// Vector holding the previous two neighbors in the ring whose replicas I have
 	std::vector<Node> haveReplicasOf;
 	std::vector<Node> ring;
+	// Member::memberListVersion the ring was built from, -1 before the first
+	// updateRing.
+	int ringVersion;
 	std::unique_ptr<HashTable> ht;
 	std::shared_ptr<Member> memberNode; // This member
 	const Params &par;
 	std::shared_ptr<EmulNet> emulNet;
 	std::shared_ptr<Log> log;
 	std::unique_ptr<AddressHandler> addressHandler;
+	// Messages received this tick, handled by checkMessages
+	std::vector<q_elt> inbox;
 
   // Stores replica metadata, that is the replica type for the given key.
 	// This could be extended to hold other metadata in the future.
-	std::unordered_map<std::string, ReplicaType> replicaMetadata;
+	// The maps below are ordered: the node walks them to decide what to send
+	// and log, and a resumed run has to walk them in the same order.
+	std::map<std::string, ReplicaType> replicaMetadata;
 
   // Tracks writes initiated by this node.
-	std::unordered_map<int, WriteTransactionState> pendingWrites;
+	std::map<int, WriteTransactionState> pendingWrites;
 	// Tracks reads initiated by this node.
-	std::unordered_map<int, ReadTransactionState> pendingReads;
+	std::map<int, ReadTransactionState> pendingReads;
 
-	static int transactionId;
+	// Outcomes of the transactions this node coordinated
+	CoordinatorStats stats;
+
+	// Id of the next transaction this node coordinates. The ids only need
+	// to tell apart the transactions of one coordinator, which is where the
+	// replies go.
+	int transactionId;
 
 	void handleCreateMessage(const Message& msg);
 	void handleReadMessage(const Message& msg);
@@ -83,8 +97,9 @@ private:
   // Determines whether the current node is the primary for the key.
 	bool iAmPrimary(string key, int myIdx);
 
-  // Helper method for sending messages.
+  // Helper methods for sending messages.
 	void sendMsg(const Address& toAddr, const Message& msg);
+	void sendMsg(const std::vector<Node>& toNodes, const Message& msg);
 
 public:
 	MP2Node(
@@ -94,6 +109,10 @@ public:
 	std::shared_ptr<Member> getMemberNode() {
 		return this->memberNode;
 	}
+	// Inbox filled by recvLoop, or directly by EmulNet::ENrecvAll
+	std::vector<q_elt>& getInbox() {
+		return this->inbox;
+	}
 
 	// ring functionalities
 	void updateRing();
@@ -109,10 +128,18 @@ public:
 
 	// receive messages from Emulnet
 	bool recvLoop();
-	static int enqueueWrapper(void *env, char *buff, int size);
 
 	// handle messages from receiving queue
 	void checkMessages();
+	// next tick at which a pending transaction times out
+	int nextWakeTime();
+	// checkpoint of the ring and the store, taken between ticks
+	void save(CheckpointWriter& w) const;
+	void load(CheckpointReader& r);
+	// outcomes of the client calls this node coordinated
+	CoordinatorStats& getStats() {
+		return this->stats;
+	}
 
 	// coordinator dispatches messages to corresponding nodes
 	void dispatchMessages(Message message);
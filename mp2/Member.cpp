@@ -50,7 +50,7 @@ MemberListEntry& MemberListEntry::operator =(const MemberListEntry &anotherMLE)
  */
 Member::Member()
   : inited(false), inGroup(false), failed(false),
-	  numNeighbours(0), heartbeat(0), pingCounter(0) {}
+	  numNeighbours(0), heartbeat(0), pingCounter(0), memberListVersion(0) {}
 
 /**
  * Copy Constructor
@@ -65,6 +65,7 @@ Member::Member(const Member &anotherMember)
 	this->heartbeat = anotherMember.heartbeat;
 	this->pingCounter = anotherMember.pingCounter;
 	this->memberList = anotherMember.memberList;
+	this->memberListVersion = anotherMember.memberListVersion;
 	this->mp1q = anotherMember.mp1q;
 	this->mp2q = anotherMember.mp2q;
 }
@@ -83,6 +84,7 @@ Member::Member(Member &&anotherMember)
 	this->heartbeat = anotherMember.heartbeat;
 	this->pingCounter = anotherMember.pingCounter;
 	this->memberList = anotherMember.memberList;
+	this->memberListVersion = anotherMember.memberListVersion;
 	this->mp1q = anotherMember.mp1q;
 	this->mp2q = anotherMember.mp2q;
 
@@ -95,6 +97,7 @@ Member::Member(Member &&anotherMember)
 	anotherMember.heartbeat = 0;
 	anotherMember.pingCounter = 0;
 	anotherMember.memberList.clear();
+	anotherMember.memberListVersion = 0;
 	anotherMember.mp1q = std::queue<q_elt>();
 	anotherMember.mp2q = std::queue<q_elt>();
 }
@@ -112,7 +115,65 @@ Member& Member::operator =(const Member& anotherMember)
 	this->heartbeat = anotherMember.heartbeat;
 	this->pingCounter = anotherMember.pingCounter;
 	this->memberList = anotherMember.memberList;
+	this->memberListVersion = anotherMember.memberListVersion;
 	this->mp1q = anotherMember.mp1q;
 	this->mp2q = anotherMember.mp2q;
 	return *this;
 }
+
+/**
+ * FUNCTION NAME: save
+ *
+ * DESCRIPTION: Writes the member to checkpoint `w`. The queues are not
+ *              written; they only hold messages during a tick.
+ */
+void Member::save(CheckpointWriter& w) const
+{
+	if (!mp1q.empty() || !mp2q.empty())
+	{
+		throw std::runtime_error("Member: cannot checkpoint queued messages");
+	}
+	w.section("MEMB");
+	w.writeBytes(addr.addr, sizeof(addr.addr));
+	w.write(inited);
+	w.write(inGroup);
+	w.write(failed);
+	w.write(numNeighbours);
+	w.write(heartbeat);
+	w.write(pingCounter);
+	w.write(memberList.size());
+	for (const MemberListEntry& entry : memberList)
+	{
+		w.write(entry.id);
+		w.write(entry.port);
+		w.write(entry.heartbeat);
+		w.write(entry.timestamp);
+	}
+	w.write(memberListVersion);
+}
+
+/**
+ * FUNCTION NAME: load
+ *
+ * DESCRIPTION: Reads the member back from checkpoint `r`
+ */
+void Member::load(CheckpointReader& r)
+{
+	r.section("MEMB");
+	r.readBytes(addr.addr, sizeof(addr.addr));
+	r.read(inited);
+	r.read(inGroup);
+	r.read(failed);
+	r.read(numNeighbours);
+	r.read(heartbeat);
+	r.read(pingCounter);
+	memberList.resize(r.read<size_t>());
+	for (MemberListEntry& entry : memberList)
+	{
+		r.read(entry.id);
+		r.read(entry.port);
+		r.read(entry.heartbeat);
+		r.read(entry.timestamp);
+	}
+	r.read(memberListVersion);
+}
@@ -10,6 +10,7 @@
 #include "stdincludes.h"
 #include "Address.h"
 #include "Queue.h"
+#include "Checkpoint.h"
 
 /**
  * CLASS NAME: MemberListEntry
@@ -53,6 +54,7 @@ public:
 	long heartbeat; // my heartbeat
 	int pingCounter; // counter for next ping
 	std::vector<MemberListEntry> memberList; // Membership table
+	int memberListVersion; // bumped whenever memberList gains or loses a member
 	queue<q_elt> mp1q; // Queue for failure detection messages
 	queue<q_elt> mp2q; // Queue for KVstore messages
 	/**
@@ -65,6 +67,9 @@ public:
 	Member& operator =(const Member &anotherMember);
 	// Move Constructor
 	Member(Member &&anotherMember);
+	// Checkpoint of the member, taken between ticks with both queues empty
+	void save(CheckpointWriter& w) const;
+	void load(CheckpointReader& r);
 	// Virtual destructor.
 	// The destructor does nothing but the virtual ensures it is cleaned up
 	// before any child classes.
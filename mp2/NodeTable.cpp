@@ -0,0 +1,33 @@
+/**********************************
+ * FILE NAME: NodeTable.cpp
+ *
+ * DESCRIPTION: Definition of the per-node state checked by the tick loops
+ **********************************/
+
+#include "NodeTable.h"
+
+/**
+ * Constructor. Node i is introduced at tick STEP_RATE * i and is neither
+ * failed nor joined until synced.
+ */
+NodeTable::NodeTable(int numNodes, double stepRate)
+	: startTimes(numNodes), addresses(numNodes), failed(numNodes, 0),
+	  joined(numNodes, 0)
+{
+	for (int i = 0; i < numNodes; i++)
+	{
+		startTimes[i] = (int)(stepRate*i);
+	}
+}
+
+/**
+ * FUNCTION NAME: sync
+ *
+ * DESCRIPTION: Copies the fields of node i from its Member `member`
+ */
+void NodeTable::sync(int i, const Member& member)
+{
+	addresses[i] = member.addr;
+	failed[i] = member.failed;
+	joined[i] = member.inited && member.inGroup;
+}
@@ -0,0 +1,59 @@
+/**********************************
+ * FILE NAME: NodeTable.h
+ *
+ * DESCRIPTION: Header file of the per-node state checked by the tick loops
+ **********************************/
+
+#ifndef NODE_TABLE_H_
+#define NODE_TABLE_H_
+
+#include "stdincludes.h"
+#include "Address.h"
+#include "Member.h"
+
+/**
+ * CLASS NAME: NodeTable
+ *
+ * DESCRIPTION: The state of every node that the tick loops of the
+ *              Application check for each node they visit, one array per
+ *              field, indexed by node.
+ *
+ * Without it every check goes from the MP1Node or MP2Node of the node to
+ * its Member, a heap object of its own reached through a shared_ptr that is
+ * copied and released by every getMemberNode(). The arrays hold a few bytes
+ * per node and the loops walk them in node order.
+ *
+ * The Members stay the state of record: the protocols read and change them,
+ * and the Application copies a node's fields here with sync() whenever the
+ * node may have changed them, which is only when its membership protocol
+ * ran or when the tests fail it. The flags are chars rather than a
+ * vector<bool>, so the workers of a parallel tick can sync their own nodes
+ * at the same time.
+ */
+class NodeTable
+{
+private:
+	// Tick node i is introduced in, STEP_RATE * i
+	std::vector<int> startTimes;
+	std::vector<Address> addresses;
+	// Member::failed
+	std::vector<char> failed;
+	// Member::inited && Member::inGroup, when the node takes part in the ring
+	std::vector<char> joined;
+public:
+	NodeTable(int numNodes, double stepRate);
+
+	void sync(int i, const Member& member);
+
+	int startTime(int i) const { return startTimes[i]; }
+	const Address& address(int i) const { return addresses[i]; }
+	bool isFailed(int i) const { return failed[i]; }
+	bool isJoined(int i) const { return joined[i]; }
+	// Introduced before tick `time` and not failed: the node runs its steps
+	bool isRunning(int i, int time) const
+	{
+		return time > startTimes[i] && !failed[i];
+	}
+};
+
+#endif  // NODE_TABLE_H_
@@ -9,17 +9,25 @@
 /**
  * Constructor
  */
-Params::Params(): PORTNUM(8001) {}
+Params::Params(): PORTNUM(8001) {
+	setDefaults();
+	setNodeCount(0);
+}
 
 /**
  * FUNCTION NAME: setparams
  *
  * DESCRIPTION: Set the parameters for this test case
  */
-void Params::setparams(char *config_file) {
+void Params::setparams(const char *config_file) {
 	//trace.funcEntry("Params::setparams");
 	char CRUD[10];
 	FILE *fp = fopen(config_file,"r");
+	if (fp == NULL)
+	{
+		throw std::runtime_error(std::string("Cannot open test file ") +
+		                         config_file);
+	}
 
 	fscanf(fp,"NODES: %d", &MAX_NUM_NEIGHBOURS);
 	fscanf(fp,"\nCRUD_TEST: %s", CRUD);
@@ -40,13 +48,40 @@ void Params::setparams(char *config_file) {
 	{
 		this->testType = DELETE_TEST;
 	}
+	else if (0 == strcmp(CRUD, "WORKLOAD"))
+	{
+		this->testType = WORKLOAD_TEST;
+	}
 
-  NUM_PEERS = MAX_NUM_NEIGHBOURS;
+	setNodeCount(MAX_NUM_NEIGHBOURS);
 	STEP_RATE=.25;
-	MAX_MSG_SIZE = 4000;
+	setDefaults();
+	// Runs differ unless the test file fixes the seed.
+	SEED = (unsigned long)time(NULL);
+
+	// Any remaining lines are optional `KEY: value` settings.
+	char key[64];
+	char value[256];
+	while (fscanf(fp, " %63[^:]: %255s", key, value) == 2)
+	{
+		setOptionalParam(key, value);
+	}
+
+	WORKLOAD_VALUE_MAX = std::max(WORKLOAD_VALUE_MAX, WORKLOAD_VALUE_MIN);
+	if (LOCAL_NODES <= 0)
+	{
+		LOCAL_NODES = NUM_PEERS - FIRST_NODE_ID + 1;
+	}
+	insertTime = TOTAL_RUNNING_TIME - Config::insertLead;
+	testTime = TOTAL_RUNNING_TIME - Config::testLead;
+	if (CHECKPOINT_TIME < 0)
+	{
+		// The cluster has formed and holds no keys yet.
+		CHECKPOINT_TIME = insertTime - 1;
+	}
 	globaltime = 0;
 	allNodesJoined = 0;
-	for (unsigned int i = 0; i < NUM_PEERS; i++)
+	for (int i = FIRST_NODE_ID - 1; i < FIRST_NODE_ID - 1 + LOCAL_NODES; i++)
 	{
 		allNodesJoined += i;
 	}
@@ -55,6 +90,310 @@ void Params::setparams(char *config_file) {
 	return;
 }
 
+/**
+ * FUNCTION NAME: setDefaults
+ *
+ * DESCRIPTION: Sets the parameters that do not depend on the node count to
+ *              their defaults
+ */
+void Params::setDefaults() {
+	MSG_DROP_PROB = 0;
+	LINK_DELAY_MODEL = DELAY_FIXED;
+	LINK_DELAY_MIN = 0;
+	LINK_DELAY_MAX = 0;
+	EGRESS_BYTES_PER_TICK = 0;
+	EGRESS_POLICY = EGRESS_QUEUE;
+	TRANSPORT = TRANSPORT_EMULNET;
+	UDP_BASE_PORT = Config::udpBasePort;
+	SHM_RING_BYTES = Config::shmRingBytes;
+	SHM_PREFIX = Config::shmPrefix;
+	// One process hosts every node unless the test file splits them.
+	FIRST_NODE_ID = 1;
+	LOCAL_NODES = 0;
+	TICK_USEC = 0;
+	CAPTURE_FILE.clear();
+	CHECKPOINT_FILE.clear();
+	CHECKPOINT_TIME = -1;
+	RESUME_FILE.clear();
+	COALESCE = false;
+	SEED = 0;
+	THREADS = 1;
+	TOTAL_RUNNING_TIME = Config::totalRunningTime;
+	// YCSB workload A (half reads, half updates) on zipfian keys.
+	WORKLOAD_RECORDS = Config::numInserts;
+	WORKLOAD_OPERATIONS = 1000;
+	WORKLOAD_OPS_PER_TICK = 10;
+	WORKLOAD_ARRIVALS = ARRIVALS_CONSTANT;
+	WORKLOAD_READ_PROPORTION = 0.5;
+	WORKLOAD_UPDATE_PROPORTION = 0.5;
+	WORKLOAD_INSERT_PROPORTION = 0;
+	WORKLOAD_DELETE_PROPORTION = 0;
+	WORKLOAD_KEY_DISTRIBUTION = KEYS_ZIPFIAN;
+	WORKLOAD_ZIPF_THETA = 0.99;
+	WORKLOAD_VALUE_SIZES = SIZES_FIXED;
+	WORKLOAD_VALUE_MIN = 100;
+	WORKLOAD_VALUE_MAX = 100;
+}
+
+/**
+ * FUNCTION NAME: setNodeCount
+ *
+ * DESCRIPTION: Sets the number of peers to `numNodes`, along with the
+ *              defaults that grow with it
+ */
+void Params::setNodeCount(int numNodes) {
+	NUM_PEERS = numNodes;
+	// Large runs get room for their gossip and its traffic.
+	MAX_MSG_SIZE = std::max((int)Config::maxMsgSize,
+	                        Config::msgBytesPerNode * NUM_PEERS);
+	EN_MEMORY_CAP = std::max((size_t)Config::enMemoryCap,
+	                         Config::enMemoryPerNode * NUM_PEERS);
+}
+
+/**
+ * FUNCTION NAME: setOptionalParam
+ *
+ * DESCRIPTION: Sets the optional parameter `key` from its string `value`.
+ *              Unknown keys are reported and ignored.
+ */
+void Params::setOptionalParam(const char *key, const char *value)
+{
+	if (0 == strcmp(key, "MSG_DROP_PROB"))
+	{
+		MSG_DROP_PROB = atof(value);
+	}
+	else if (0 == strcmp(key, "EN_MEMORY_CAP"))
+	{
+		EN_MEMORY_CAP = strtoul(value, NULL, 10);
+	}
+	else if (0 == strcmp(key, "LINK_DELAY_MODEL"))
+	{
+		if (0 == strcmp(value, "FIXED"))
+		{
+			LINK_DELAY_MODEL = DELAY_FIXED;
+		}
+		else if (0 == strcmp(value, "UNIFORM"))
+		{
+			LINK_DELAY_MODEL = DELAY_UNIFORM;
+		}
+		else if (0 == strcmp(value, "LONG_TAIL"))
+		{
+			LINK_DELAY_MODEL = DELAY_LONG_TAIL;
+		}
+		else
+		{
+			std::cout << "Ignoring unknown LINK_DELAY_MODEL " << value << std::endl;
+		}
+	}
+	else if (0 == strcmp(key, "LINK_DELAY_MIN"))
+	{
+		LINK_DELAY_MIN = atoi(value);
+	}
+	else if (0 == strcmp(key, "LINK_DELAY_MAX"))
+	{
+		LINK_DELAY_MAX = atoi(value);
+	}
+	else if (0 == strcmp(key, "EGRESS_BYTES_PER_TICK"))
+	{
+		EGRESS_BYTES_PER_TICK = strtoul(value, NULL, 10);
+	}
+	else if (0 == strcmp(key, "EGRESS_POLICY"))
+	{
+		if (0 == strcmp(value, "QUEUE"))
+		{
+			EGRESS_POLICY = EGRESS_QUEUE;
+		}
+		else if (0 == strcmp(value, "DROP"))
+		{
+			EGRESS_POLICY = EGRESS_DROP;
+		}
+		else
+		{
+			std::cout << "Ignoring unknown EGRESS_POLICY " << value << std::endl;
+		}
+	}
+	else if (0 == strcmp(key, "TRANSPORT"))
+	{
+		if (0 == strcmp(value, "EMULNET"))
+		{
+			TRANSPORT = TRANSPORT_EMULNET;
+		}
+		else if (0 == strcmp(value, "UDP"))
+		{
+			TRANSPORT = TRANSPORT_UDP;
+		}
+		else if (0 == strcmp(value, "SHM"))
+		{
+			TRANSPORT = TRANSPORT_SHM;
+		}
+		else
+		{
+			std::cout << "Ignoring unknown TRANSPORT " << value << std::endl;
+		}
+	}
+	else if (0 == strcmp(key, "UDP_BASE_PORT"))
+	{
+		UDP_BASE_PORT = atoi(value);
+	}
+	else if (0 == strcmp(key, "SHM_RING_BYTES"))
+	{
+		SHM_RING_BYTES = strtoul(value, NULL, 10);
+	}
+	else if (0 == strcmp(key, "SHM_PREFIX"))
+	{
+		SHM_PREFIX = value;
+	}
+	else if (0 == strcmp(key, "FIRST_NODE_ID"))
+	{
+		FIRST_NODE_ID = atoi(value);
+	}
+	else if (0 == strcmp(key, "LOCAL_NODES"))
+	{
+		LOCAL_NODES = atoi(value);
+	}
+	else if (0 == strcmp(key, "TICK_USEC"))
+	{
+		TICK_USEC = std::max(atoi(value), 0);
+	}
+	else if (0 == strcmp(key, "CAPTURE_FILE"))
+	{
+		CAPTURE_FILE = value;
+	}
+	else if (0 == strcmp(key, "CHECKPOINT_FILE"))
+	{
+		CHECKPOINT_FILE = value;
+	}
+	else if (0 == strcmp(key, "CHECKPOINT_TIME"))
+	{
+		CHECKPOINT_TIME = atoi(value);
+	}
+	else if (0 == strcmp(key, "RESUME_FILE"))
+	{
+		RESUME_FILE = value;
+	}
+	else if (0 == strcmp(key, "COALESCE"))
+	{
+		COALESCE = atoi(value) != 0;
+	}
+	else if (0 == strcmp(key, "SEED"))
+	{
+		SEED = strtoul(value, NULL, 10);
+	}
+	else if (0 == strcmp(key, "THREADS"))
+	{
+		THREADS = std::max(atoi(value), 1);
+	}
+	else if (0 == strcmp(key, "TOTAL_RUNNING_TIME"))
+	{
+		// Shorter runs would end before the tests.
+		TOTAL_RUNNING_TIME = std::max(atoi(value), (int)Config::totalRunningTime);
+	}
+	else if (0 == strcmp(key, "MAX_MSG_SIZE"))
+	{
+		MAX_MSG_SIZE = atoi(value);
+	}
+	else if (0 == strcmp(key, "WORKLOAD_RECORDS"))
+	{
+		WORKLOAD_RECORDS = atol(value);
+	}
+	else if (0 == strcmp(key, "WORKLOAD_OPERATIONS"))
+	{
+		WORKLOAD_OPERATIONS = atol(value);
+	}
+	else if (0 == strcmp(key, "WORKLOAD_OPS_PER_TICK"))
+	{
+		WORKLOAD_OPS_PER_TICK = atof(value);
+	}
+	else if (0 == strcmp(key, "WORKLOAD_ARRIVALS"))
+	{
+		if (0 == strcmp(value, "CONSTANT"))
+		{
+			WORKLOAD_ARRIVALS = ARRIVALS_CONSTANT;
+		}
+		else if (0 == strcmp(value, "POISSON"))
+		{
+			WORKLOAD_ARRIVALS = ARRIVALS_POISSON;
+		}
+		else
+		{
+			std::cout << "Ignoring unknown WORKLOAD_ARRIVALS " << value
+			          << std::endl;
+		}
+	}
+	else if (0 == strcmp(key, "WORKLOAD_READ_PROPORTION"))
+	{
+		WORKLOAD_READ_PROPORTION = atof(value);
+	}
+	else if (0 == strcmp(key, "WORKLOAD_UPDATE_PROPORTION"))
+	{
+		WORKLOAD_UPDATE_PROPORTION = atof(value);
+	}
+	else if (0 == strcmp(key, "WORKLOAD_INSERT_PROPORTION"))
+	{
+		WORKLOAD_INSERT_PROPORTION = atof(value);
+	}
+	else if (0 == strcmp(key, "WORKLOAD_DELETE_PROPORTION"))
+	{
+		WORKLOAD_DELETE_PROPORTION = atof(value);
+	}
+	else if (0 == strcmp(key, "WORKLOAD_KEY_DISTRIBUTION"))
+	{
+		if (0 == strcmp(value, "UNIFORM"))
+		{
+			WORKLOAD_KEY_DISTRIBUTION = KEYS_UNIFORM;
+		}
+		else if (0 == strcmp(value, "ZIPFIAN"))
+		{
+			WORKLOAD_KEY_DISTRIBUTION = KEYS_ZIPFIAN;
+		}
+		else if (0 == strcmp(value, "LATEST"))
+		{
+			WORKLOAD_KEY_DISTRIBUTION = KEYS_LATEST;
+		}
+		else
+		{
+			std::cout << "Ignoring unknown WORKLOAD_KEY_DISTRIBUTION " << value
+			          << std::endl;
+		}
+	}
+	else if (0 == strcmp(key, "WORKLOAD_ZIPF_THETA"))
+	{
+		WORKLOAD_ZIPF_THETA = atof(value);
+	}
+	else if (0 == strcmp(key, "WORKLOAD_VALUE_SIZES"))
+	{
+		if (0 == strcmp(value, "FIXED"))
+		{
+			WORKLOAD_VALUE_SIZES = SIZES_FIXED;
+		}
+		else if (0 == strcmp(value, "UNIFORM"))
+		{
+			WORKLOAD_VALUE_SIZES = SIZES_UNIFORM;
+		}
+		else if (0 == strcmp(value, "ZIPFIAN"))
+		{
+			WORKLOAD_VALUE_SIZES = SIZES_ZIPFIAN;
+		}
+		else
+		{
+			std::cout << "Ignoring unknown WORKLOAD_VALUE_SIZES " << value
+			          << std::endl;
+		}
+	}
+	else if (0 == strcmp(key, "WORKLOAD_VALUE_MIN"))
+	{
+		WORKLOAD_VALUE_MIN = std::max(atoi(value), 1);
+	}
+	else if (0 == strcmp(key, "WORKLOAD_VALUE_MAX"))
+	{
+		WORKLOAD_VALUE_MAX = atoi(value);
+	}
+	else
+	{
+		std::cout << "Ignoring unknown parameter " << key << std::endl;
+	}
+}
+
 /**
  * FUNCTION NAME: getcurrtime
  *
@@ -64,3 +403,18 @@ void Params::setparams(char *config_file) {
 int Params::getcurrtime() const {
     return globaltime;
 }
+
+/**
+ * FUNCTION NAME: outputPath
+ *
+ * DESCRIPTION: Returns where the run writes its file `name`: in outputDir,
+ *              unless `name` is an absolute path
+ */
+std::string Params::outputPath(const std::string& name) const
+{
+	if (outputDir.empty() || name.empty() || name[0] == '/')
+	{
+		return name;
+	}
+	return outputDir + "/" + name;
+}
@@ -8,6 +8,7 @@
 #define _PARAMS_H_
 
 #include "stdincludes.h"
+#include "Config.h"
 #include "Params.h"
 #include "Address.h"
 #include "Member.h"
@@ -17,7 +18,48 @@ enum TestType
 	CREATE_TEST,
 	READ_TEST,
 	UPDATE_TEST,
-	DELETE_TEST
+	DELETE_TEST,
+	WORKLOAD_TEST    // operations of a Workload instead of the CRUD tests
+};
+
+enum LinkDelayModel
+{
+	DELAY_FIXED,     // always LINK_DELAY_MIN ticks
+	DELAY_UNIFORM,   // uniform in [LINK_DELAY_MIN, LINK_DELAY_MAX]
+	DELAY_LONG_TAIL  // Pareto from LINK_DELAY_MIN, capped at LINK_DELAY_MAX
+};
+
+enum KeyDistribution
+{
+	KEYS_UNIFORM,    // every record equally likely
+	KEYS_ZIPFIAN,    // the first records the hottest
+	KEYS_LATEST      // the last inserted records the hottest
+};
+
+enum SizeDistribution
+{
+	SIZES_FIXED,     // always WORKLOAD_VALUE_MIN bytes
+	SIZES_UNIFORM,   // uniform in [WORKLOAD_VALUE_MIN, WORKLOAD_VALUE_MAX]
+	SIZES_ZIPFIAN    // zipfian from WORKLOAD_VALUE_MIN, short values hottest
+};
+
+enum ArrivalProcess
+{
+	ARRIVALS_CONSTANT, // WORKLOAD_OPS_PER_TICK in every tick, on average
+	ARRIVALS_POISSON   // a Poisson process of rate WORKLOAD_OPS_PER_TICK
+};
+
+enum Transport
+{
+	TRANSPORT_EMULNET, // in-process emulated network
+	TRANSPORT_UDP,     // UDP sockets on 127.0.0.1, see UdpNet
+	TRANSPORT_SHM      // rings in shared memory, see ShmNet
+};
+
+enum EgressPolicy
+{
+	EGRESS_QUEUE,    // traffic over the cap leaves in a later tick
+	EGRESS_DROP      // traffic over the cap is dropped
 };
 
 /**
@@ -31,13 +73,55 @@ public:
 	double STEP_RATE;		                   // dictates the rate of insertion
 	int NUM_PEERS;			                   // actual number of peers
 	int MAX_MSG_SIZE;
+	double MSG_DROP_PROB;                  // probability a message is dropped
+	size_t EN_MEMORY_CAP;                  // max bytes in flight in EmulNet
+	LinkDelayModel LINK_DELAY_MODEL;       // delay distribution of every link
+	int LINK_DELAY_MIN;                    // in ticks
+	int LINK_DELAY_MAX;                    // in ticks
+	size_t EGRESS_BYTES_PER_TICK;          // per node send cap, 0 for none
+	EgressPolicy EGRESS_POLICY;            // what to do above the cap
+	Transport TRANSPORT;                   // network carrying the messages
+	int UDP_BASE_PORT;                     // first port of TRANSPORT_UDP
+	size_t SHM_RING_BYTES;                 // ring size of TRANSPORT_SHM
+	std::string SHM_PREFIX;                // ring names of TRANSPORT_SHM
+	int FIRST_NODE_ID;                     // first node id this process hosts
+	int LOCAL_NODES;                       // nodes this process hosts
+	int TICK_USEC;                         // wall clock per tick, 0 for none
+	std::string CAPTURE_FILE;              // trace of the traffic, if set
+	std::string CHECKPOINT_FILE;           // state saved at CHECKPOINT_TIME
+	int CHECKPOINT_TIME;                   // -1 for the tick before insertTime
+	std::string RESUME_FILE;               // checkpoint the run starts from
+	bool COALESCE;                         // one envelope per link and tick
+	unsigned long SEED;                    // seed of every Random stream
+	int THREADS;                           // workers running every tick
+	int TOTAL_RUNNING_TIME;                // ticks in the run
+	long WORKLOAD_RECORDS;                 // records loaded by a Workload
+	long WORKLOAD_OPERATIONS;              // operations run after the load
+	double WORKLOAD_OPS_PER_TICK;          // client calls issued per tick
+	ArrivalProcess WORKLOAD_ARRIVALS;      // when the client calls go out
+	double WORKLOAD_READ_PROPORTION;       // share of the operations
+	double WORKLOAD_UPDATE_PROPORTION;     // share of the operations
+	double WORKLOAD_INSERT_PROPORTION;     // share of the operations
+	double WORKLOAD_DELETE_PROPORTION;     // share of the operations
+	KeyDistribution WORKLOAD_KEY_DISTRIBUTION;
+	double WORKLOAD_ZIPF_THETA;            // skew of the zipfian draws
+	SizeDistribution WORKLOAD_VALUE_SIZES; // distribution of value sizes
+	int WORKLOAD_VALUE_MIN;                // in bytes
+	int WORKLOAD_VALUE_MAX;                // in bytes
+	int insertTime;                        // tick the test pairs go in
+	int testTime;                          // tick the tests start
+	std::string outputDir;                 // of the logs, "" for the cwd
 	int globaltime;
-	int allNodesJoined;
+	size_t allNodesJoined;
 	short PORTNUM;
 	TestType testType;
 	Params();
-	void setparams(char *);
+	void setparams(const char *);
+	void setDefaults();
+	void setNodeCount(int numNodes);
+	void setOptionalParam(const char *key, const char *value);
 	int getcurrtime() const;
+	std::string outputPath(const std::string& name) const;
 };
 
 #endif /* _PARAMS_H_ */
@@ -13,6 +13,9 @@
  * CLASS NAME: q_elt
  *
  * DESCRIPTION: Entry in the queue
+ *
+ * `elt` points at a message body delivered by EmulNet. The consumer hands it
+ * back with EmulNet::ENrelease once the message has been handled.
  */
 class q_elt {
 public:
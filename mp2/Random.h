@@ -0,0 +1,82 @@
+/**********************************
+ * FILE NAME: Random.h
+ *
+ * DESCRIPTION: Header file of the seeded random number streams
+ **********************************/
+
+#ifndef RANDOM_H_
+#define RANDOM_H_
+
+#include "stdincludes.h"
+
+/**
+ * Users of random numbers. Each draws from streams of its own, so more
+ * draws in one of them do not change the numbers another one sees.
+ */
+enum RandomDomain
+{
+	RANDOM_NETWORK,    // drops and link delays, a stream per sender id
+	RANDOM_MEMBERSHIP, // gossip targets, a stream per node id
+	RANDOM_WORKLOAD    // test keys, values and failed nodes
+};
+
+/**
+ * CLASS NAME: Random
+ *
+ * DESCRIPTION: One stream of pseudo random numbers (xoshiro256**).
+ *
+ * A stream is named by the seed of the run (Params::SEED), a RandomDomain
+ * and an index such as a node id. The three are hashed with splitmix64 into
+ * the 256 bit state, so every name gives an unrelated stream and two runs
+ * with the same seed draw exactly the same numbers. A draw is a handful of
+ * shifts and multiplies on state owned by the stream: no system call, no
+ * lock and no global state.
+ *
+ * Random meets the UniformRandomBitGenerator requirements, so it can be
+ * handed to std::shuffle and the <random> distributions.
+ */
+class Random
+{
+private:
+	uint64_t s[4];
+
+	static uint64_t rotl(uint64_t x, int k)
+	{
+		return (x << k) | (x >> (64 - k));
+	}
+public:
+	typedef uint64_t result_type;
+
+	Random(uint64_t seed, RandomDomain domain, uint64_t index);
+
+	// Next 64 random bits
+	uint64_t next()
+	{
+		uint64_t result = rotl(s[1] * 5, 7) * 9;
+		uint64_t t = s[1] << 17;
+		s[2] ^= s[0];
+		s[3] ^= s[1];
+		s[1] ^= s[2];
+		s[0] ^= s[3];
+		s[2] ^= t;
+		s[3] = rotl(s[3], 45);
+		return result;
+	}
+	// Integer in [0, bound), by multiplying instead of dividing. The bias is
+	// at most bound / 2^32, far below anything a run can observe.
+	uint32_t below(uint32_t bound)
+	{
+		return (uint32_t)(((next() >> 32) * bound) >> 32);
+	}
+	// Double in [0, 1)
+	double uniform()
+	{
+		return (next() >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+	result_type operator()() { return next(); }
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return ~(result_type)0; }
+};
+
+#endif  // RANDOM_H_
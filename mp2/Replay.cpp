@@ -0,0 +1,188 @@
+/**********************************
+ * FILE NAME: Replay.cpp
+ *
+ * DESCRIPTION: Replays a traffic trace into a fresh cluster.
+ *              Build with `make replay` and run
+ *              `./Replay <test_file> <trace_file>`.
+ *
+ * The trace is recorded by running the Application with a CAPTURE_FILE in
+ * its test file. Replay builds the same nodes, then in every tick injects the
+ * messages the trace delivered in that tick and times the nodes receiving
+ * and handling them (MP1Node::recvLoop/checkMessages and
+ * MP2Node::recvLoop/checkMessages). Nothing else runs: the nodes are
+ * started but do not gossip, update their ring or issue requests, and
+ * whatever they send is discarded, so every run sees exactly the traffic of
+ * the trace.
+ **********************************/
+
+#include "stdincludes.h"
+#include "Config.h"
+#include "Params.h"
+#include "Log.h"
+#include "EmulNet.h"
+#include "Trace.h"
+#include "MP1Node.h"
+#include "MP2Node.h"
+#include <chrono>
+
+namespace {
+
+/**
+ * CLASS NAME: ReplayNet
+ *
+ * DESCRIPTION: EmulNet that only carries the messages injected from the
+ *              trace. Messages sent by the nodes are counted and discarded.
+ */
+class ReplayNet : public EmulNet
+{
+private:
+	unsigned long discarded[NUM_CHANNELS];
+public:
+	ReplayNet(std::shared_ptr<Params> p) : EmulNet(std::move(p)), discarded() {}
+
+	using EmulNet::ENsend;
+	using EmulNet::ENsendMany;
+	int ENsend(const Address& myaddr,
+	           const Address& toaddr,
+	           const char* data,
+	           int size,
+	           NetChannel channel) override
+	{
+		discarded[channel]++;
+		return size;
+	}
+	int ENsendMany(const Address& myaddr,
+	               const std::vector<Address>& toaddrs,
+	               const char* data,
+	               int size,
+	               NetChannel channel) override
+	{
+		discarded[channel] += toaddrs.size();
+		return (int)toaddrs.size();
+	}
+	// Sends the traced message `body` from `from` to `to` on `channel`
+	// through the emulated network, for delivery in the current tick.
+	void inject(const Address& from, const Address& to,
+	            const std::vector<char>& body, NetChannel channel)
+	{
+		EmulNet::ENsend(from, to, body.data(), (int)body.size(), channel);
+	}
+	unsigned long getDiscarded(NetChannel channel) const
+	{
+		return discarded[channel];
+	}
+};
+
+}  // namespace
+
+/**********************************
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: Replays the trace and prints the time spent by the nodes
+ *              handling it, per channel
+ **********************************/
+int main(int argc, char *argv[])
+{
+	if (argc != 3)
+	{
+		std::cout << "Incorrect Usage. Correct form: "
+		          << "./Replay <test_file> <trace_file>" << std::endl;
+		return FAILURE;
+	}
+
+	std::shared_ptr<Params> par = std::make_shared<Params>();
+	par->setparams(argv[1]);
+	// The trace holds delivery ticks, so the messages must arrive in the tick
+	// they are injected, none may be dropped and none may be recorded again.
+	par->MSG_DROP_PROB = 0;
+	par->LINK_DELAY_MODEL = DELAY_FIXED;
+	par->LINK_DELAY_MIN = 0;
+	par->LINK_DELAY_MAX = 0;
+	par->EGRESS_BYTES_PER_TICK = 0;
+	par->CAPTURE_FILE.clear();
+	std::shared_ptr<Log> log = std::make_shared<Log>(par, false);
+
+	std::shared_ptr<ReplayNet> net = std::make_shared<ReplayNet>(par);
+	net->setDeliveryMode(HANDOFF);
+
+	std::vector<std::unique_ptr<MP1Node>> mp1(par->NUM_PEERS);
+	std::vector<std::unique_ptr<MP2Node>> mp2(par->NUM_PEERS);
+	std::vector<Address> addrs(par->NUM_PEERS + 1);
+	for (int i = 0; i < par->NUM_PEERS; i++)
+	{
+		std::shared_ptr<Member> memberNode = std::make_shared<Member>();
+		memberNode->inited = false;
+		Address addr = net->ENinit();
+		mp1[i] = std::make_unique<MP1Node>(memberNode, *par, net, log, addr);
+		mp2[i] = std::make_unique<MP2Node>(memberNode, *par, net, log, addr);
+		addrs[i + 1] = addr;
+	}
+	// Start the nodes so their own state is set up. The join requests they
+	// send are discarded like the rest of their traffic.
+	char joinAddr[30] = "";
+	for (int i = 0; i < par->NUM_PEERS; i++)
+	{
+		mp1[i]->nodeStart(joinAddr, par->PORTNUM);
+	}
+
+	TraceReader trace(argv[2]);
+	TraceRecord record;
+	std::vector<char> body;
+	bool pending = trace.next(record, body);
+	unsigned long replayed[NUM_CHANNELS] = {};
+	unsigned long skipped = 0;
+	std::chrono::nanoseconds handleTime[NUM_CHANNELS] = {};
+
+	for (par->globaltime = 0; pending; par->globaltime++)
+	{
+		while (pending && record.tick == par->getcurrtime())
+		{
+			if (record.channel < 0 || record.channel >= NUM_CHANNELS ||
+			    record.from < 1 || record.from > par->NUM_PEERS ||
+			    record.to < 1 || record.to > par->NUM_PEERS)
+			{
+				skipped++;
+			}
+			else
+			{
+				net->inject(addrs[record.from], addrs[record.to], body,
+				            (NetChannel)record.channel);
+				replayed[record.channel]++;
+			}
+			pending = trace.next(record, body);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < par->NUM_PEERS; i++)
+		{
+			mp1[i]->recvLoop();
+			mp1[i]->checkMessages();
+		}
+		auto mp1Done = std::chrono::steady_clock::now();
+		for (int i = 0; i < par->NUM_PEERS; i++)
+		{
+			mp2[i]->recvLoop();
+			mp2[i]->checkMessages();
+		}
+		auto mp2Done = std::chrono::steady_clock::now();
+		handleTime[CHANNEL_MEMBERSHIP] += mp1Done - start;
+		handleTime[CHANNEL_KVSTORE] += mp2Done - mp1Done;
+
+		net->ENtick();
+	}
+
+	const char *names[NUM_CHANNELS] = {"membership", "kvstore"};
+	printf("Replayed %s over %d ticks, %lu records skipped\n",
+	       argv[2], par->getcurrtime(), skipped);
+	printf("%12s %12s %14s %12s %12s\n",
+	       "channel", "messages", "handle ns", "ns/msg", "discarded");
+	for (int c = 0; c < NUM_CHANNELS; c++)
+	{
+		printf("%12s %12lu %14lld %12.1f %12lu\n",
+		       names[c], replayed[c], (long long)handleTime[c].count(),
+		       replayed[c] ? (double)handleTime[c].count() / replayed[c] : 0.0,
+		       net->getDiscarded((NetChannel)c));
+	}
+
+	return SUCCESS;
+}
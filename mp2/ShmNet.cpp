@@ -0,0 +1,301 @@
+/**********************************
+ * FILE NAME: ShmNet.cpp
+ *
+ * DESCRIPTION: Definition of the shared memory ring transport
+ **********************************/
+
+#include "ShmNet.h"
+#include <sys/mman.h>
+#include <errno.h>
+
+/**
+ * Constructor
+ */
+ShmNet::ShmNet(std::shared_ptr<Params> p, std::string prefix, int firstId)
+	: InboxNet(std::move(p), firstId), prefix(std::move(prefix))
+{
+	// Round the ring up to a power of two so offsets can be masked.
+	ringBytes = 4096;
+	while (ringBytes < par->SHM_RING_BYTES)
+	{
+		ringBytes <<= 1;
+	}
+}
+
+/**
+ * Destructor
+ */
+ShmNet::~ShmNet()
+{
+	unmapRings();
+}
+
+/**
+ * FUNCTION NAME: ENinit
+ *
+ * DESCRIPTION: Creates the ring of the next node hosted by this process
+ */
+Address ShmNet::ENinit()
+{
+	Address myaddr = InboxNet::ENinit();
+	int id = *(int *)(myaddr.addr);
+	std::string name = ringName(id);
+
+	// An existing ring may belong to a live run with the same SHM_PREFIX,
+	// so it is never taken over.
+	int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd < 0 && errno == EEXIST)
+	{
+		throw std::runtime_error("ShmNet: " + name + " already exists. Another "
+		                         "run may be using SHM_PREFIX " + prefix +
+		                         "; if not, remove /dev/shm" + name);
+	}
+	if (fd < 0 || ftruncate(fd, mappedSize()) < 0)
+	{
+		throw std::runtime_error("ShmNet: cannot create " + name + ": " +
+		                         strerror(errno));
+	}
+	void *region = mmap(NULL, mappedSize(), PROT_READ | PROT_WRITE,
+	                    MAP_SHARED, fd, 0);
+	close(fd);
+	if (region == MAP_FAILED)
+	{
+		throw std::runtime_error("ShmNet: cannot map " + name + ": " +
+		                         strerror(errno));
+	}
+
+	// The object is zero filled, so every frame starts out FRAME_EMPTY.
+	RingHeader *ring = new (region) RingHeader;
+	ring->head.store(0, std::memory_order_relaxed);
+	ring->tail.store(0, std::memory_order_relaxed);
+	ring->capacity = ringBytes;
+
+	if (id >= (int)rings.size())
+	{
+		rings.resize(id + 1, nullptr);
+	}
+	rings[id] = ring;
+	return myaddr;
+}
+
+/**
+ * FUNCTION NAME: ENsend
+ *
+ * DESCRIPTION: Writes the message as one frame into the ring of `toaddr`
+ *
+ * RETURNS:
+ * size
+ */
+int ShmNet::ENsend(const Address& myaddr,
+                   const Address& toaddr,
+                   const char *data,
+                   int size,
+                   NetChannel channel)
+{
+	int src = *(int *)(myaddr.addr);
+	int dst = *(int *)(toaddr.addr);
+
+	if (!admitTo(dst, size))
+	{
+		return 0;
+	}
+	RingHeader *ring = ringOf(dst);
+	if (ring == nullptr)
+	{
+		// No node has created the ring of that id.
+		drop(DROP_BAD_ADDRESS);
+		return 0;
+	}
+
+	uint64_t frameBytes = frameBytesFor(size);
+	uint64_t mask = ring->capacity - 1;
+	uint64_t head = ring->head.load(std::memory_order_relaxed);
+	uint64_t padding;
+	do
+	{
+		uint64_t toEnd = ring->capacity - (head & mask);
+		padding = (frameBytes > toEnd) ? toEnd : 0;
+		uint64_t tail = ring->tail.load(std::memory_order_acquire);
+		if (head + padding + frameBytes - tail > ring->capacity)
+		{
+			drop(DROP_BUFFER_FULL);
+			return 0;
+		}
+	} while (!ring->head.compare_exchange_weak(
+		head, head + padding + frameBytes, std::memory_order_acq_rel));
+
+	char *frames = framesOf(ring);
+	if (padding > 0)
+	{
+		RingFrame *pad = (RingFrame *)(frames + (head & mask));
+		pad->size = (int32_t)(padding - sizeof(RingFrame));
+		pad->state.store(FRAME_PADDING, std::memory_order_release);
+		head += padding;
+	}
+	RingFrame *frame = (RingFrame *)(frames + (head & mask));
+	frame->size = size;
+	frame->from = src;
+	frame->channel = channel;
+	memcpy((char *)(frame + 1), data, size);
+	frame->state.store(FRAME_MESSAGE, std::memory_order_release);
+
+	msgCounts[channel].countSent(src, par->getcurrtime(), size);
+	return size;
+}
+
+/**
+ * FUNCTION NAME: ENcleanup
+ *
+ * DESCRIPTION: Removes the rings of the hosted nodes and writes the message
+ *              counts
+ */
+int ShmNet::ENcleanup()
+{
+	for (int id = 0; id < (int)rings.size(); id++)
+	{
+		if (isHosted(id))
+		{
+			shm_unlink(ringName(id).c_str());
+		}
+	}
+	unmapRings();
+	return InboxNet::ENcleanup();
+}
+
+/**
+ * FUNCTION NAME: collect
+ *
+ * DESCRIPTION: Moves the published frames of the ring of node id `id` to its
+ *              inbox
+ */
+void ShmNet::collect(int id)
+{
+	RingHeader *ring = rings[id];
+	if (ring == nullptr)
+	{
+		return;
+	}
+
+	char *frames = framesOf(ring);
+	uint64_t mask = ring->capacity - 1;
+	uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+	while (true)
+	{
+		RingFrame *frame = (RingFrame *)(frames + (tail & mask));
+		int32_t state = frame->state.load(std::memory_order_acquire);
+		if (state == FRAME_EMPTY)
+		{
+			break;
+		}
+		if (state == FRAME_MESSAGE)
+		{
+			receive(id, frame->from, (NetChannel)frame->channel,
+				        (char *)(frame + 1), frame->size);
+		}
+		uint64_t frameBytes = frameBytesFor(frame->size);
+		// Senders expect the room they reserve to be zero.
+		memset((char *)frame + sizeof(frame->state), 0,
+		       frameBytes - sizeof(frame->state));
+		frame->state.store(FRAME_EMPTY, std::memory_order_relaxed);
+		tail += frameBytes;
+	}
+	ring->tail.store(tail, std::memory_order_release);
+}
+
+/**
+ * FUNCTION NAME: ringName
+ *
+ * DESCRIPTION: Name of the shared memory object of node id `id`
+ */
+std::string ShmNet::ringName(int id) const
+{
+	return "/" + prefix + "-" + std::to_string(id);
+}
+
+/**
+ * FUNCTION NAME: mappedSize
+ *
+ * DESCRIPTION: Bytes of a ring, header included
+ */
+size_t ShmNet::mappedSize() const
+{
+	return sizeof(RingHeader) + ringBytes;
+}
+
+/**
+ * FUNCTION NAME: frameBytesFor
+ *
+ * DESCRIPTION: Bytes taken in the ring by a frame with a `size` byte body.
+ *              Frames are aligned to the size of their header, so the room
+ *              left before the end of the ring always fits a padding frame.
+ */
+uint64_t ShmNet::frameBytesFor(int size)
+{
+	const uint64_t align = sizeof(RingFrame);
+	return (sizeof(RingFrame) + size + align - 1) & ~(align - 1);
+}
+
+/**
+ * FUNCTION NAME: framesOf
+ *
+ * DESCRIPTION: Returns the first byte of the frames of `ring`
+ */
+char *ShmNet::framesOf(RingHeader *ring)
+{
+	return (char *)(ring + 1);
+}
+
+/**
+ * FUNCTION NAME: ringOf
+ *
+ * DESCRIPTION: Returns the ring of node id `id`, mapping it on first use, or
+ *              null if the node has not created it.
+ */
+ShmNet::RingHeader *ShmNet::ringOf(int id)
+{
+	if (id < 0)
+	{
+		return nullptr;
+	}
+	if (id < (int)rings.size() && rings[id] != nullptr)
+	{
+		return rings[id];
+	}
+
+	int fd = shm_open(ringName(id).c_str(), O_RDWR, 0);
+	if (fd < 0)
+	{
+		return nullptr;
+	}
+	void *region = mmap(NULL, mappedSize(), PROT_READ | PROT_WRITE,
+	                    MAP_SHARED, fd, 0);
+	close(fd);
+	if (region == MAP_FAILED)
+	{
+		return nullptr;
+	}
+
+	if (id >= (int)rings.size())
+	{
+		rings.resize(id + 1, nullptr);
+	}
+	rings[id] = (RingHeader *)region;
+	return rings[id];
+}
+
+/**
+ * FUNCTION NAME: unmapRings
+ *
+ * DESCRIPTION: Unmaps every ring mapped by this process
+ */
+void ShmNet::unmapRings()
+{
+	for (RingHeader *&ring : rings)
+	{
+		if (ring != nullptr)
+		{
+			munmap(ring, mappedSize());
+			ring = nullptr;
+		}
+	}
+}
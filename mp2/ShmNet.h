@@ -0,0 +1,88 @@
+/**********************************
+ * FILE NAME: ShmNet.h
+ *
+ * DESCRIPTION: Header file of the shared memory ring transport
+ **********************************/
+
+#ifndef SHM_NET_H_
+#define SHM_NET_H_
+
+#include "stdincludes.h"
+#include "InboxNet.h"
+#include <atomic>
+
+/**
+ * CLASS NAME: ShmNet
+ *
+ * DESCRIPTION: Carries the messages of the nodes through rings in shared
+ *              memory, for node processes running on the same host.
+ *
+ * Every node owns one ring, a POSIX shared memory object named
+ * "/<prefix>-<node id>" that its process creates in ENinit, which fails if the
+ * ring already exists. Any process can send to the node by mapping the ring,
+ * which it does once on the first send to that node. After that, sending and
+ * receiving are plain memory accesses with no system calls.
+ *
+ * The ring is multi producer, single consumer. A sender reserves room by
+ * moving `head` forward with a compare and swap, writes a frame (a
+ * RingFrame header followed by the body) and then publishes it by setting
+ * the frame's `state`. The receiving node reads the published frames in
+ * order from `tail`, zeroes them and moves `tail` forward, which gives the
+ * room back to the senders. A frame never wraps around the end of the ring;
+ * the room left before the end is filled with a padding frame instead. A
+ * message that does not fit in the ring is counted as DROP_BUFFER_FULL, and one
+ * to a node whose ring does not exist as DROP_BAD_ADDRESS.
+ */
+class ShmNet : public InboxNet
+{
+private:
+	struct RingHeader {
+		std::atomic<uint64_t> head; // bytes reserved by the senders
+		char headPad[56];
+		std::atomic<uint64_t> tail; // bytes consumed by the receiver
+		char tailPad[56];
+		uint64_t capacity;          // bytes of frames, a power of two
+	};
+	struct RingFrame {
+		std::atomic<int32_t> state; // FRAME_EMPTY, FRAME_MESSAGE or FRAME_PADDING
+		int32_t size;               // body bytes
+		int32_t from;               // sender id
+		int32_t channel;            // NetChannel of the message
+	};
+	enum FrameState
+	{
+		FRAME_EMPTY,
+		FRAME_MESSAGE,
+		FRAME_PADDING
+	};
+
+	std::string prefix;
+	size_t ringBytes;
+	// Rings mapped by this process, per node id; null if not mapped yet.
+	std::vector<RingHeader *> rings;
+
+	std::string ringName(int id) const;
+	size_t mappedSize() const;
+	RingHeader *ringOf(int id);
+	static uint64_t frameBytesFor(int size);
+	static char *framesOf(RingHeader *ring);
+	void unmapRings();
+
+protected:
+	void collect(int id) override;
+
+public:
+	ShmNet(std::shared_ptr<Params> p, std::string prefix, int firstId = 1);
+	virtual ~ShmNet();
+
+	using EmulNet::ENsend;
+	Address ENinit() override;
+	int ENsend(const Address& myaddr,
+	           const Address& toaddr,
+	           const char* data,
+	           int size,
+	           NetChannel channel) override;
+	int ENcleanup() override;
+};
+
+#endif  // SHM_NET_H_
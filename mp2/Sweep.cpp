@@ -0,0 +1,97 @@
+/**********************************
+ * FILE NAME: Sweep.cpp
+ *
+ * DESCRIPTION: Definition of the runner of several test files at once
+ **********************************/
+
+#include "Sweep.h"
+#include <atomic>
+#include <chrono>
+#include <sys/stat.h>
+
+/**
+ * Constructor. Every test file gets a directory in sweep/ named after it,
+ * with a suffix when two test files share a name.
+ */
+Sweep::Sweep(const std::vector<std::string>& testFiles, bool debugMode,
+             int jobs)
+	: debugMode(debugMode), jobs(std::max(jobs, 1))
+{
+	std::map<std::string, int> seen;
+	for (const std::string& testFile : testFiles)
+	{
+		std::string name = testFile.substr(testFile.find_last_of('/') + 1);
+		name = name.substr(0, name.find_last_of('.'));
+		int count = ++seen[name];
+		if (count > 1)
+		{
+			name += "-" + std::to_string(count);
+		}
+		runs.push_back(Run{testFile, "sweep/" + name, "", 0});
+	}
+}
+
+/**
+ * FUNCTION NAME: run
+ *
+ * DESCRIPTION: Runs every test file and prints to `out`, in the order of
+ *              the test files, how each run ended. Returns SUCCESS if they
+ *              all finished.
+ */
+int Sweep::run(std::ostream& out)
+{
+	mkdir("sweep", 0755);
+	std::atomic<size_t> next(0);
+	WorkerPool workers(std::min(jobs, std::max((int)runs.size(), 1)));
+	workers.run([&](int)
+	{
+		for (size_t i = next++; i < runs.size(); i = next++)
+		{
+			execute(runs[i]);
+		}
+	});
+
+	int status = SUCCESS;
+	for (const Run& run : runs)
+	{
+		out << run.testFile << ": ";
+		if (run.error.empty())
+		{
+			out << "finished";
+		}
+		else
+		{
+			out << "failed, " << run.error;
+			status = FAILURE;
+		}
+		out << " in " << run.wallMs << " ms, output in " << run.outputDir;
+		out << std::endl;
+	}
+	return status;
+}
+
+/**
+ * FUNCTION NAME: execute
+ *
+ * DESCRIPTION: Runs the Application of `run` to the end, or until it throws
+ */
+void Sweep::execute(Run& run)
+{
+	std::chrono::steady_clock::time_point start =
+		std::chrono::steady_clock::now();
+	mkdir(run.outputDir.c_str(), 0755);
+	std::ofstream stdoutLog(run.outputDir + "/stdout.log");
+	try
+	{
+		Application app(run.testFile.c_str(), debugMode, stdoutLog,
+		                run.outputDir);
+		app.run();
+	}
+	catch (const std::exception& e)
+	{
+		run.error = e.what();
+		stdoutLog << e.what() << std::endl;
+	}
+	run.wallMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - start).count();
+}
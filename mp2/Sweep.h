@@ -0,0 +1,48 @@
+/**********************************
+ * FILE NAME: Sweep.h
+ *
+ * DESCRIPTION: Header file of the runner of several test files at once
+ **********************************/
+
+#ifndef SWEEP_H_
+#define SWEEP_H_
+
+#include "stdincludes.h"
+#include "Application.h"
+#include "WorkerPool.h"
+
+/**
+ * CLASS NAME: Sweep
+ *
+ * DESCRIPTION: Runs an Application for each of several test files, as many
+ *              at once as there are workers, in one process.
+ *
+ * Every Application keeps its state to itself, so the runs are independent
+ * and each gives what it gives on its own. A run prints to stdout.log and
+ * writes its logs (dbg.log, stats.log, msgcount.log, a relative
+ * CAPTURE_FILE) to sweep/<test file name>/. Runs on TRANSPORT: UDP or SHM
+ * must be given UDP_BASE_PORTs or SHM_PREFIXes of their own.
+ */
+class Sweep
+{
+private:
+	struct Run
+	{
+		std::string testFile;
+		std::string outputDir;
+		// What stopped the run, empty if it finished
+		std::string error;
+		long wallMs;
+	};
+	std::vector<Run> runs;
+	bool debugMode;
+	int jobs;
+
+	void execute(Run& run);
+public:
+	Sweep(const std::vector<std::string>& testFiles, bool debugMode, int jobs);
+
+	int run(std::ostream& out);
+};
+
+#endif  // SWEEP_H_
@@ -0,0 +1,673 @@
+/**********************************
+ * FILE NAME: Test.cpp
+ *
+ * DESCRIPTION: Regression tests for the emulated network and the
+ *              transports. Build and run with `make test`, or run
+ *              `./Test <name>...` for some of them. The multi-process tests
+ *              start ./Application, so they run from the mp2 folder.
+ **********************************/
+
+#include "stdincludes.h"
+#include "Config.h"
+#include "Address.h"
+#include "Params.h"
+#include "EmulNet.h"
+#include "UdpNet.h"
+#include "ShmNet.h"
+#include "Log.h"
+#include "Node.h"
+#include "MP2Node.h"
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+namespace {
+
+// Directory the networks under test write their msgcount.log to.
+std::string outputDir;
+
+/**
+ * FUNCTION NAME: check
+ *
+ * DESCRIPTION: Throws, naming `what`, if `condition` does not hold.
+ */
+void check(bool condition, const std::string& what)
+{
+	if (!condition)
+	{
+		throw std::runtime_error("check failed: " + what);
+	}
+}
+
+/**
+ * FUNCTION NAME: testParams
+ *
+ * DESCRIPTION: Returns the parameters of a small cluster whose network only
+ *              drops what does not fit.
+ */
+std::shared_ptr<Params> testParams(int numNodes)
+{
+	std::shared_ptr<Params> par = std::make_shared<Params>();
+	par->MAX_NUM_NEIGHBOURS = numNodes;
+	par->NUM_PEERS = numNodes;
+	par->MAX_MSG_SIZE = 4000;
+	par->globaltime = 0;
+	par->outputDir = outputDir;
+	return par;
+}
+
+/**
+ * FUNCTION NAME: testCleanupLargeInlineMessage
+ *
+ * DESCRIPTION: Messages with an inline body too large for the pool's size
+ *              classes are malloc'ed blocks of their own. Cleaning up the
+ *              network while they are in flight, or copying them out on
+ *              receive, has to read the envelope before freeing it. Run
+ *              under valgrind or AddressSanitizer to see a read after free.
+ */
+void testCleanupLargeInlineMessage()
+{
+	const int size = 12 * 1024;
+	for (DeliveryMode mode : {COPY_ON_RECV, HANDOFF})
+	{
+		std::shared_ptr<Params> par = testParams(2);
+		par->MAX_MSG_SIZE = 2 * size;
+		EmulNet en(par);
+		en.setDeliveryMode(mode);
+		Address a = en.ENinit();
+		Address b = en.ENinit();
+
+		std::vector<char> body(size, 'x');
+		check(en.ENsend(a, b, body.data(), size, CHANNEL_MEMBERSHIP) == size,
+		      "large message is sent");
+
+		if (mode == COPY_ON_RECV)
+		{
+			std::vector<q_elt> received;
+			check(en.ENrecvBatch(b, received, CHANNEL_MEMBERSHIP) == 1,
+			      "large message is received");
+			check(received[0].size == size &&
+			      memcmp(received[0].elt, body.data(), size) == 0,
+			      "large message arrives intact");
+			en.ENtick();
+			check(en.ENsend(a, b, body.data(), size, CHANNEL_MEMBERSHIP) == size,
+			      "second large message is sent");
+		}
+		en.ENcleanup();
+
+		const PoolStats& stats = en.getPoolStats();
+		check(stats.allocations == stats.releases,
+		      "every pooled buffer is released once");
+	}
+}
+
+/**
+ * FUNCTION NAME: testCoalesce
+ *
+ * DESCRIPTION: With COALESCE, a lone message on a link travels in a single
+ *              plain envelope, and the messages of a busy link arrive whole
+ *              and in order, however many the envelope had to grow for.
+ */
+void testCoalesce()
+{
+	for (DeliveryMode mode : {COPY_ON_RECV, HANDOFF})
+	{
+		std::shared_ptr<Params> par = testParams(3);
+		par->COALESCE = true;
+		EmulNet en(par);
+		en.setDeliveryMode(mode);
+		Address a = en.ENinit();
+		Address b = en.ENinit();
+		Address c = en.ENinit();
+
+		char lone[40];
+		memset(lone, 'l', sizeof(lone));
+		unsigned long before = en.getPoolStats().allocations;
+		check(en.ENsend(a, b, lone, sizeof(lone), CHANNEL_MEMBERSHIP) ==
+		      (int)sizeof(lone), "lone message is sent");
+		check(en.getPoolStats().allocations == before + 1,
+		      "a lone message takes a single envelope");
+
+		const int count = 50;
+		std::vector<std::string> bodies;
+		for (int i = 0; i < count; i++)
+		{
+			bodies.emplace_back(1 + i * 37 % 300, 'a' + i % 26);
+			check(en.ENsend(a, c, bodies[i], CHANNEL_MEMBERSHIP) ==
+			      (int)bodies[i].size(), "busy link message is sent");
+		}
+
+		std::vector<q_elt> received;
+		check(en.ENrecvBatch(b, received, CHANNEL_MEMBERSHIP) == 1 &&
+		      received[0].size == (int)sizeof(lone) &&
+		      memcmp(received[0].elt, lone, sizeof(lone)) == 0,
+		      "lone message arrives intact");
+		check(en.ENrecvBatch(c, received, CHANNEL_MEMBERSHIP) == count,
+		      "every busy link message arrives");
+		for (int i = 0; i < count; i++)
+		{
+			const q_elt& msg = received[i + 1];
+			check(msg.size == (int)bodies[i].size() &&
+			      memcmp(msg.elt, bodies[i].data(), msg.size) == 0,
+			      "busy link messages arrive intact and in order");
+		}
+		for (const q_elt& msg : received)
+		{
+			en.ENrelease((char *)msg.elt);
+		}
+		en.ENtick();
+
+		const PoolStats& stats = en.getPoolStats();
+		check(stats.allocations == stats.releases,
+		      "every pooled buffer is released once");
+		en.ENcleanup();
+	}
+}
+
+/**
+ * FUNCTION NAME: testMulticast
+ *
+ * DESCRIPTION: A multicast takes a single pooled buffer however many
+ *              destinations it has, and its body is counted in flight once,
+ *              so a fanout that fits the memory cap once is not dropped.
+ */
+void testMulticast()
+{
+	for (DeliveryMode mode : {COPY_ON_RECV, HANDOFF})
+	{
+		const int fanout = 50;
+		const int size = 1000;
+		std::shared_ptr<Params> par = testParams(fanout + 1);
+		par->EN_MEMORY_CAP = fanout * sizeof(en_msg) + 2 * size;
+		EmulNet en(par);
+		en.setDeliveryMode(mode);
+		Address a = en.ENinit();
+		std::vector<Address> to;
+		for (int i = 0; i < fanout; i++)
+		{
+			to.push_back(en.ENinit());
+		}
+
+		std::string body(size, 'm');
+		unsigned long before = en.getPoolStats().allocations;
+		check(en.ENsendMany(a, to, body, CHANNEL_MEMBERSHIP) == fanout,
+		      "every destination of the multicast is sent to");
+		check(en.getPoolStats().allocations == before + 1,
+		      "a multicast takes a single buffer");
+		check(en.getInFlightBytes() == fanout * sizeof(en_msg) + size,
+		      "the body of a multicast is counted once");
+
+		std::vector<q_elt> received;
+		for (const Address& b : to)
+		{
+			check(en.ENrecvBatch(b, received, CHANNEL_MEMBERSHIP) == 1,
+			      "every destination receives the multicast");
+		}
+		for (const q_elt& msg : received)
+		{
+			check(msg.size == size && memcmp(msg.elt, body.data(), size) == 0,
+			      "the multicast arrives intact");
+			en.ENrelease((char *)msg.elt);
+		}
+		en.ENtick();
+
+		check(en.getInFlightBytes() == 0,
+		      "nothing is in flight once the multicast is received");
+		const PoolStats& stats = en.getPoolStats();
+		check(stats.allocations == stats.releases,
+		      "every pooled buffer is released once");
+		en.ENcleanup();
+	}
+}
+
+/**
+ * FUNCTION NAME: testBadDestination
+ *
+ * DESCRIPTION: Messages to an address whose id is not one of the nodes, such
+ *              as a zeroed one, are dropped instead of reaching a mailbox.
+ *              A send recorded on a lane reports these drops, and oversize
+ *              ones, as a send on the main thread does.
+ */
+void testBadDestination()
+{
+	for (bool onLane : {false, true})
+	{
+		std::shared_ptr<Params> par = testParams(2);
+		EmulNet en(par);
+		Address a = en.ENinit();
+		Address b = en.ENinit();
+		if (onLane)
+		{
+			en.setDeliveryMode(HANDOFF);
+			en.setLanes(1);
+			WorkerPool::setLane(0);
+		}
+
+		Address zeroed;
+		memset(zeroed.addr, 0, sizeof(zeroed.addr));
+		Address negative = zeroed;
+		*(int *)(negative.addr) = -7;
+		Address beyond = zeroed;
+		*(int *)(beyond.addr) = par->NUM_PEERS + 1;
+
+		char body[16] = {};
+		for (const Address& bad : {zeroed, negative, beyond})
+		{
+			check(en.ENsend(a, bad, body, sizeof(body), CHANNEL_MEMBERSHIP) == 0,
+			      "a message to a bad address is not sent");
+		}
+		check(en.ENsendMany(a, {negative, b}, body, sizeof(body),
+		                    CHANNEL_MEMBERSHIP) == 1,
+		      "only the good destination of a multicast is sent to");
+		std::string oversize(par->MAX_MSG_SIZE, 'o');
+		check(en.ENsend(a, b, oversize, CHANNEL_MEMBERSHIP) == 0,
+		      "an oversize message is not sent");
+
+		if (onLane)
+		{
+			WorkerPool::setLane(-1);
+			en.mergeLanes();
+		}
+		check(en.getDropCount(DROP_BAD_ADDRESS) == 4,
+		      "every bad destination counts as a drop");
+		check(en.getDropCount(DROP_OVERSIZE) == 1,
+		      "an oversize message counts as a drop");
+		en.ENcleanup();
+	}
+}
+
+/**
+ * FUNCTION NAME: testBackpressure
+ *
+ * DESCRIPTION: A sender holding more than its share of a network above the
+ *              high watermark is told to back off, until its messages are
+ *              delivered. The other senders are not.
+ */
+void testBackpressure()
+{
+	std::shared_ptr<Params> par = testParams(2);
+	par->EN_MEMORY_CAP = 16 * 1024;
+	EmulNet en(par);
+	en.setDeliveryMode(HANDOFF);
+	Address a = en.ENinit();
+	Address b = en.ENinit();
+
+	char body[512] = {};
+	while (!en.ENbackpressure(a) &&
+	       en.ENsend(a, b, body, sizeof(body), CHANNEL_MEMBERSHIP) > 0)
+	{
+	}
+	check(en.ENbackpressure(a), "the busy sender is pushed back");
+	check(!en.ENbackpressure(b), "the idle sender is not");
+
+	std::vector<q_elt> received;
+	en.ENrecvBatch(b, received, CHANNEL_MEMBERSHIP);
+	for (const q_elt& msg : received)
+	{
+		en.ENrelease((char *)msg.elt);
+	}
+	en.ENtick();
+	check(!en.ENbackpressure(a), "delivering the messages clears it");
+	en.ENcleanup();
+}
+
+/**
+ * FUNCTION NAME: testUdpOversizeMessage
+ *
+ * DESCRIPTION: A MAX_MSG_SIZE scaled for a large cluster can exceed what one
+ *              UDP datagram holds. Such messages have to be counted as
+ *              oversize, not as a full buffer.
+ */
+void testUdpOversizeMessage()
+{
+	std::shared_ptr<Params> par = testParams(2);
+	par->MAX_MSG_SIZE = 4 * Config::udpMaxPayload;
+	UdpNet en(par, 20000 + getpid() % 20000);
+	Address a = en.ENinit();
+	Address b = en.ENinit();
+
+	std::vector<char> body(2 * Config::udpMaxPayload, 'x');
+	check(en.ENsend(a, b, body.data(), (int)body.size(),
+	                CHANNEL_MEMBERSHIP) == 0, "oversize message is not sent");
+	check(en.getDropCount(DROP_OVERSIZE) == 1, "the drop counts as oversize");
+	check(en.getDropCount(DROP_BUFFER_FULL) == 0,
+	      "the drop does not count as a full buffer");
+
+	int size = Config::udpMaxPayload - (int)sizeof(int32_t);
+	check(en.ENsend(a, b, body.data(), size, CHANNEL_MEMBERSHIP) == size,
+	      "the largest datagram is sent");
+	std::vector<q_elt> received;
+	check(en.ENrecvBatch(b, received, CHANNEL_MEMBERSHIP) == 1 &&
+	      received[0].size == size, "the largest datagram is received whole");
+	en.ENrelease((char *)received[0].elt);
+	en.ENcleanup();
+}
+
+/**
+ * FUNCTION NAME: testTransportBadDestination
+ *
+ * DESCRIPTION: The transports that leave the emulated network drop messages
+ *              to an id that is not one of the nodes as EmulNet does,
+ *              rather than sending them to the port or ring the id maps to.
+ */
+void testTransportBadDestination()
+{
+	std::shared_ptr<Params> par = testParams(2);
+	std::string prefix = "mp2test-bad-" + std::to_string(getpid());
+	UdpNet udp(par, 20000 + getpid() % 20000);
+	ShmNet shm(par, prefix);
+	for (EmulNet *en : std::vector<EmulNet *>{&udp, &shm})
+	{
+		Address a = en->ENinit();
+		Address b = en->ENinit();
+
+		Address bad;
+		memset(bad.addr, 0, sizeof(bad.addr));
+		char body[16] = {};
+		for (int id : {0, -7, par->NUM_PEERS + 1})
+		{
+			*(int *)(bad.addr) = id;
+			check(en->ENsend(a, bad, body, sizeof(body), CHANNEL_MEMBERSHIP) == 0,
+			      "a message to a bad address is not sent");
+		}
+		check(en->ENsendMany(a, {bad, b}, body, sizeof(body),
+		                     CHANNEL_MEMBERSHIP) == 1,
+		      "only the good destination of a multicast is sent to");
+		check(en->getDropCount(DROP_BAD_ADDRESS) == 4,
+		      "every bad destination counts as a drop");
+		std::vector<q_elt> received;
+		check(en->ENrecvBatch(b, received, CHANNEL_MEMBERSHIP) == 1,
+		      "the good destination receives the multicast");
+		en->ENrelease((char *)received[0].elt);
+		en->ENcleanup();
+	}
+}
+
+/**
+ * FUNCTION NAME: testShmRingInUse
+ *
+ * DESCRIPTION: A second ShmNet with the prefix of a live one cannot take
+ *              over its rings, and a message to a node whose ring nobody
+ *              created counts as a bad address.
+ */
+void testShmRingInUse()
+{
+	std::shared_ptr<Params> par = testParams(3);
+	std::string prefix = "mp2test-inuse-" + std::to_string(getpid());
+	ShmNet live(par, prefix);
+	Address a = live.ENinit();
+	Address b = live.ENinit();
+
+	ShmNet other(par, prefix);
+	bool refused = false;
+	try
+	{
+		other.ENinit();
+	}
+	catch (const std::runtime_error&)
+	{
+		refused = true;
+	}
+	check(refused, "a ring in use is not taken over");
+
+	char body[16] = {};
+	Address missing = b;
+	*(int *)(missing.addr) = 3;
+	check(live.ENsend(a, missing, body, sizeof(body), CHANNEL_MEMBERSHIP) == 0,
+	      "a message to a node without a ring is not sent");
+	check(live.getDropCount(DROP_BAD_ADDRESS) == 1 &&
+	      live.getDropCount(DROP_BUFFER_FULL) == 0,
+	      "a missing ring counts as a bad address");
+	check(live.ENsend(a, b, body, sizeof(body), CHANNEL_MEMBERSHIP) ==
+	      (int)sizeof(body), "the live run still sends");
+	std::vector<q_elt> received;
+	check(live.ENrecvBatch(b, received, CHANNEL_MEMBERSHIP) == 1,
+	      "the live run still receives");
+	live.ENrelease((char *)received[0].elt);
+	live.ENcleanup();
+}
+
+/**
+ * FUNCTION NAME: countLines
+ *
+ * DESCRIPTION: Counts the lines of file `path` that contain `text`
+ */
+int countLines(const std::string& path, const std::string& text)
+{
+	std::ifstream file(path);
+	std::string line;
+	int count = 0;
+	while (std::getline(file, line))
+	{
+		if (line.find(text) != std::string::npos)
+		{
+			count++;
+		}
+	}
+	return count;
+}
+
+/**
+ * FUNCTION NAME: runProcesses
+ *
+ * DESCRIPTION: Runs the Application once per test file of `testFiles`, each
+ *              in a process of its own working in directory `dirs[k]`,
+ *              started a little after the one before. Returns once they
+ *              all exited, whether they all finished.
+ */
+bool runProcesses(const std::vector<std::string>& dirs,
+                  const std::vector<std::string>& testFiles)
+{
+	char application[PATH_MAX];
+	check(realpath("Application", application) != NULL,
+	      "the Application is built");
+
+	std::vector<pid_t> children;
+	for (size_t k = 0; k < testFiles.size(); k++)
+	{
+		mkdir(dirs[k].c_str(), 0755);
+		std::ofstream(dirs[k] + "/test.conf") << testFiles[k];
+		// The child would write out what is buffered again.
+		fflush(stdout);
+		pid_t pid = fork();
+		if (pid == 0)
+		{
+			if (chdir(dirs[k].c_str()) == 0 &&
+			    freopen("stdout.log", "w", stdout) != NULL)
+			{
+				execl(application, application, "test.conf", (char *)NULL);
+			}
+			_exit(127);
+		}
+		children.push_back(pid);
+		// The node with id 1 introduces the others, so it starts first.
+		usleep(100 * 1000);
+	}
+
+	bool finished = true;
+	for (pid_t pid : children)
+	{
+		int status;
+		finished = waitpid(pid, &status, 0) == pid && WIFEXITED(status) &&
+		           WEXITSTATUS(status) == 0 && finished;
+	}
+	return finished;
+}
+
+/**
+ * FUNCTION NAME: testTwoProcessCluster
+ *
+ * DESCRIPTION: Splits a cluster of 10 nodes over two processes talking over
+ *              `transport`. Every node has to see all 10 members, and the
+ *              keys created through the first process have to be stored
+ *              on replicas in both.
+ */
+void testTwoProcessCluster(const std::string& transport)
+{
+	std::string common =
+		"NODES: 10\n"
+		"CRUD_TEST: CREATE\n"
+		"SEED: 5\n"
+		"TRANSPORT: " + transport + "\n"
+		"UDP_BASE_PORT: " + std::to_string(20000 + getpid() % 20000) + "\n"
+		"SHM_PREFIX: mp2test-" + std::to_string(getpid()) + "\n"
+		"TICK_USEC: 2000\n";
+	std::vector<std::string> dirs = {
+		outputDir + "/" + transport + "-first",
+		outputDir + "/" + transport + "-second"};
+	check(runProcesses(dirs, {
+		      common + "FIRST_NODE_ID: 1\nLOCAL_NODES: 5\n",
+		      common + "FIRST_NODE_ID: 6\nLOCAL_NODES: 5\n"}),
+	      "both processes finish");
+
+	int stored = 0;
+	for (const std::string& dir : dirs)
+	{
+		// Every one of the 5 nodes logs the 10 members joining.
+		check(countLines(dir + "/dbg.log", " joined at time ") == 50,
+		      "the nodes in " + dir + " see every member");
+		int storedHere = countLines(dir + "/dbg.log", "server: create success");
+		check(storedHere > 0, "the nodes in " + dir + " store replicas");
+		stored += storedHere;
+	}
+	check(countLines(dirs[0] + "/dbg.log", "coordinator: create success") ==
+	      (int)Config::numInserts, "every key is created");
+	check(stored == Config::numReplicas * (int)Config::numInserts,
+	      "every key has all its replicas");
+}
+
+/**
+ * FUNCTION NAME: testTwoProcessUdp
+ *
+ * DESCRIPTION: testTwoProcessCluster over TRANSPORT: UDP
+ */
+void testTwoProcessUdp()
+{
+	testTwoProcessCluster("UDP");
+}
+
+/**
+ * FUNCTION NAME: testTwoProcessShm
+ *
+ * DESCRIPTION: testTwoProcessCluster over TRANSPORT: SHM
+ */
+void testTwoProcessShm()
+{
+	testTwoProcessCluster("SHM");
+}
+
+/**
+ * FUNCTION NAME: testStabilizationRing
+ *
+ * DESCRIPTION: The node first on the ring has predecessors that wrap around
+ *              its end, and on a ring of fewer than three nodes its own
+ *              neighbours wrap around to itself. Stabilizing such a node as
+ *              the ring changes has to find it on the ring.
+ */
+void testStabilizationRing()
+{
+	std::shared_ptr<Params> par = testParams(7);
+	std::shared_ptr<EmulNet> en = std::make_shared<EmulNet>(par);
+	std::vector<Node> ring;
+	for (int i = 0; i < par->NUM_PEERS; i++)
+	{
+		ring.emplace_back(en->ENinit());
+	}
+	sort(ring.begin(), ring.end());
+
+	std::shared_ptr<Member> member = std::make_shared<Member>();
+	std::shared_ptr<Log> log = std::make_shared<Log>(par, false);
+	MP2Node node(member, *par, en, log, ring[0].nodeAddress);
+	node.createKeyValue("key", "value", PRIMARY);
+
+	// Sets the members the node sees to `positions` of the ring.
+	auto setMembers = [&](const std::vector<int>& positions)
+	{
+		member->memberList.clear();
+		for (int pos : positions)
+		{
+			const Address& addr = ring[pos].nodeAddress;
+			member->memberList.emplace_back(*(int *)(addr.addr),
+			                                *(short *)(&addr.addr[4]));
+		}
+		member->memberListVersion++;
+		node.updateRing();
+	};
+	setMembers({0, 1, 2, 3, 4, 5, 6});
+	setMembers({0, 1, 2, 4, 5, 6});
+	setMembers({0, 1, 2});
+	setMembers({0, 1});
+	setMembers({0, 1, 2});
+	en->ENcleanup();
+}
+
+struct TestCase {
+	const char *name;
+	void (*run)();
+};
+
+const TestCase testCases[] = {
+	{"cleanup_large_inline_message", testCleanupLargeInlineMessage},
+	{"coalesce", testCoalesce},
+	{"multicast", testMulticast},
+	{"bad_destination", testBadDestination},
+	{"backpressure", testBackpressure},
+	{"udp_oversize_message", testUdpOversizeMessage},
+	{"transport_bad_destination", testTransportBadDestination},
+	{"shm_ring_in_use", testShmRingInUse},
+	{"stabilization_ring", testStabilizationRing},
+	{"two_process_udp", testTwoProcessUdp},
+	{"two_process_shm", testTwoProcessShm},
+};
+
+}  // namespace
+
+/**
+ * FUNCTION NAME: main
+ *
+ * DESCRIPTION: Runs the tests named on the command line, or all of them.
+ *              Exits with a failure if any test fails.
+ */
+int main(int argc, char *argv[])
+{
+	char dirTemplate[] = "/tmp/mp2-test-XXXXXX";
+	if (mkdtemp(dirTemplate) == NULL)
+	{
+		perror("mkdtemp");
+		return FAILURE;
+	}
+	outputDir = dirTemplate;
+
+	int failed = 0;
+	int ran = 0;
+	for (const TestCase& test : testCases)
+	{
+		bool selected = argc < 2;
+		for (int i = 1; i < argc; i++)
+		{
+			selected = selected || strcmp(argv[i], test.name) == 0;
+		}
+		if (!selected)
+		{
+			continue;
+		}
+		ran++;
+		try
+		{
+			test.run();
+			printf("PASS %s\n", test.name);
+		}
+		catch (const std::exception& e)
+		{
+			printf("FAIL %s: %s\n", test.name, e.what());
+			failed++;
+		}
+	}
+	printf("%d of %d tests passed\n", ran - failed, ran);
+	if (failed > 0)
+	{
+		printf("Output of the tests in %s\n", outputDir.c_str());
+		return FAILURE;
+	}
+	std::system(("rm -rf " + outputDir).c_str());
+	return SUCCESS;
+}
@@ -0,0 +1,136 @@
+/**********************************
+ * FILE NAME: Trace.cpp
+ *
+ * DESCRIPTION: Definition of the binary traffic traces
+ **********************************/
+
+#include "Trace.h"
+#include <errno.h>
+
+/**
+ * Constructor
+ */
+TraceWriter::TraceWriter(const std::string& path)
+	: buffer(Config::traceBufferBytes), used(0)
+{
+	file = fopen(path.c_str(), "wb");
+	if (file == NULL)
+	{
+		throw std::runtime_error("TraceWriter: cannot open " + path + ": " +
+		                         strerror(errno));
+	}
+	append(Config::traceMagic.data(), Config::traceMagic.size());
+}
+
+/**
+ * Destructor
+ */
+TraceWriter::~TraceWriter()
+{
+	flush();
+	fclose(file);
+}
+
+/**
+ * FUNCTION NAME: record
+ *
+ * DESCRIPTION: Appends the message `body` of `size` bytes, delivered to `to`
+ *              in tick `tick`
+ */
+void TraceWriter::record(int tick, int channel, int from, int to,
+                         const char *body, int size)
+{
+	TraceRecord header;
+	header.tick = tick;
+	header.channel = channel;
+	header.from = from;
+	header.to = to;
+	header.size = size;
+	append(&header, sizeof(header));
+	append(body, size);
+}
+
+/**
+ * FUNCTION NAME: flush
+ *
+ * DESCRIPTION: Writes the buffered records to the file
+ */
+void TraceWriter::flush()
+{
+	if (used > 0)
+	{
+		fwrite(buffer.data(), 1, used, file);
+		used = 0;
+	}
+	fflush(file);
+}
+
+/**
+ * FUNCTION NAME: append
+ *
+ * DESCRIPTION: Adds `size` bytes to the buffer, writing it out when full. A
+ *              chunk larger than the whole buffer is written directly.
+ */
+void TraceWriter::append(const void *data, size_t size)
+{
+	if (used + size > buffer.size())
+	{
+		fwrite(buffer.data(), 1, used, file);
+		used = 0;
+		if (size > buffer.size())
+		{
+			fwrite(data, 1, size, file);
+			return;
+		}
+	}
+	memcpy(buffer.data() + used, data, size);
+	used += size;
+}
+
+/**
+ * Constructor
+ */
+TraceReader::TraceReader(const std::string& path)
+{
+	file = fopen(path.c_str(), "rb");
+	if (file == NULL)
+	{
+		throw std::runtime_error("TraceReader: cannot open " + path + ": " +
+		                         strerror(errno));
+	}
+
+	std::string magic(Config::traceMagic.size(), '\0');
+	if (fread(&magic[0], 1, magic.size(), file) != magic.size() ||
+	    magic != Config::traceMagic)
+	{
+		fclose(file);
+		throw std::runtime_error("TraceReader: " + path + " is not a trace");
+	}
+}
+
+/**
+ * Destructor
+ */
+TraceReader::~TraceReader()
+{
+	fclose(file);
+}
+
+/**
+ * FUNCTION NAME: next
+ *
+ * DESCRIPTION: Reads the next record into `record` and its body into `body`
+ *
+ * RETURNS:
+ * false at the end of the trace
+ */
+bool TraceReader::next(TraceRecord& record, std::vector<char>& body)
+{
+	if (fread(&record, sizeof(record), 1, file) != 1)
+	{
+		return false;
+	}
+	body.resize(record.size);
+	return record.size == 0 ||
+	       fread(body.data(), record.size, 1, file) == 1;
+}
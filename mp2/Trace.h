@@ -0,0 +1,67 @@
+/**********************************
+ * FILE NAME: Trace.h
+ *
+ * DESCRIPTION: Header file of the binary traffic traces
+ **********************************/
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include "stdincludes.h"
+#include "Config.h"
+
+/**
+ * STRUCT NAME: TraceRecord
+ *
+ * DESCRIPTION: Header of one message in a trace, followed by its `size` byte
+ *              body.
+ *
+ * A trace file starts with Config::traceMagic and then holds one record per
+ * message delivered to a node, in the order they were delivered. All fields
+ * are in the byte order of the host that wrote the trace.
+ */
+struct TraceRecord {
+	int32_t tick;    // tick the message was delivered in
+	int32_t channel; // NetChannel that carried it (0 membership, 1 KV store)
+	int32_t from;    // sender id
+	int32_t to;      // receiver id
+	int32_t size;    // body bytes
+};
+
+/**
+ * CLASS NAME: TraceWriter
+ *
+ * DESCRIPTION: Appends records to a trace file. Records are gathered in a
+ *              buffer of Config::traceBufferBytes and written out a buffer at
+ *              a time, so recording costs a memcpy per message.
+ */
+class TraceWriter {
+private:
+	FILE *file;
+	std::vector<char> buffer;
+	size_t used;
+
+	void append(const void *data, size_t size);
+public:
+	TraceWriter(const std::string& path);
+	~TraceWriter();
+	void record(int tick, int channel, int from, int to,
+	            const char *body, int size);
+	void flush();
+};
+
+/**
+ * CLASS NAME: TraceReader
+ *
+ * DESCRIPTION: Reads the records of a trace file back in order.
+ */
+class TraceReader {
+private:
+	FILE *file;
+public:
+	TraceReader(const std::string& path);
+	~TraceReader();
+	bool next(TraceRecord& record, std::vector<char>& body);
+};
+
+#endif  // TRACE_H_
@@ -41,12 +41,78 @@ WriteTransactionState::WriteTransactionState(string k, int currTime)
   : TransactionState(k, currTime), value(""), type(TransactionType::T_DELETE),
  	  successCount(0), failureCount(0) {}
 
+/**
+ * FUNCTION NAME: save
+ *
+ * DESCRIPTION: Writes the key and start time to checkpoint `w`.
+ */
+void TransactionState::save(CheckpointWriter& w) const
+{
+	w.writeString(this->key);
+	w.write(this->startTime);
+}
+
+/**
+ * CONSTRUCTOR
+ *
+ * Used when a run resumes from a checkpoint
+ */
+WriteTransactionState::WriteTransactionState(CheckpointReader& r)
+  : TransactionState(r), value(r.readString()), type(r.read<TransactionType>()),
+ 	  successCount(r.read<short>()), failureCount(r.read<short>()) {}
+
+/**
+ * FUNCTION NAME: save
+ *
+ * DESCRIPTION: Writes the transaction to checkpoint `w`.
+ */
+void WriteTransactionState::save(CheckpointWriter& w) const
+{
+	TransactionState::save(w);
+	w.writeString(this->value);
+	w.write(this->type);
+	w.write(this->successCount);
+	w.write(this->failureCount);
+}
+
 /**
  * CONSTRUCTOR
  */
 ReadTransactionState::ReadTransactionState(std::string k, int currTime)
   : TransactionState(k, currTime) {}
 
+/**
+ * CONSTRUCTOR
+ *
+ * Used when a run resumes from a checkpoint
+ */
+ReadTransactionState::ReadTransactionState(CheckpointReader& r)
+  : TransactionState(r)
+{
+	for (size_t count = r.read<size_t>(); count > 0; count--)
+	{
+		std::string v = r.readString();
+		this->valueCounts[v] = r.read<int>();
+	}
+}
+
+/**
+ * FUNCTION NAME: save
+ *
+ * DESCRIPTION: Writes the transaction and the values seen so far to
+ *              checkpoint `w`.
+ */
+void ReadTransactionState::save(CheckpointWriter& w) const
+{
+	TransactionState::save(w);
+	w.write(this->valueCounts.size());
+	for (const auto& valueCount : this->valueCounts)
+	{
+		w.writeString(valueCount.first);
+		w.write(valueCount.second);
+	}
+}
+
 /**
  * FUNCTION NAME: recordReplicaValue
  *
@@ -10,6 +10,7 @@
 #define TRANSACTION_STATE_H_
 
 #include "stdincludes.h"
+#include "Checkpoint.h"
 
 // Transaction types
 enum TransactionType
@@ -34,9 +35,16 @@ protected:
 
 public:
   TransactionState(std::string k, int currTime): key(k), startTime(currTime) {}
+  // Reads the fields written by save from a checkpoint
+  TransactionState(CheckpointReader& r)
+    : key(r.readString()), startTime(r.read<int>()) {}
+  void save(CheckpointWriter& w) const;
 
   std::string getKey() { return this->key; }
+  int getStartTime() { return this->startTime; }
   bool hasTransactionExpired(int currTime);
+  // First tick at which the transaction has expired
+  int getExpiryTime() { return this->startTime + TransactionState::timeout + 1; }
 
   virtual bool allRepliesReceived() = 0;
 };
@@ -67,6 +75,9 @@ public:
 
   // For delete transactions
 	WriteTransactionState(std::string k, int currTime);
+	// Restored from a checkpoint
+	WriteTransactionState(CheckpointReader& r);
+	void save(CheckpointWriter& w) const;
 
 	std::string getValue() { return value; }
 	TransactionType getTransactionType() { return type; }
@@ -105,6 +116,9 @@ private:
 
 public:
 	ReadTransactionState(string k, int currTime);
+	// Restored from a checkpoint
+	ReadTransactionState(CheckpointReader& r);
+	void save(CheckpointWriter& w) const;
 
 	void recordReplicaValue(string v);
 
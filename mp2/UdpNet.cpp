@@ -0,0 +1,220 @@
+/**********************************
+ * FILE NAME: UdpNet.cpp
+ *
+ * DESCRIPTION: Definition of the loopback UDP transport
+ **********************************/
+
+#include "UdpNet.h"
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <errno.h>
+
+/**
+ * Constructor
+ */
+UdpNet::UdpNet(std::shared_ptr<Params> p, int basePort, int firstId)
+	: InboxNet(std::move(p), firstId), basePort(basePort),
+	  recvBuffer(Config::udpMaxPayload)
+{
+	epollFd = epoll_create1(0);
+	if (epollFd < 0)
+	{
+		throw std::runtime_error(std::string("UdpNet: epoll_create1: ") +
+		                         strerror(errno));
+	}
+}
+
+/**
+ * Destructor
+ */
+UdpNet::~UdpNet()
+{
+	closeSockets();
+}
+
+/**
+ * FUNCTION NAME: ENinit
+ *
+ * DESCRIPTION: Opens the socket of the next node hosted by this process
+ */
+Address UdpNet::ENinit()
+{
+	Address myaddr = InboxNet::ENinit();
+	int id = *(int *)(myaddr.addr);
+
+	int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+	struct sockaddr_in local;
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	local.sin_port = htons(portOf(id));
+	if (fd < 0 || bind(fd, (struct sockaddr *)&local, sizeof(local)) < 0)
+	{
+		int error = errno;
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+		throw std::runtime_error("UdpNet: cannot bind 127.0.0.1:" +
+		                         std::to_string(portOf(id)) + ": " +
+		                         strerror(error));
+	}
+
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.u32 = id;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+
+	if (id >= (int)sockets.size())
+	{
+		sockets.resize(id + 1, -1);
+	}
+	sockets[id] = fd;
+	events.resize(events.size() + 1);
+	return myaddr;
+}
+
+/**
+ * FUNCTION NAME: ENsend
+ *
+ * DESCRIPTION: Sends the message as one datagram from the socket of `myaddr`
+ *              to the port of `toaddr`. The datagram starts with the channel.
+ *
+ * RETURNS:
+ * size
+ */
+int UdpNet::ENsend(const Address& myaddr,
+                   const Address& toaddr,
+                   const char *data,
+                   int size,
+                   NetChannel channel)
+{
+	int src = *(int *)(myaddr.addr);
+	int dst = *(int *)(toaddr.addr);
+
+	if (!admitTo(dst, size))
+	{
+		return 0;
+	}
+	if (size + (int)sizeof(int32_t) > Config::udpMaxPayload)
+	{
+		drop(DROP_OVERSIZE);
+		return 0;
+	}
+	if (!isHosted(src))
+	{
+		// Only the nodes hosted by this process can send through it.
+		return 0;
+	}
+
+	struct sockaddr_in remote;
+	memset(&remote, 0, sizeof(remote));
+	remote.sin_family = AF_INET;
+	remote.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	remote.sin_port = htons(portOf(dst));
+	int32_t header = channel;
+	struct iovec parts[2];
+	parts[0].iov_base = &header;
+	parts[0].iov_len = sizeof(header);
+	parts[1].iov_base = (void *)data;
+	parts[1].iov_len = size;
+	struct msghdr datagram;
+	memset(&datagram, 0, sizeof(datagram));
+	datagram.msg_name = &remote;
+	datagram.msg_namelen = sizeof(remote);
+	datagram.msg_iov = parts;
+	datagram.msg_iovlen = 2;
+	if (sendmsg(sockets[src], &datagram, 0) < 0)
+	{
+		drop(errno == EMSGSIZE ? DROP_OVERSIZE : DROP_BUFFER_FULL);
+		return 0;
+	}
+
+	msgCounts[channel].countSent(src, par->getcurrtime(), size);
+	return size;
+}
+
+/**
+ * FUNCTION NAME: ENcleanup
+ *
+ * DESCRIPTION: Closes the sockets and writes the message counts
+ */
+int UdpNet::ENcleanup()
+{
+	closeSockets();
+	return InboxNet::ENcleanup();
+}
+
+/**
+ * FUNCTION NAME: collect
+ *
+ * DESCRIPTION: Moves the datagrams waiting on every hosted socket, not only
+ *              the one of node id `id`, to the inbox of its node, without
+ *              blocking.
+ */
+void UdpNet::collect(int id)
+{
+	if (events.empty())
+	{
+		return;
+	}
+	int ready = epoll_wait(epollFd, events.data(), (int)events.size(), 0);
+	for (int i = 0; i < ready; i++)
+	{
+		readSocket((int)events[i].data.u32);
+	}
+}
+
+/**
+ * FUNCTION NAME: readSocket
+ *
+ * DESCRIPTION: Reads the socket of node id `id` until it is empty
+ */
+void UdpNet::readSocket(int id)
+{
+	struct sockaddr_in remote;
+	while (true)
+	{
+		socklen_t remoteSize = sizeof(remote);
+		ssize_t size = recvfrom(sockets[id], recvBuffer.data(), recvBuffer.size(),
+		                        0, (struct sockaddr *)&remote, &remoteSize);
+		if (size < 0)
+		{
+			// EAGAIN once the socket is drained.
+			return;
+		}
+		if (size < (ssize_t)sizeof(int32_t))
+		{
+			continue;
+		}
+		receive(id, ntohs(remote.sin_port) - basePort,
+		        (NetChannel)*(int32_t *)recvBuffer.data(),
+		        recvBuffer.data() + sizeof(int32_t), (int)(size - sizeof(int32_t)));
+	}
+}
+
+/**
+ * FUNCTION NAME: closeSockets
+ *
+ * DESCRIPTION: Closes the sockets of the hosted nodes and the epoll instance
+ */
+void UdpNet::closeSockets()
+{
+	for (int& fd : sockets)
+	{
+		if (fd >= 0)
+		{
+			close(fd);
+			fd = -1;
+		}
+	}
+	if (epollFd >= 0)
+	{
+		close(epollFd);
+		epollFd = -1;
+	}
+	events.clear();
+}
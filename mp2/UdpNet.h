@@ -0,0 +1,64 @@
+/**********************************
+ * FILE NAME: UdpNet.h
+ *
+ * DESCRIPTION: Header file of the loopback UDP transport
+ **********************************/
+
+#ifndef UDP_NET_H_
+#define UDP_NET_H_
+
+#include "stdincludes.h"
+#include "InboxNet.h"
+#include <sys/epoll.h>
+
+/**
+ * CLASS NAME: UdpNet
+ *
+ * DESCRIPTION: Carries the messages of the nodes over non-blocking UDP
+ *              sockets on 127.0.0.1 instead of the emulated network.
+ *
+ * Node id `id` owns port basePort + id, so the id in the first 4 bytes of an
+ * Address is all that is needed to reach a node, whichever process hosts it.
+ * A process hosting the nodes with ids from `firstId` onwards creates its
+ * UdpNet with that `firstId` and calls ENinit once per node.
+ *
+ * Each datagram starts with the NetChannel of the message as a 4 byte
+ * integer, followed by the body.
+ *
+ * Received datagrams are collected with an epoll loop over the sockets of
+ * the hosted nodes. A message too large for one datagram, whatever
+ * MAX_MSG_SIZE allows, is counted as DROP_OVERSIZE; any other datagram the
+ * kernel refuses is counted as DROP_BUFFER_FULL.
+ */
+class UdpNet : public InboxNet
+{
+private:
+	int basePort;
+	int epollFd;
+	// Socket of every node id hosted by this process, -1 for the others.
+	std::vector<int> sockets;
+	std::vector<struct epoll_event> events;
+	std::vector<char> recvBuffer;
+
+	int portOf(int id) const { return basePort + id; }
+	void readSocket(int id);
+	void closeSockets();
+
+protected:
+	void collect(int id) override;
+
+public:
+	UdpNet(std::shared_ptr<Params> p, int basePort, int firstId = 1);
+	virtual ~UdpNet();
+
+	using EmulNet::ENsend;
+	Address ENinit() override;
+	int ENsend(const Address& myaddr,
+	           const Address& toaddr,
+	           const char* data,
+	           int size,
+	           NetChannel channel) override;
+	int ENcleanup() override;
+};
+
+#endif  // UDP_NET_H_
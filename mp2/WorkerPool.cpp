@@ -0,0 +1,132 @@
+/**********************************
+ * FILE NAME: WorkerPool.cpp
+ *
+ * DESCRIPTION: Definition of the worker threads running parallel ticks
+ **********************************/
+
+#include "WorkerPool.h"
+
+thread_local int WorkerPool::lane = -1;
+
+/**
+ * Constructor
+ */
+WorkerPool::WorkerPool(int numWorkers)
+	: generation(0), running(0), stopping(false),
+	  errors(std::max(numWorkers, 1))
+{
+	// Worker 0 is the thread calling run().
+	for (int worker = 1; worker < numWorkers; worker++)
+	{
+		threads.emplace_back(&WorkerPool::work, this, worker);
+	}
+}
+
+/**
+ * Destructor
+ */
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	started.notify_all();
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+/**
+ * FUNCTION NAME: run
+ *
+ * DESCRIPTION: Calls job(worker) on every worker and returns when all the
+ *              calls have returned
+ */
+void WorkerPool::run(const std::function<void(int)>& job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->job = job;
+		running = (int)threads.size();
+		generation++;
+	}
+	started.notify_all();
+
+	runJob(job, 0);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [this] { return running == 0; });
+	for (std::exception_ptr& error : errors)
+	{
+		if (error)
+		{
+			std::exception_ptr first = error;
+			std::fill(errors.begin(), errors.end(), nullptr);
+			std::rethrow_exception(first);
+		}
+	}
+}
+
+/**
+ * FUNCTION NAME: runJob
+ *
+ * DESCRIPTION: Calls job(worker), keeping what it throws for run()
+ */
+void WorkerPool::runJob(const std::function<void(int)>& job, int worker)
+{
+	try
+	{
+		job(worker);
+	}
+	catch (...)
+	{
+		errors[worker] = std::current_exception();
+	}
+	setLane(-1);
+}
+
+/**
+ * FUNCTION NAME: setLane
+ *
+ * DESCRIPTION: Sets the lane the calling thread records its work in, or
+ *              -1 to work directly
+ */
+void WorkerPool::setLane(int lane)
+{
+	WorkerPool::lane = lane;
+}
+
+/**
+ * FUNCTION NAME: work
+ *
+ * DESCRIPTION: Body of the thread of worker `worker`: runs every job handed
+ *              out by run() until the pool is destroyed
+ */
+void WorkerPool::work(int worker)
+{
+	unsigned long seen = 0;
+	while (true)
+	{
+		std::function<void(int)> current;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			started.wait(lock, [&] { return stopping || generation != seen; });
+			if (stopping)
+			{
+				return;
+			}
+			seen = generation;
+			current = job;
+		}
+
+		runJob(current, worker);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		if (--running == 0)
+		{
+			finished.notify_one();
+		}
+	}
+}
@@ -0,0 +1,67 @@
+/**********************************
+ * FILE NAME: WorkerPool.h
+ *
+ * DESCRIPTION: Header file of the worker threads running parallel ticks
+ **********************************/
+
+#ifndef WORKER_POOL_H_
+#define WORKER_POOL_H_
+
+#include "stdincludes.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+/**
+ * CLASS NAME: WorkerPool
+ *
+ * DESCRIPTION: A fixed set of threads that run one job at a time, each
+ *              worker on its own share of the work.
+ *
+ * run() hands the job to every worker, runs worker 0 on the calling thread
+ * and returns once all of them are done, so every call is a barrier. If a
+ * worker throws, run() rethrows the exception of the lowest such worker once
+ * all of them are done.
+ *
+ * Code shared by the workers, such as EmulNet and Log, must not be changed
+ * by several threads at once. Instead, a worker picks a lane with setLane()
+ * before touching it, and the shared code records what the worker asks of
+ * it in that lane. The main thread replays the lanes in lane order after
+ * the barrier (EmulNet::mergeLanes, Log::mergeLanes). The result depends
+ * only on the lane numbers, not on how the threads were scheduled.
+ */
+class WorkerPool
+{
+private:
+	std::vector<std::thread> threads;
+	std::function<void(int)> job;
+	std::mutex mutex;
+	std::condition_variable started;
+	std::condition_variable finished;
+	unsigned long generation;
+	int running;
+	bool stopping;
+	// What each worker threw in the current job, null if nothing
+	std::vector<std::exception_ptr> errors;
+
+	// Lane of the calling thread, -1 when it has none.
+	static thread_local int lane;
+
+	void work(int worker);
+	void runJob(const std::function<void(int)>& job, int worker);
+public:
+	WorkerPool(int numWorkers);
+	WorkerPool(const WorkerPool &anotherPool) = delete;
+	WorkerPool& operator =(const WorkerPool &anotherPool) = delete;
+	~WorkerPool();
+
+	int size() const { return (int)threads.size() + 1; }
+	void run(const std::function<void(int)>& job);
+
+	static int currentLane() { return lane; }
+	static void setLane(int lane);
+};
+
+#endif  // WORKER_POOL_H_
@@ -0,0 +1,309 @@
+/**********************************
+ * FILE NAME: Workload.cpp
+ *
+ * DESCRIPTION: Definition of the YCSB style workload generator
+ **********************************/
+
+#include "Workload.h"
+
+namespace {
+
+const char alphanum[] =
+"0123456789"
+"ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+"abcdefghijklmnopqrstuvwxyz";
+
+// Sum of 1 / i^theta for i in (from, to].
+double zeta(long from, long to, double theta)
+{
+	double sum = 0;
+	for (long i = from + 1; i <= to; i++)
+	{
+		sum += 1 / pow((double)i, theta);
+	}
+	return sum;
+}
+
+}  // namespace
+
+/**
+ * Constructor. theta must be in (0, 1); YCSB uses 0.99.
+ */
+ZipfianGenerator::ZipfianGenerator(long items, double theta)
+	: theta(theta), alpha(1 / (1 - theta)), zeta2(zeta(0, 2, theta)),
+	  items(0), zetan(0), eta(0)
+{
+	setItems(items);
+}
+
+/**
+ * FUNCTION NAME: setItems
+ *
+ * DESCRIPTION: Makes next() draw from [0, items). Growing is linear in the
+ *              new items only; shrinking starts over.
+ */
+void ZipfianGenerator::setItems(long items)
+{
+	if (items == this->items)
+	{
+		return;
+	}
+	if (items < this->items)
+	{
+		this->items = 0;
+		zetan = 0;
+	}
+	zetan += zeta(this->items, items, theta);
+	this->items = items;
+	eta = (1 - pow(2.0 / items, 1 - theta)) / (1 - zeta2 / zetan);
+}
+
+/**
+ * FUNCTION NAME: save
+ *
+ * DESCRIPTION: Writes the items drawn from and zeta(items) to checkpoint `w`
+ */
+void ZipfianGenerator::save(CheckpointWriter& w) const
+{
+	w.write(theta);
+	w.write(items);
+	w.write(zetan);
+	w.write(eta);
+}
+
+/**
+ * FUNCTION NAME: load
+ *
+ * DESCRIPTION: Reads the state written by save from checkpoint `r`. Under
+ *              another theta, zeta(items) is worked out again.
+ */
+void ZipfianGenerator::load(CheckpointReader& r)
+{
+	double savedTheta = r.read<double>();
+	long savedItems = r.read<long>();
+	double savedZetan = r.read<double>();
+	double savedEta = r.read<double>();
+	if (savedTheta == theta)
+	{
+		items = savedItems;
+		zetan = savedZetan;
+		eta = savedEta;
+	}
+	else
+	{
+		setItems(savedItems);
+	}
+}
+
+/**
+ * FUNCTION NAME: next
+ *
+ * DESCRIPTION: Draws the next integer from `rng`
+ */
+long ZipfianGenerator::next(Random& rng)
+{
+	double u = rng.uniform();
+	double uz = u * zetan;
+	if (uz < 1)
+	{
+		return 0;
+	}
+	if (uz < 1 + pow(0.5, theta))
+	{
+		return 1;
+	}
+	long item = (long)(items * pow(eta * u - eta + 1, alpha));
+	return std::min(item, items - 1);
+}
+
+/**
+ * Constructor
+ */
+Workload::Workload(const Params &par)
+	: par(par), rng(par.SEED, RANDOM_WORKLOAD, 1), records(0), operations(0),
+	  backlog(0),
+	  keyZipf(std::max(par.WORKLOAD_RECORDS, 1L), par.WORKLOAD_ZIPF_THETA),
+	  sizeZipf(par.WORKLOAD_VALUE_MAX - par.WORKLOAD_VALUE_MIN + 1,
+	           par.WORKLOAD_ZIPF_THETA)
+{
+	double proportions[NUM_WORKLOAD_OPS] = {
+		par.WORKLOAD_READ_PROPORTION, par.WORKLOAD_UPDATE_PROPORTION,
+		par.WORKLOAD_INSERT_PROPORTION, par.WORKLOAD_DELETE_PROPORTION};
+	double total = 0;
+	for (int type = 0; type < NUM_WORKLOAD_OPS; type++)
+	{
+		total += proportions[type];
+	}
+	double sum = 0;
+	for (int type = 0; type < NUM_WORKLOAD_OPS; type++)
+	{
+		sum += proportions[type];
+		// With no proportions at all, every operation is a read.
+		mix[type] = total > 0 ? sum / total : 1;
+		issued[type] = 0;
+	}
+}
+
+/**
+ * FUNCTION NAME: arrivals
+ *
+ * DESCRIPTION: Returns the number of operations arriving in the current
+ *              tick, to be called once per tick
+ */
+int Workload::arrivals()
+{
+	double rate = par.WORKLOAD_OPS_PER_TICK;
+	if (rate <= 0)
+	{
+		return 0;
+	}
+	int count = 0;
+	if (par.WORKLOAD_ARRIVALS == ARRIVALS_POISSON)
+	{
+		// Exponential gaps between arrivals, carried over from tick to tick.
+		while (backlog < 1)
+		{
+			count++;
+			backlog -= log(1 - rng.uniform()) / rate;
+		}
+		backlog -= 1;
+		return count;
+	}
+	backlog += rate;
+	count = (int)backlog;
+	backlog -= count;
+	return count;
+}
+
+/**
+ * FUNCTION NAME: next
+ *
+ * DESCRIPTION: Fills `op` with the next operation: a load insert while
+ *              loading(), a run operation after. Returns false once done().
+ */
+bool Workload::next(WorkloadOp& op)
+{
+	if (loading())
+	{
+		op.type = WORKLOAD_INSERT;
+		op.key = keyOf(records++);
+		op.value = nextValue();
+		return true;
+	}
+	if (done())
+	{
+		return false;
+	}
+
+	double u = rng.uniform();
+	int type = 0;
+	while (type < NUM_WORKLOAD_OPS - 1 && u >= mix[type])
+	{
+		type++;
+	}
+	// There is nothing to read yet before the first insert.
+	op.type = records == 0 ? WORKLOAD_INSERT : (WorkloadOpType)type;
+	op.key = keyOf(op.type == WORKLOAD_INSERT ? records++ : nextRecord());
+	if (op.type == WORKLOAD_INSERT || op.type == WORKLOAD_UPDATE)
+	{
+		op.value = nextValue();
+	}
+	else
+	{
+		op.value.clear();
+	}
+	issued[op.type]++;
+	operations++;
+	return true;
+}
+
+/**
+ * FUNCTION NAME: nextRecord
+ *
+ * DESCRIPTION: Draws an inserted record from the key distribution
+ */
+long Workload::nextRecord()
+{
+	switch (par.WORKLOAD_KEY_DISTRIBUTION)
+	{
+	case KEYS_ZIPFIAN:
+		keyZipf.setItems(records);
+		return keyZipf.next(rng);
+	case KEYS_LATEST:
+		keyZipf.setItems(records);
+		return records - 1 - keyZipf.next(rng);
+	case KEYS_UNIFORM:
+	default:
+		return (long)(rng.uniform() * records);
+	}
+}
+
+/**
+ * FUNCTION NAME: keyOf
+ *
+ * DESCRIPTION: Returns the key of record `record`
+ */
+std::string Workload::keyOf(long record) const
+{
+	return "user" + std::to_string(record);
+}
+
+/**
+ * FUNCTION NAME: nextValue
+ *
+ * DESCRIPTION: Draws a random value from the value size distribution
+ */
+std::string Workload::nextValue()
+{
+	int size = par.WORKLOAD_VALUE_MIN;
+	int range = par.WORKLOAD_VALUE_MAX - par.WORKLOAD_VALUE_MIN + 1;
+	if (par.WORKLOAD_VALUE_SIZES == SIZES_UNIFORM)
+	{
+		size += (int)rng.below(range);
+	}
+	else if (par.WORKLOAD_VALUE_SIZES == SIZES_ZIPFIAN)
+	{
+		size += (int)sizeZipf.next(rng);
+	}
+
+	std::string value(size, ' ');
+	int alphanumLen = sizeof(alphanum) - 1;
+	for (int i = 0; i < size; i++)
+	{
+		value[i] = alphanum[rng.below(alphanumLen)];
+	}
+	return value;
+}
+
+/**
+ * FUNCTION NAME: save
+ *
+ * DESCRIPTION: Writes how far the workload got to checkpoint `w`. The value
+ *              sizes follow from the parameters alone.
+ */
+void Workload::save(CheckpointWriter& w) const
+{
+	w.section("WKLD");
+	w.write(rng);
+	w.write(records);
+	w.write(operations);
+	w.write(backlog);
+	keyZipf.save(w);
+	w.write(issued);
+}
+
+/**
+ * FUNCTION NAME: load
+ *
+ * DESCRIPTION: Reads the state written by save from checkpoint `r`
+ */
+void Workload::load(CheckpointReader& r)
+{
+	r.section("WKLD");
+	r.read(rng);
+	r.read(records);
+	r.read(operations);
+	r.read(backlog);
+	keyZipf.load(r);
+	r.read(issued);
+}
@@ -0,0 +1,126 @@
+/**********************************
+ * FILE NAME: Workload.h
+ *
+ * DESCRIPTION: Header file of the YCSB style workload generator
+ **********************************/
+
+#ifndef WORKLOAD_H_
+#define WORKLOAD_H_
+
+#include "stdincludes.h"
+#include "Params.h"
+#include "Random.h"
+#include "Checkpoint.h"
+
+enum WorkloadOpType
+{
+	WORKLOAD_READ,
+	WORKLOAD_UPDATE,
+	WORKLOAD_INSERT,
+	WORKLOAD_DELETE,
+	NUM_WORKLOAD_OPS
+};
+
+/**
+ * STRUCT NAME: WorkloadOp
+ *
+ * DESCRIPTION: One client call of the workload. `value` is empty for reads
+ *              and deletes.
+ */
+struct WorkloadOp
+{
+	WorkloadOpType type;
+	std::string key;
+	std::string value;
+};
+
+/**
+ * CLASS NAME: ZipfianGenerator
+ *
+ * DESCRIPTION: Draws integers in [0, n), 0 the most likely, with the
+ *              probability of i proportional to 1 / (i + 1)^theta. This is
+ *              the method of Gray et al., "Quickly generating billion-record
+ *              synthetic databases", as used by YCSB: a draw is constant
+ *              time once zeta(n) is known.
+ *
+ * n can grow between draws (the latest distribution grows it with every
+ * insert); zeta(n) is then extended by the new terms only.
+ */
+class ZipfianGenerator
+{
+private:
+	double theta;
+	double alpha;
+	double zeta2;
+	long items;
+	double zetan;
+	double eta;
+public:
+	ZipfianGenerator(long items, double theta);
+
+	void setItems(long items);
+	long next(Random& rng);
+	void save(CheckpointWriter& w) const;
+	void load(CheckpointReader& r);
+};
+
+/**
+ * CLASS NAME: Workload
+ *
+ * DESCRIPTION: The operations of a CRUD_TEST: WORKLOAD run, in the style of
+ *              the Yahoo! Cloud Serving Benchmark.
+ *
+ * The load phase inserts records 0 to Params::WORKLOAD_RECORDS - 1. The run
+ * phase then draws Params::WORKLOAD_OPERATIONS operations from the read,
+ * update, insert and delete proportions. Inserts add the next record; the
+ * other operations pick an existing record from the key distribution:
+ *  - UNIFORM: every record equally likely,
+ *  - ZIPFIAN: the first records the hottest,
+ *  - LATEST: the last inserted records the hottest.
+ * The load is open loop: arrivals() says how many operations to issue in a
+ * tick from the rate alone, however many earlier ones are still pending.
+ *
+ * Deleted records stay in the key space, so later reads of them fail, as
+ * they would against a real store. Values are random alphanumeric strings
+ * whose sizes follow Params::WORKLOAD_VALUE_SIZES.
+ *
+ * All draws come from a stream of their own, so a workload is fixed by the
+ * seed of the run and its parameters.
+ *
+ * A checkpoint holds how far the workload got, not its parameters: a run
+ * resumed from it goes on with the operation mix and distributions of its
+ * own test file.
+ */
+class Workload
+{
+private:
+	const Params &par;
+	Random rng;
+	// Records inserted so far, loaded or not; record i has key "user<i>".
+	long records;
+	long operations;
+	// Operations due but not issued yet, below one with ARRIVALS_CONSTANT.
+	// With ARRIVALS_POISSON, the time left to the next arrival, in ticks.
+	double backlog;
+	ZipfianGenerator keyZipf;
+	ZipfianGenerator sizeZipf;
+	// Cumulative operation proportions, normalized to end at 1.
+	double mix[NUM_WORKLOAD_OPS];
+	long issued[NUM_WORKLOAD_OPS];
+
+	long nextRecord();
+	std::string keyOf(long record) const;
+	std::string nextValue();
+public:
+	Workload(const Params &par);
+
+	bool loading() const { return records < par.WORKLOAD_RECORDS; }
+	bool done() const { return !loading() && operations >= par.WORKLOAD_OPERATIONS; }
+	int arrivals();
+	bool next(WorkloadOp& op);
+	long getIssued(WorkloadOpType type) const { return issued[type]; }
+	void save(CheckpointWriter& w) const;
+	void load(CheckpointReader& r);
+};
+
+#endif  // WORKLOAD_H_
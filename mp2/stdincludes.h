@@ -18,6 +18,7 @@
  */
 #include <stdio.h>
 #include <math.h>
+#include <limits.h>
 #include <string.h>
 #include <stdlib.h>
 #include <assert.h>
@@ -27,6 +28,7 @@
 #include <fcntl.h>
 #include <execinfo.h>
 #include <signal.h>
+#include <sys/resource.h>
 #include <iostream>
 #include <vector>
 #include <map>
@@ -36,6 +38,8 @@
 #include <fstream>
 #include <unordered_map>
 #include <utility>
+#include <memory>
+#include <stdexcept>
 
 using namespace std;
 
@@ -0,0 +1,172 @@
+#!/bin/bash
+
+#################################################
+# FILE NAME: sweep.sh
+#
+# DESCRIPTION: Runs the mp1 and mp2 Applications over a grid of node
+#              counts, message drop probabilities and workloads, and writes
+#              one CSV row per run:
+#               - wall time and peak RSS of the run,
+#               - messages and payload bytes sent through the EmulNet,
+#               - failed nodes, the mean ticks from a failure to the first
+#                 node removing the failed node and the most ticks to the
+#                 last one, and the removals of nodes that had not failed,
+#               - for mp2, the KV calls that succeeded and failed and the
+#                 latency percentiles of those that succeeded, in ticks.
+#
+#              A workload is SINGLE or MULTI (mp1, one or several failures)
+#              or a mp2 CRUD_TEST: CREATE, READ, UPDATE, DELETE or WORKLOAD.
+#              Every run uses the same seed, so a sweep repeated on another
+#              build runs the same scenarios.
+#
+# RUN PROCEDURE:
+# $ ./sweep.sh [-n "<node counts>"] [-d "<drop probabilities>"]
+#              [-w "<workloads>"] [-s <seed>] [-t <timeout seconds>]
+#              [-o <csv file>]
+#################################################
+
+NODES="10 100 1000 5000"
+DROPS="0 0.1"
+WORKLOADS="SINGLE MULTI READ UPDATE WORKLOAD"
+SEED=1
+TIMEOUT=0
+OUTPUT=sweep.csv
+
+while getopts "n:d:w:s:t:o:" opt
+do
+	case $opt in
+		n) NODES=$OPTARG ;;
+		d) DROPS=$OPTARG ;;
+		w) WORKLOADS=$OPTARG ;;
+		s) SEED=$OPTARG ;;
+		t) TIMEOUT=$OPTARG ;;
+		o) OUTPUT=$OPTARG ;;
+		*) sed -n '/^# RUN PROCEDURE/,/^####/p' "$0"; exit 1 ;;
+	esac
+done
+
+ROOT=$(cd "$(dirname "$0")" && pwd)
+make -s -C "$ROOT/mp1" || exit 1
+make -s -C "$ROOT/mp2" || exit 1
+
+# Each run gets a directory of its own for its test file and logs.
+SCRATCH=$(mktemp -d)
+trap 'rm -rf "$SCRATCH"' EXIT
+
+# Sum of the sent messages and bytes over every node (and channel) in a
+# msgcount.log, as "<messages>,<bytes>"
+function message_totals () {
+	awk '$3 == "sent_total" { messages += $4 }
+	     $3 == "sent_bytes" { bytes += $4 }
+	     END { printf "%d,%d", messages, bytes }' "$1"
+}
+
+# Failure detection in a dbg.log, as "<failed>,<mean first>,<max last>,<false>"
+function detection () {
+	awk '/Node failed at time/ {
+	         # "time=100" or "time = 100"
+	         at = $NF
+	         sub(/.*=/, "", at)
+	         failedAt[$1] = at
+	     }
+	     / removed at time / {
+	         node = $4
+	         if (!(node in first) || $NF < first[node]) first[node] = $NF
+	         if ($NF > last[node]) last[node] = $NF
+	         removals[node]++
+	     }
+	     END {
+	         failed = 0; detected = 0; sum = 0; slowest = -1; wrong = 0
+	         for (node in failedAt) {
+	             failed++
+	             if (node in first) {
+	                 detected++
+	                 sum += first[node] - failedAt[node]
+	                 if (last[node] - failedAt[node] > slowest)
+	                     slowest = last[node] - failedAt[node]
+	             }
+	         }
+	         for (node in removals) {
+	             if (!(node in failedAt)) wrong += removals[node]
+	         }
+	         if (detected > 0)
+	             printf "%d,%.1f,%d,%d", failed, sum / detected, slowest, wrong
+	         else
+	             printf "%d,,,%d", failed, wrong
+	     }' "$1"
+}
+
+# KV call outcomes of the last phase reported by a mp2 run, as
+# "<succeeded>,<failed>,<p50>,<p99>,<p999>"
+function kv_latency () {
+	awk '/ phase from time / {
+	         succeeded = $6; failed = $9; p50 = ""; p99 = ""; p999 = ""
+	         for (i = 1; i < NF; i++) {
+	             if ($i == "p50") p50 = $(i + 1)
+	             if ($i == "p99") p99 = $(i + 1)
+	             if ($i == "p999") p999 = $(i + 1)
+	         }
+	     }
+	     END { printf "%s,%s,%s,%s,%s", succeeded, failed, p50, p99, p999 }' "$1"
+}
+
+echo "project,nodes,drop_prob,workload,seed,status,wall_ms,peak_rss_kb,messages,bytes,failed_nodes,detect_first_ticks,detect_last_ticks,false_removals,kv_succeeded,kv_failed,kv_p50_ticks,kv_p99_ticks,kv_p999_ticks" > "$OUTPUT"
+
+for nodes in $NODES
+do
+	for drop in $DROPS
+	do
+		dropping=$(awk -v p="$drop" 'BEGIN { print (p > 0) ? 1 : 0 }')
+		for workload in $WORKLOADS
+		do
+			dir="$SCRATCH/$nodes-$drop-$workload"
+			mkdir -p "$dir"
+			case $workload in
+				SINGLE|MULTI)
+					project=mp1
+					single=$([ "$workload" == "SINGLE" ] && echo 1 || echo 0)
+					printf "MAX_NNB: %d\nSINGLE_FAILURE: %d\nDROP_MSG: %d\nMSG_DROP_PROB: %s\nSEED: %d\n" \
+						"$nodes" "$single" "$dropping" "$drop" "$SEED" > "$dir/test.conf"
+					;;
+				*)
+					project=mp2
+					printf "NODES: %d\nCRUD_TEST: %s\nMSG_DROP_PROB: %s\nSEED: %d\n" \
+						"$nodes" "$workload" "$drop" "$SEED" > "$dir/test.conf"
+					;;
+			esac
+
+			echo "$project $workload: $nodes nodes, drop probability $drop"
+			start=$(date +%s%N)
+			if [ "$TIMEOUT" -gt 0 ]
+			then
+				(cd "$dir" && timeout "$TIMEOUT" "$ROOT/$project/Application" test.conf > stdout.log 2>&1)
+			else
+				(cd "$dir" && "$ROOT/$project/Application" test.conf > stdout.log 2>&1)
+			fi
+			code=$?
+			end=$(date +%s%N)
+			case $code in
+				0) status=ok ;;
+				124) status=timeout ;;
+				*) status=exit$code ;;
+			esac
+
+			wall=$(( (end - start) / 1000000 ))
+			rss=$(awk '/^Peak RSS:/ { print $3 }' "$dir/stdout.log")
+			totals=","; failures=",,,"; kv=",,,,"
+			if [ "$status" == "ok" ]
+			then
+				totals=$(message_totals "$dir/msgcount.log")
+				failures=$(detection "$dir/dbg.log")
+				if [ "$project" == "mp2" ]
+				then
+					kv=$(kv_latency "$dir/stdout.log")
+				fi
+			fi
+			echo "$project,$nodes,$drop,$workload,$SEED,$status,$wall,$rss,$totals,$failures,$kv" >> "$OUTPUT"
+			rm -rf "$dir"
+		done
+	done
+done
+
+echo "Results in $OUTPUT"